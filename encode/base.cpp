@@ -16,3 +16,428 @@
 
 #include "base.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using util::encode::detail::kernel;
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    using encode_t = size_t (*) (char*, const uint8_t*, size_t) noexcept;
+    using decode_t = size_t (*) (uint8_t*, const char*, size_t) noexcept;
+
+
+    //-------------------------------------------------------------------------
+    size_t encode_null (char*, const uint8_t*, size_t) noexcept { return 0; }
+    size_t decode_null (uint8_t*, const char*, size_t) noexcept { return 0; }
+
+
+#if defined(__x86_64__) || defined(__i386__)
+    ///////////////////////////////////////////////////////////////////////////
+    // base64 kernels, after Wojciech Muła's and Alfred Klomp's SSE/AVX2
+    // implementations.
+    //
+    // Each group of 3 bytes is shuffled into a 32 bit lane as [b1 b0 b2 b1],
+    // the four 6 bit indices are extracted with a pair of multiplies, then
+    // translated to ASCII by adding an offset looked up from the index range.
+
+    [[gnu::target("ssse3")]]
+    __m128i
+    b64_enc_ssse3 (__m128i in)
+    {
+        in = _mm_shuffle_epi8 (in, _mm_setr_epi8 (1,0,2,1, 4,3,5,4, 7,6,8,7, 10,9,11,10));
+
+        const __m128i t0 = _mm_and_si128 (in, _mm_set1_epi32 (0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16 (t0, _mm_set1_epi32 (0x04000040));
+        const __m128i t2 = _mm_and_si128 (in, _mm_set1_epi32 (0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16 (t2, _mm_set1_epi32 (0x01000010));
+        const __m128i indices = _mm_or_si128 (t1, t3);
+
+        // map each range of indices to a slot in the offset table:
+        //   [0,26) -> 13, [26,52) -> 0, [52,62) -> 1..10, 62 -> 11, 63 -> 12
+        __m128i slot = _mm_subs_epu8 (indices, _mm_set1_epi8 (51));
+        const __m128i lower = _mm_cmpgt_epi8 (_mm_set1_epi8 (26), indices);
+        slot = _mm_or_si128 (slot, _mm_and_si128 (lower, _mm_set1_epi8 (13)));
+
+        const __m128i offsets = _mm_setr_epi8 (
+            'a' - 26,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '+' - 62, '/' - 63, 'A', 0, 0
+        );
+
+        return _mm_add_epi8 (indices, _mm_shuffle_epi8 (offsets, slot));
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    __m256i
+    b64_enc_avx2 (__m256i in)
+    {
+        in = _mm256_shuffle_epi8 (in, _mm256_setr_epi8 (
+            1,0,2,1, 4,3,5,4, 7,6,8,7, 10,9,11,10,
+            1,0,2,1, 4,3,5,4, 7,6,8,7, 10,9,11,10
+        ));
+
+        const __m256i t0 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16 (t0, _mm256_set1_epi32 (0x04000040));
+        const __m256i t2 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16 (t2, _mm256_set1_epi32 (0x01000010));
+        const __m256i indices = _mm256_or_si256 (t1, t3);
+
+        __m256i slot = _mm256_subs_epu8 (indices, _mm256_set1_epi8 (51));
+        const __m256i lower = _mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), indices);
+        slot = _mm256_or_si256 (slot, _mm256_and_si256 (lower, _mm256_set1_epi8 (13)));
+
+        const __m256i offsets = _mm256_setr_epi8 (
+            'a' - 26,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '+' - 62, '/' - 63, 'A', 0, 0
+        );
+
+        return _mm256_add_epi8 (indices, _mm256_shuffle_epi8 (offsets, slot));
+    }
+
+
+    //-------------------------------------------------------------------------
+    // translates 16 symbols to their 6 bit values. returns false if any of
+    // the symbols are outside the alphabet (including padding).
+    [[gnu::target("ssse3")]]
+    bool
+    b64_dec_ssse3 (__m128i &val)
+    {
+        const __m128i lut_lo = _mm_setr_epi8 (
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+        );
+        const __m128i lut_hi = _mm_setr_epi8 (
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+        );
+        const __m128i lut_roll = _mm_setr_epi8 (
+            0, 16, 19, 4, -65, -65, -71, -71,
+            0,  0,  0, 0,   0,   0,   0,   0
+        );
+        const __m128i mask_2f = _mm_set1_epi8 (0x2f);
+
+        const __m128i hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (val, 4), mask_2f);
+        const __m128i lo_nibbles = _mm_and_si128 (val, mask_2f);
+        const __m128i hi = _mm_shuffle_epi8 (lut_hi, hi_nibbles);
+        const __m128i lo = _mm_shuffle_epi8 (lut_lo, lo_nibbles);
+
+        const __m128i invalid = _mm_cmpgt_epi8 (_mm_and_si128 (lo, hi), _mm_setzero_si128 ());
+        if (_mm_movemask_epi8 (invalid))
+            return false;
+
+        const __m128i eq_2f = _mm_cmpeq_epi8 (val, mask_2f);
+        const __m128i roll = _mm_shuffle_epi8 (lut_roll, _mm_add_epi8 (eq_2f, hi_nibbles));
+        val = _mm_add_epi8 (val, roll);
+
+        // pack the four 6 bit values of each lane into 3 bytes, then
+        // compact the bytes into the low 12 bytes of the register.
+        const __m128i merged = _mm_maddubs_epi16 (val, _mm_set1_epi32 (0x01400140));
+        val = _mm_madd_epi16 (merged, _mm_set1_epi32 (0x00011000));
+        val = _mm_shuffle_epi8 (val, _mm_setr_epi8 (2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1));
+
+        return true;
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    bool
+    b64_dec_avx2 (__m256i &val)
+    {
+        const __m256i lut_lo = _mm256_setr_epi8 (
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+        );
+        const __m256i lut_hi = _mm256_setr_epi8 (
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+        );
+        const __m256i lut_roll = _mm256_setr_epi8 (
+            0, 16, 19, 4, -65, -65, -71, -71,
+            0,  0,  0, 0,   0,   0,   0,   0,
+            0, 16, 19, 4, -65, -65, -71, -71,
+            0,  0,  0, 0,   0,   0,   0,   0
+        );
+        const __m256i mask_2f = _mm256_set1_epi8 (0x2f);
+
+        const __m256i hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (val, 4), mask_2f);
+        const __m256i lo_nibbles = _mm256_and_si256 (val, mask_2f);
+        const __m256i hi = _mm256_shuffle_epi8 (lut_hi, hi_nibbles);
+        const __m256i lo = _mm256_shuffle_epi8 (lut_lo, lo_nibbles);
+
+        if (!_mm256_testz_si256 (lo, hi))
+            return false;
+
+        const __m256i eq_2f = _mm256_cmpeq_epi8 (val, mask_2f);
+        const __m256i roll = _mm256_shuffle_epi8 (lut_roll, _mm256_add_epi8 (eq_2f, hi_nibbles));
+        val = _mm256_add_epi8 (val, roll);
+
+        const __m256i merged = _mm256_maddubs_epi16 (val, _mm256_set1_epi32 (0x01400140));
+        val = _mm256_madd_epi16 (merged, _mm256_set1_epi32 (0x00011000));
+        val = _mm256_shuffle_epi8 (val, _mm256_setr_epi8 (
+            2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1,
+            2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1
+        ));
+
+        // gather the 12 bytes from each lane into the low 24 bytes
+        val = _mm256_permutevar8x32_epi32 (val, _mm256_setr_epi32 (0,1,2,4,5,6,3,7));
+        return true;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    [[gnu::target("ssse3")]]
+    size_t
+    encode64_ssse3 (char *dst, const uint8_t *src, size_t len) noexcept
+    {
+        // each iteration loads 16 bytes but only consumes 12, so we stop
+        // short to avoid reading past the end of the input.
+        size_t done = 0;
+
+        for (; len - done >= 16; done += 12, dst += 16) {
+            const __m128i in = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst), b64_enc_ssse3 (in));
+        }
+
+        return done;
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    size_t
+    encode64_avx2 (char *dst, const uint8_t *src, size_t len) noexcept
+    {
+        size_t done = 0;
+
+        for (; len - done >= 28; done += 24, dst += 32) {
+            const __m128i lo = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+            const __m128i hi = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done + 12));
+            const __m256i in = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+
+            _mm256_storeu_si256 (reinterpret_cast<__m256i*> (dst), b64_enc_avx2 (in));
+        }
+
+        return done + encode64_ssse3 (dst, src + done, len - done);
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("ssse3")]]
+    size_t
+    decode64_ssse3 (uint8_t *dst, const char *src, size_t len) noexcept
+    {
+        size_t done = 0;
+
+        for (; len - done >= 16; done += 16, dst += 12) {
+            __m128i val = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+            if (!b64_dec_ssse3 (val))
+                break;
+
+            _mm_storel_epi64 (reinterpret_cast<__m128i*> (dst), val);
+            const uint32_t tail = _mm_cvtsi128_si32 (_mm_srli_si128 (val, 8));
+            std::copy_n (reinterpret_cast<const uint8_t*> (&tail), sizeof (tail), dst + 8);
+        }
+
+        return done;
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    size_t
+    decode64_avx2 (uint8_t *dst, const char *src, size_t len) noexcept
+    {
+        size_t done = 0;
+
+        for (; len - done >= 32; done += 32, dst += 24) {
+            __m256i val = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (src + done));
+            if (!b64_dec_avx2 (val))
+                return done + decode64_ssse3 (dst, src + done, len - done);
+
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst), _mm256_castsi256_si128 (val));
+            _mm_storel_epi64 (
+                reinterpret_cast<__m128i*> (dst + 16),
+                _mm256_extracti128_si256 (val, 1)
+            );
+        }
+
+        return done + decode64_ssse3 (dst, src + done, len - done);
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // base16 kernels. each nibble indexes the 16 symbol alphabet directly
+    // via a byte shuffle; decoding validates each symbol against the digit
+    // and upper case letter ranges before packing pairs of nibbles.
+    [[gnu::target("ssse3")]]
+    size_t
+    encode16_ssse3 (char *dst, const uint8_t *src, size_t len) noexcept
+    {
+        const __m128i lut = _mm_setr_epi8 (
+            '0', '1', '2', '3', '4', '5', '6', '7',
+            '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+        );
+        const __m128i mask = _mm_set1_epi8 (0x0f);
+
+        size_t done = 0;
+
+        for (; len - done >= 16; done += 16, dst += 32) {
+            const __m128i in = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+            const __m128i hi = _mm_shuffle_epi8 (lut, _mm_and_si128 (_mm_srli_epi16 (in, 4), mask));
+            const __m128i lo = _mm_shuffle_epi8 (lut, _mm_and_si128 (in, mask));
+
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst +  0), _mm_unpacklo_epi8 (hi, lo));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst + 16), _mm_unpackhi_epi8 (hi, lo));
+        }
+
+        return done;
+    }
+
+
+    //-------------------------------------------------------------------------
+    // translates 16 symbols to their nibble values. returns false if any of
+    // the symbols are outside the alphabet.
+    [[gnu::target("ssse3")]]
+    bool
+    b16_dec_ssse3 (__m128i &val)
+    {
+        const __m128i digit = _mm_sub_epi8 (val, _mm_set1_epi8 ('0'));
+        const __m128i alpha = _mm_sub_epi8 (val, _mm_set1_epi8 ('A'));
+
+        const __m128i is_digit = _mm_cmpeq_epi8 (_mm_min_epu8 (digit, _mm_set1_epi8 (9)), digit);
+        const __m128i is_alpha = _mm_cmpeq_epi8 (_mm_min_epu8 (alpha, _mm_set1_epi8 (5)), alpha);
+
+        if (_mm_movemask_epi8 (_mm_or_si128 (is_digit, is_alpha)) != 0xffff)
+            return false;
+
+        val = _mm_or_si128 (
+            _mm_and_si128 (is_digit, digit),
+            _mm_and_si128 (is_alpha, _mm_add_epi8 (alpha, _mm_set1_epi8 (10)))
+        );
+
+        return true;
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("ssse3")]]
+    size_t
+    decode16_ssse3 (uint8_t *dst, const char *src, size_t len) noexcept
+    {
+        // combines each (high, low) pair of nibbles into a 16 bit lane
+        const __m128i weights = _mm_set1_epi16 (0x0110);
+
+        size_t done = 0;
+
+        for (; len - done >= 32; done += 32, dst += 16) {
+            __m128i a = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done +  0));
+            __m128i b = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done + 16));
+
+            if (!b16_dec_ssse3 (a) || !b16_dec_ssse3 (b))
+                break;
+
+            const __m128i out = _mm_packus_epi16 (
+                _mm_maddubs_epi16 (a, weights),
+                _mm_maddubs_epi16 (b, weights)
+            );
+
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst), out);
+        }
+
+        return done;
+    }
+#endif
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    struct dispatch {
+        encode_t encode64 = encode_null;
+        decode_t decode64 = decode_null;
+        encode_t encode16 = encode_null;
+        decode_t decode16 = decode_null;
+    };
+
+
+    //-------------------------------------------------------------------------
+    dispatch
+    select_kernels (void)
+    {
+        dispatch res;
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init ();
+
+        if (__builtin_cpu_supports ("ssse3")) {
+            res.encode64 = encode64_ssse3;
+            res.decode64 = decode64_ssse3;
+            res.encode16 = encode16_ssse3;
+            res.decode16 = decode16_ssse3;
+        }
+
+        if (__builtin_cpu_supports ("avx2")) {
+            res.encode64 = encode64_avx2;
+            res.decode64 = decode64_avx2;
+        }
+#endif
+
+        return res;
+    }
+
+
+    //-------------------------------------------------------------------------
+    const dispatch&
+    kernels (void)
+    {
+        static const dispatch s_kernels = select_kernels ();
+        return s_kernels;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+size_t
+kernel<64>::encode (char *dst, const uint8_t *src, size_t len) noexcept
+{
+    return kernels ().encode64 (dst, src, len);
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+kernel<64>::decode (uint8_t *dst, const char *src, size_t len) noexcept
+{
+    return kernels ().decode64 (dst, src, len);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+size_t
+kernel<16>::encode (char *dst, const uint8_t *src, size_t len) noexcept
+{
+    return kernels ().encode16 (dst, src, len);
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+kernel<16>::decode (uint8_t *dst, const char *src, size_t len) noexcept
+{
+    return kernels ().decode16 (dst, src, len);
+}
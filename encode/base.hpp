@@ -21,8 +21,12 @@
 
 #include "../debug.hpp"
 
-#include <cstdint>
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 
 
 namespace util::encode {
@@ -36,7 +40,7 @@ namespace util::encode {
 
     ///////////////////////////////////////////////////////////////////////////
     template <>
-    const char alphabet<64>::enc[64] = {
+    inline const char alphabet<64>::enc[64] = {
         'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
         'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
         'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
@@ -47,7 +51,7 @@ namespace util::encode {
 
     //-------------------------------------------------------------------------
     template <>
-    const uint8_t alphabet<64>::dec[256] = {
+    inline const uint8_t alphabet<64>::dec[256] = {
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 0x3E,    0,    0,    0, 0x3F,
@@ -69,7 +73,7 @@ namespace util::encode {
 
     ///////////////////////////////////////////////////////////////////////////
     template <>
-    const char alphabet<32>::enc[32] {
+    inline const char alphabet<32>::enc[32] {
         'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
         'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
         '2', '3', '4', '5', '6', '7',
@@ -78,7 +82,7 @@ namespace util::encode {
 
     //-------------------------------------------------------------------------
     template <>
-    const uint8_t alphabet<32>::dec[256] = {
+    inline const uint8_t alphabet<32>::dec[256] = {
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
@@ -100,13 +104,13 @@ namespace util::encode {
 
     ///////////////////////////////////////////////////////////////////////////
     template <>
-    const char alphabet<16>::enc[16] {
+    inline const char alphabet<16>::enc[16] {
         '0', '1', '2', '3', '4', '5', '6', '7',
         '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
     };
 
     template <>
-    const uint8_t alphabet<16>::dec[256] = {
+    inline const uint8_t alphabet<16>::dec[256] = {
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
            0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
@@ -131,8 +135,53 @@ namespace util::encode {
     template <int Size> constexpr auto dec_v = alphabet<Size>::dec;
 
 
+    ///////////////////////////////////////////////////////////////////////////
+    namespace detail {
+        /// vectorised kernels for the alphabets that have them, selected at
+        /// runtime from the instruction sets the host supports.
+        ///
+        /// encode consumes the longest prefix of whole symbol groups it can
+        /// handle, writes exactly the corresponding symbols, and returns the
+        /// number of bytes consumed. decode consumes the longest prefix of
+        /// whole, valid, unpadded groups, writes exactly the corresponding
+        /// bytes, and returns the number of symbols consumed. either may
+        /// consume nothing, in which case the scalar path handles the data.
+        template <int Size>
+        struct kernel {
+            static constexpr bool enabled = false;
+        };
+
+
+        template <>
+        struct kernel<64> {
+            static constexpr bool enabled = true;
+
+            static size_t encode (char *dst, const uint8_t *src, size_t len) noexcept;
+            static size_t decode (uint8_t *dst, const char *src, size_t len) noexcept;
+        };
+
+
+        template <>
+        struct kernel<16> {
+            static constexpr bool enabled = true;
+
+            static size_t encode (char *dst, const uint8_t *src, size_t len) noexcept;
+            static size_t decode (uint8_t *dst, const char *src, size_t len) noexcept;
+        };
+
+
+        template <typename T>
+        constexpr bool is_byte_pointer_v = std::is_pointer_v<T> &&
+            sizeof (std::remove_pointer_t<T>) == 1;
+    }
+
+
     ///////////////////////////////////////////////////////////////////////////
     /// rfc4648 base16, base32, and base64 encoding
+    ///
+    /// contiguous inputs are passed through the vectorised kernels where
+    /// they exist for the alphabet; the output is identical to the scalar
+    /// implementation in all cases.
     template <int Size>
     struct base {
         static constexpr auto symbol_bits = log2 (Size);
@@ -146,6 +195,105 @@ namespace util::encode {
         template <typename InputT, typename OutputT>
         static OutputT
         encode (OutputT dst, const util::view<InputT> src)
+        {
+            auto cursor = std::cbegin (src);
+
+            if constexpr (detail::kernel<Size>::enabled && detail::is_byte_pointer_v<InputT>) {
+                auto first = reinterpret_cast<const uint8_t*> (cursor);
+                auto remain = src.size ();
+
+                if constexpr (detail::is_byte_pointer_v<OutputT>) {
+                    auto done = detail::kernel<Size>::encode (
+                        reinterpret_cast<char*> (dst), first, remain
+                    );
+
+                    dst += done / group_bytes * group_symbols;
+                    cursor += done;
+                } else {
+                    // stage the symbols through a local buffer for
+                    // iterators we can't write to directly.
+                    std::array<char,1024> buffer;
+                    constexpr auto chunk = buffer.size () / group_symbols * group_bytes;
+
+                    while (auto done = detail::kernel<Size>::encode (
+                        buffer.data (), first, std::min (remain, chunk)
+                    )) {
+                        dst = std::copy_n (buffer.data (), done / group_bytes * group_symbols, dst);
+                        first  += done;
+                        remain -= done;
+                        cursor += done;
+                    }
+                }
+            }
+
+            return encode_scalar (dst, util::view<InputT> { cursor, std::cend (src) });
+        }
+
+
+        //---------------------------------------------------------------------
+        /// throws std::invalid_argument if the input isn't a whole number of
+        /// symbol groups, or contains symbols outside the alphabet.
+        template <typename InputT, typename OutputT>
+        static OutputT
+        decode (OutputT dst, util::view<InputT> src)
+        {
+            if (src.empty ())
+                return dst;
+
+            if (src.size () % group_symbols)
+                throw std::invalid_argument ("base-encoded strings must be a proper multiple of symbols");
+
+            auto cursor = std::cbegin (src);
+
+            if constexpr (detail::kernel<Size>::enabled && detail::is_byte_pointer_v<InputT>) {
+                auto first = reinterpret_cast<const char*> (cursor);
+                auto remain = src.size ();
+
+                if constexpr (detail::is_byte_pointer_v<OutputT>) {
+                    auto done = detail::kernel<Size>::decode (
+                        reinterpret_cast<uint8_t*> (dst), first, remain
+                    );
+
+                    dst += done / group_symbols * group_bytes;
+                    cursor += done;
+                } else {
+                    std::array<uint8_t,768> buffer;
+                    constexpr auto chunk = buffer.size () / group_bytes * group_symbols;
+
+                    while (auto done = detail::kernel<Size>::decode (
+                        buffer.data (), first, std::min (remain, chunk)
+                    )) {
+                        dst = std::copy_n (buffer.data (), done / group_symbols * group_bytes, dst);
+                        first  += done;
+                        remain -= done;
+                        cursor += done;
+                    }
+                }
+            }
+
+            return decode_scalar (dst, util::view<InputT> { cursor, std::cend (src) });
+        }
+
+
+    private:
+        /// returns the value of the symbol `c`, throwing if it isn't part
+        /// of the alphabet.
+        static uint_fast32_t
+        symbol (unsigned char c)
+        {
+            // only the first symbol of the alphabet decodes to zero, so
+            // any other zero entry marks an invalid symbol.
+            const auto val = dec_v<Size>[c];
+            if (!val && c != static_cast<unsigned char> (enc_v<Size>[0]))
+                throw std::invalid_argument ("invalid symbol in base-encoded string");
+            return val;
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename InputT, typename OutputT>
+        static OutputT
+        encode_scalar (OutputT dst, const util::view<InputT> src)
         {
             // convert whole groups of symbols while we have enough bytes remaining
             auto cursor = std::cbegin (src);
@@ -192,14 +340,11 @@ namespace util::encode {
         //---------------------------------------------------------------------
         template <typename InputT, typename OutputT>
         static OutputT
-        decode (OutputT dst, util::view<InputT> src)
+        decode_scalar (OutputT dst, util::view<InputT> src)
         {
             if (src.empty ())
                 return dst;
 
-            if (src.size () % group_symbols)
-                throw std::invalid_argument ("base-encoded strings must be a proper multiple of symbols");
-
             union {
                 uint_fast32_t num;
                 uint8_t bytes[group_bytes];
@@ -207,15 +352,15 @@ namespace util::encode {
 
             const bool padded = src.end ()[-1] == '=';
             auto cursor = std::cbegin (src);
-            for (size_t i = 0, last = std::size (src) / group_symbols - padded?1:0;
-                i != last;
+            for (size_t i = 0, last = std::size (src) / group_symbols - (padded ? 1 : 0);
+                 i != last;
                  ++i)
             {
                 num = std::accumulate (
                     cursor, cursor + group_symbols,
                     uint_fast32_t {0},
                     [] (auto a, auto b) {
-                        return a << symbol_bits | dec_v<Size>[static_cast<unsigned>(b)];
+                        return a << symbol_bits | symbol (b);
                     }
                 );
 
@@ -226,11 +371,14 @@ namespace util::encode {
 
             if (cursor != std::end (src)) {
                 auto last = std::find (cursor, std::cend (src), '=');
+                if (!std::all_of (last, std::cend (src), [] (auto c) { return c == '='; }))
+                    throw std::invalid_argument ("invalid symbol in base-encoded string");
+
                 num = std::accumulate (
                     cursor, last,
                     uint_fast32_t{0},
                     [] (auto a, auto b) {
-                        return a << symbol_bits | dec_v<Size>[static_cast<unsigned> (b)];
+                        return a << symbol_bits | symbol (b);
                     }
                 );
 
@@ -246,6 +394,185 @@ namespace util::encode {
             return dst;
         }
     };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// incrementally encodes a byte stream that arrives in arbitrarily sized
+    /// chunks, carrying any partial symbol group between calls.
+    ///
+    /// memory use is fixed at one symbol group regardless of the stream
+    /// length. output is identical to base<Size>::encode over the
+    /// concatenated input.
+    template <int Size>
+    class encoder {
+    public:
+        using base_t = base<Size>;
+
+        /// the exact number of symbols the next call to `update` will
+        /// write for an input of `len` bytes.
+        size_t
+        update_size (size_t len) const noexcept
+        {
+            return (m_count + len) / base_t::group_bytes * base_t::group_symbols;
+        }
+
+
+        /// encodes as many whole symbol groups as possible and buffers the
+        /// remainder. `dst` must have room for `update_size (src.size ())`
+        /// symbols. returns the end of the written symbols.
+        char*
+        update (char *dst, util::view<const uint8_t*> src)
+        {
+            auto cursor = src.begin ();
+
+            // complete any group we have left over from a previous call
+            if (m_count) {
+                auto take = std::min<size_t> (base_t::group_bytes - m_count, src.size ());
+                std::copy_n (cursor, take, m_partial.begin () + m_count);
+                m_count += take;
+                cursor  += take;
+
+                if (m_count < base_t::group_bytes)
+                    return dst;
+
+                dst = base_t::encode (dst, util::view<const uint8_t*> { m_partial.data (), m_partial.data () + m_count });
+                m_count = 0;
+            }
+
+            // pass the whole groups straight through and keep the tail
+            const size_t remain = src.end () - cursor;
+            const auto whole = cursor + remain / base_t::group_bytes * base_t::group_bytes;
+
+            dst = base_t::encode (dst, util::view<const uint8_t*> { cursor, whole });
+
+            m_count = std::copy (whole, src.end (), m_partial.begin ()) - m_partial.begin ();
+            return dst;
+        }
+
+
+        /// the exact number of symbols `finish` will write
+        size_t
+        finish_size (void) const noexcept
+        {
+            return m_count ? base_t::group_symbols : 0;
+        }
+
+
+        /// writes the final, padded, symbol group (if any) and resets the
+        /// encoder for reuse. returns the end of the written symbols.
+        char*
+        finish (char *dst)
+        {
+            dst = base_t::encode (dst, util::view<const uint8_t*> { m_partial.data (), m_partial.data () + m_count });
+            m_count = 0;
+            return dst;
+        }
+
+
+    private:
+        std::array<uint8_t,base_t::group_bytes> m_partial;
+        size_t m_count = 0;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// incrementally decodes a symbol stream that arrives in arbitrarily
+    /// sized chunks, carrying any partial symbol group between calls.
+    ///
+    /// memory use is fixed at one symbol group regardless of the stream
+    /// length. output is identical to base<Size>::decode over the
+    /// concatenated input. a padded group terminates the stream; further
+    /// symbols before `finish` are an error.
+    template <int Size>
+    class decoder {
+    public:
+        using base_t = base<Size>;
+
+        /// the number of bytes the next call to `update` may write for an
+        /// input of `len` symbols. this is exact unless the input contains
+        /// padding, in which case fewer bytes are written.
+        size_t
+        update_size (size_t len) const noexcept
+        {
+            return (m_count + len) / base_t::group_symbols * base_t::group_bytes;
+        }
+
+
+        /// decodes as many whole symbol groups as possible and buffers the
+        /// remainder. `dst` must have room for `update_size (src.size ())`
+        /// bytes. returns the end of the written bytes.
+        uint8_t*
+        update (uint8_t *dst, util::view<const char*> src)
+        {
+            if (src.empty ())
+                return dst;
+
+            if (m_done)
+                throw std::invalid_argument ("base-encoded data follows padding");
+
+            auto cursor = src.begin ();
+
+            // complete any group we have left over from a previous call
+            if (m_count) {
+                auto take = std::min<size_t> (base_t::group_symbols - m_count, src.size ());
+                std::copy_n (cursor, take, m_partial.begin () + m_count);
+                m_count += take;
+                cursor  += take;
+
+                if (m_count < base_t::group_symbols)
+                    return dst;
+
+                dst = decode (dst, { m_partial.data (), m_partial.data () + m_count });
+                m_count = 0;
+
+                if (m_done && cursor != src.end ())
+                    throw std::invalid_argument ("base-encoded data follows padding");
+            }
+
+            // pass the whole groups straight through and keep the tail
+            const size_t remain = src.end () - cursor;
+            const auto whole = cursor + remain / base_t::group_symbols * base_t::group_symbols;
+
+            dst = decode (dst, { cursor, whole });
+
+            if (m_done && whole != src.end ())
+                throw std::invalid_argument ("base-encoded data follows padding");
+
+            m_count = std::copy (whole, src.end (), m_partial.begin ()) - m_partial.begin ();
+            return dst;
+        }
+
+
+        /// checks the stream ended on a symbol group boundary and resets
+        /// the decoder for reuse.
+        void
+        finish (void)
+        {
+            const bool partial = m_count != 0;
+
+            m_count = 0;
+            m_done = false;
+
+            if (partial)
+                throw std::invalid_argument ("base-encoded strings must be a proper multiple of symbols");
+        }
+
+
+    private:
+        uint8_t*
+        decode (uint8_t *dst, util::view<const char*> src)
+        {
+            if (src.empty ())
+                return dst;
+
+            m_done = src.end ()[-1] == '=';
+            return base_t::decode (dst, src);
+        }
+
+        std::array<char,base_t::group_symbols> m_partial;
+        size_t m_count = 0;
+        bool m_done = false;
+    };
 };
 
 #endif
@@ -20,11 +20,19 @@
 #include "view.hpp"
 
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <cmath>
 #include <cstddef>
 #include <iomanip>
 #include <iterator>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace util::format {
@@ -128,19 +136,29 @@ namespace util::format {
     class bound {
     public:
         bound (const parsed &_parsed, const ValueT &...args):
-            m_parsed {_parsed},
+            bound (
+                util::view<const specifier*> {
+                    _parsed.m_specifiers.data (),
+                    _parsed.m_specifiers.data () + _parsed.m_specifiers.size ()
+                },
+                args...
+            )
+        { ; }
+
+        bound (util::view<const specifier*> _specifiers, const ValueT &...args):
+            m_specifiers {_specifiers},
             m_values {args...}
         { ; }
 
         auto specifiers (void) const
-        { return util::make_view (m_parsed.m_specifiers); }
+        { return m_specifiers; }
 
         template <size_t Index>
-        auto
+        const auto&
         get (void) const& { return std::get<Index> (m_values); }
 
     private:
-        const parsed &m_parsed;
+        util::view<const specifier*> m_specifiers;
         std::tuple<const ValueT&...> m_values;
     };
 
@@ -218,12 +236,345 @@ namespace util::format {
     }
 
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Compile time parsing of printf format strings.
+    //
+    // FORMAT_PRINTF parses a literal format string into a fixed array of
+    // specifiers as a constant expression; malformed strings fail to
+    // compile. `bind` then checks the argument types against the
+    // specifiers, so rendering only needs to walk the array. eg:
+    //
+    //     static constexpr auto fmt = FORMAT_PRINTF ("%s: %u");
+    //     std::cout << util::format::bind<fmt> (name, count);
+    namespace detail {
+        constexpr bool
+        is_digit (char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+
+        //---------------------------------------------------------------------
+        /// reads a decimal number from the cursor, which is advanced past
+        /// the digits.
+        constexpr int
+        parse_number (const char *&cursor, const char *last)
+        {
+            int res = 0;
+            for ( ; cursor != last && is_digit (*cursor); ++cursor)
+                res = res * 10 + (*cursor - '0');
+            return res;
+        }
+
+
+        //---------------------------------------------------------------------
+        /// parses the printf format string [first, last) and passes each
+        /// specifier in turn to `dst`, accepting the same grammar as the
+        /// runtime parser.
+        ///
+        /// errors are thrown, which prevents the evaluation of constant
+        /// expressions.
+        template <typename OutputT>
+        constexpr void
+        parse_printf (const char *first, const char *last, OutputT &&dst)
+        {
+            for (auto cursor = first; cursor != last; ) {
+                specifier s;
+                const auto start = cursor;
+
+                if (*cursor != '%') {
+                    while (cursor != last && *cursor != '%')
+                        ++cursor;
+
+                    s.fmt = { start, cursor };
+                    s.type = type_t::LITERAL;
+                    dst (s);
+                    continue;
+                }
+
+                ++cursor;
+
+                // positional parameters are recognised, but unused, in
+                // the same manner as the runtime parser.
+                {
+                    auto probe = cursor;
+                    parse_number (probe, last);
+                    if (probe != cursor && probe != last && *probe == '$')
+                        cursor = probe + 1;
+                }
+
+                for (bool done = false; cursor != last && !done; ) {
+                    switch (*cursor) {
+                    case '+': s.flags.plus  = true; ++cursor; break;
+                    case '-': s.flags.minus = true; ++cursor; break;
+                    case ' ': s.flags.space = true; ++cursor; break;
+                    case '0': s.flags.zero  = true; ++cursor; break;
+                    case '#': s.flags.hash  = true; ++cursor; break;
+                    default:
+                        done = true;
+                        break;
+                    }
+                }
+
+                if (cursor != last && is_digit (*cursor))
+                    s.width = parse_number (cursor, last);
+
+                if (cursor != last && *cursor == '.') {
+                    ++cursor;
+                    s.precision = parse_number (cursor, last);
+                }
+
+                if (cursor != last) {
+                    switch (*cursor) {
+                    case 'h':
+                        if (++cursor != last && *cursor == 'h') {
+                            ++cursor;
+                            s.length = sizeof (char);
+                        } else {
+                            s.length = sizeof (short);
+                        }
+                        break;
+
+                    case 'l':
+                        if (++cursor != last && *cursor == 'l') {
+                            ++cursor;
+                            s.length = sizeof (long long);
+                        } else {
+                            s.length = sizeof (long);
+                        }
+                        break;
+
+                    case 'L': ++cursor; s.length = sizeof (long double); break;
+                    case 'z': ++cursor; s.length = sizeof (size_t);      break;
+                    case 'j': ++cursor; s.length = sizeof (intmax_t);    break;
+                    case 't': ++cursor; s.length = sizeof (ptrdiff_t);   break;
+                    }
+                }
+
+                if (cursor == last)
+                    throw std::runtime_error ("invalid format specification");
+
+                const char type = *cursor++;
+                switch (type) {
+                case '!': s.type = type_t::USER;   break;
+                case '%': s.type = type_t::ESCAPE; break;
+
+                case 'd':
+                case 'i':
+                    s.type = type_t::SIGNED;
+                    break;
+
+                case 'u': s.type = type_t::UNSIGNED; break;
+                case 'x': s.type = type_t::UNSIGNED; s.base = 16; break;
+                case 'X': s.type = type_t::UNSIGNED; s.base = 16; s.upper = true; break;
+                case 'o': s.type = type_t::UNSIGNED; s.base =  8; break;
+
+                case 'f': case 'F':
+                    s.type = type_t::REAL;
+                    s.representation = specifier::FIXED;
+                    s.upper = type == 'F';
+                    break;
+
+                case 'e': case 'E':
+                    s.type = type_t::REAL;
+                    s.representation = specifier::SCIENTIFIC;
+                    s.upper = type == 'E';
+                    break;
+
+                case 'g': case 'G':
+                    s.type = type_t::REAL;
+                    s.representation = specifier::DEFAULT;
+                    s.upper = type == 'G';
+                    break;
+
+                case 'a': case 'A':
+                    s.type = type_t::REAL;
+                    s.representation = specifier::HEX;
+                    s.base = 16;
+                    s.upper = type == 'A';
+                    break;
+
+                case 's': s.type = type_t::STRING;  break;
+                case 'c': s.type = type_t::CHAR;    break;
+                case 'p': s.type = type_t::POINTER; break;
+                case 'n': s.type = type_t::COUNT;   break;
+
+                default:
+                    throw std::runtime_error ("invalid format specification");
+                }
+
+                s.fmt = { start, cursor };
+                dst (s);
+            }
+        }
+
+
+        //---------------------------------------------------------------------
+        template <size_t N>
+        constexpr size_t
+        count_printf (const char (&fmt)[N])
+        {
+            size_t count = 0;
+            parse_printf (fmt, fmt + N - 1, [&count] (const specifier&) { ++count; });
+            return count;
+        }
+
+
+        //---------------------------------------------------------------------
+        /// tests if a value of type ValueT can be rendered by `spec`.
+        ///
+        /// this mirrors the checks that `value<ValueT>::write` performs at
+        /// runtime.
+        template <typename ValueT>
+        constexpr bool
+        accepts (const specifier &spec)
+        {
+            using value_t = std::decay_t<ValueT>;
+
+            constexpr bool is_string =
+                std::is_same_v<value_t, char*> ||
+                std::is_same_v<value_t, const char*> ||
+                std::is_same_v<value_t, std::string> ||
+                std::is_same_v<value_t, util::view<const char*>>;
+
+            constexpr bool is_character =
+                std::is_same_v<value_t, char> ||
+                std::is_same_v<value_t, wchar_t> ||
+                std::is_same_v<value_t, char16_t> ||
+                std::is_same_v<value_t, char32_t> ||
+                std::is_same_v<value_t, signed char> ||
+                std::is_same_v<value_t, unsigned char>;
+
+            if constexpr (std::is_arithmetic_v<value_t>) {
+                if (spec.type != type_t::USER && spec.length > 0 && size_t (spec.length) != sizeof (value_t))
+                    return false;
+            }
+
+            switch (spec.type) {
+            case type_t::LITERAL:
+            case type_t::ESCAPE:
+            case type_t::USER:
+                return true;
+
+            case type_t::SIGNED:    return std::is_signed_v<value_t>;
+            case type_t::UNSIGNED:  return std::is_unsigned_v<value_t>;
+            case type_t::REAL:      return std::is_floating_point_v<value_t>;
+            case type_t::STRING:    return is_string;
+            case type_t::CHAR:      return is_character;
+
+            case type_t::POINTER:
+                return std::is_pointer_v<value_t> ||
+                       std::is_integral_v<value_t> ||
+                       std::is_null_pointer_v<value_t>;
+
+            case type_t::COUNT:
+                return std::is_pointer_v<value_t> &&
+                       std::is_integral_v<std::remove_pointer_t<value_t>>;
+            }
+
+            return false;
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// a fixed sequence of specifiers parsed at compile time.
+    template <size_t N>
+    struct compiled {
+        std::array<specifier,N> m_specifiers;
+
+        constexpr const specifier* begin (void) const { return m_specifiers.data (); }
+        constexpr const specifier* end   (void) const { return m_specifiers.data () + N; }
+
+        /// the number of arguments required to render the format.
+        constexpr size_t
+        arguments (void) const
+        {
+            size_t count = 0;
+            for (const auto &s: m_specifiers)
+                if (s.type != type_t::LITERAL && s.type != type_t::ESCAPE)
+                    ++count;
+            return count;
+        }
+
+        /// tests if the format can render arguments of the given types.
+        template <typename ...Args>
+        constexpr bool
+        accepts (void) const
+        {
+            if (sizeof... (Args) != arguments ())
+                return false;
+
+            // the trailing value avoids a zero length array, and isn't used
+            bool (*const checks[]) (const specifier&) = {
+                &detail::accepts<Args>..., nullptr
+            };
+
+            size_t index = 0;
+            for (const auto &s: m_specifiers) {
+                if (s.type == type_t::LITERAL || s.type == type_t::ESCAPE)
+                    continue;
+                if (!checks[index++] (s))
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+
+    namespace detail {
+        template <size_t N, size_t M>
+        constexpr compiled<N>
+        compile_printf (const char (&fmt)[M])
+        {
+            compiled<N> res {};
+            size_t index = 0;
+
+            parse_printf (fmt, fmt + M - 1, [&] (const specifier &s) {
+                res.m_specifiers[index++] = s;
+            });
+
+            return res;
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// binds parameters to a format that was parsed at compile time, and
+    /// fails to compile if they don't match the format.
+    ///
+    /// FormatV must have static storage duration.
+    template <const auto &FormatV, typename ...Args>
+    bound<Args...>
+    bind (const Args &...args)
+    {
+        static_assert (
+            FormatV.arguments () == sizeof... (Args),
+            "format argument count mismatch"
+        );
+
+        static_assert (
+            FormatV.template accepts<Args...> (),
+            "format argument type mismatch"
+        );
+
+        return bound<Args...> (
+            util::view<const specifier*> { FormatV.begin (), FormatV.end () },
+            args...
+        );
+    }
+
+
     template <typename ValueT>
     struct value {
         static std::ostream&
         write (std::ostream &os, specifier spec, const ValueT &val)
         {
-            os << std::resetiosflags (~std::ios_base::fmtflags{});
+            // fill and precision would otherwise leak between specifiers
+            os << std::resetiosflags (~std::ios_base::fmtflags{})
+               << std::setfill (' ')
+               << std::setprecision (6);
 
             switch (spec.type) {
             case type_t::REAL:
@@ -356,15 +707,13 @@ namespace util::format {
                 }
             }
 
+            // strings are inserted as a whole so the width applies to the
+            // entire value rather than the first character.
             if constexpr (std::is_same_v<util::view<const char*>, ValueT>) {
-                if (spec.precision >= 0) {
-                    std::copy_n (
-                        std::begin (val),
-                        util::min (spec.precision, static_cast<int> (val.size ())),
-                        std::ostream_iterator<char> (os)
-                    );
-                    return os;
-                }
+                const auto size = spec.precision >= 0
+                    ? util::min (spec.precision, static_cast<int> (val.size ()))
+                    : static_cast<int> (val.size ());
+                return os << std::string_view (std::begin (val), size);
             }
 
             // the final output calls. we need to use unary plus so that
@@ -550,23 +899,380 @@ namespace util::format {
     }
 
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Rendering directly into memory.
+    //
+    // Numbers are converted with std::to_chars, which is independent of the
+    // locale, and strings and characters are copied directly. Anything else
+    // (user types, pointers, non-finite reals, and the alternate forms of
+    // reals) is rendered through value<T>::write into a temporary stream,
+    // as are mismatched arguments so that the same errors are raised.
+    namespace detail {
+        /// appends to a growable string
+        struct string_output {
+            std::string &dst;
+
+            void append (std::string_view val) { dst.append (val); }
+            void fill   (char c, size_t count) { dst.append (count, c); }
+        };
+
+
+        //---------------------------------------------------------------------
+        /// writes to a fixed buffer, discarding anything that doesn't fit,
+        /// while counting the size of the complete output.
+        struct fixed_output {
+            char *cursor;
+            char *const last;
+            size_t total = 0;
+
+            void
+            append (std::string_view val)
+            {
+                const auto count = std::min (val.size (), size_t (last - cursor));
+                cursor = std::copy_n (val.data (), count, cursor);
+                total += val.size ();
+            }
+
+            void
+            fill (char c, size_t count)
+            {
+                const auto avail = std::min (count, size_t (last - cursor));
+                cursor = std::fill_n (cursor, avail, c);
+                total += count;
+            }
+        };
+
+
+        //---------------------------------------------------------------------
+        /// appends `text` padded to the width of the specifier, in the same
+        /// manner as the stream renderer.
+        template <typename OutputT>
+        void
+        emit (OutputT &dst, const specifier &spec, std::string_view text, bool arithmetic)
+        {
+            const bool space = arithmetic && spec.flags.space && !spec.flags.plus;
+            if (space)
+                dst.fill (' ', 1);
+
+            const int width = spec.width - (space ? 1 : 0);
+            const size_t pad = width > int (text.size ()) ? width - text.size () : 0;
+            const char fill = spec.flags.zero ? '0' : ' ';
+
+            if (!spec.flags.minus)
+                dst.fill (fill, pad);
+            dst.append (text);
+            if (spec.flags.minus)
+                dst.fill (fill, pad);
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename OutputT, typename ValueT>
+        void
+        fallback (OutputT &dst, const specifier &spec, const ValueT &val)
+        {
+            // a fresh stream each time, as user types may themselves format
+            // values while being rendered.
+            std::ostringstream os;
+            value<ValueT>::write (os, spec, val);
+            dst.append (os.str ());
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename OutputT, typename ValueT>
+        void
+        render_integer (OutputT &dst, const specifier &spec, ValueT val)
+        {
+            // as with the stream renderer a zero precision hides zero
+            if (spec.precision == 0 && !val) {
+                if (spec.flags.space && !spec.flags.plus)
+                    dst.fill (' ', 1);
+                return;
+            }
+
+            // promote characters, and render other bases as unsigned
+            // values, as streams do.
+            using promoted_t = decltype (+val);
+            char buffer[4 + sizeof (promoted_t) * 3];
+            char *first = buffer + 3;
+            char *last;
+
+            if (spec.base == 10) {
+                last = std::to_chars (first, std::end (buffer), promoted_t (val)).ptr;
+                if (std::is_signed_v<promoted_t> && spec.flags.plus && val >= 0)
+                    *--first = '+';
+            } else {
+                if (spec.base != 16 && spec.base != 8)
+                    throw std::runtime_error ("unhandled numeric base");
+
+                using unsigned_t = std::make_unsigned_t<promoted_t>;
+                last = std::to_chars (first, std::end (buffer), unsigned_t (val), spec.base).ptr;
+
+                if (spec.upper)
+                    std::transform (first, last, first, [] (char c) { return c >= 'a' && c <= 'f' ? c - 'a' + 'A' : c; });
+
+                if (spec.flags.hash && val) {
+                    if (spec.base == 16)
+                        *--first = spec.upper ? 'X' : 'x';
+                    *--first = '0';
+                }
+            }
+
+            emit (dst, spec, { first, size_t (last - first) }, true);
+        }
+
+
+        //---------------------------------------------------------------------
+        /// returns false if the value must be rendered by a stream.
+        template <typename OutputT, typename ValueT>
+        bool
+        render_real (OutputT &dst, const specifier &spec, ValueT val)
+        {
+            if (!std::isfinite (val) || spec.flags.hash)
+                return false;
+
+            const int precision = spec.precision >= 0 ? spec.precision : 6;
+
+            char buffer[128];
+            char *first = buffer + 3;
+            std::to_chars_result res {};
+
+            switch (spec.representation) {
+            case specifier::FIXED:
+                res = std::to_chars (first, std::end (buffer), val, std::chars_format::fixed, precision);
+                break;
+            case specifier::SCIENTIFIC:
+                res = std::to_chars (first, std::end (buffer), val, std::chars_format::scientific, precision);
+                break;
+            case specifier::DEFAULT:
+                res = std::to_chars (first, std::end (buffer), val, std::chars_format::general, precision);
+                break;
+            case specifier::HEX:
+                // streams ignore the precision of hexadecimal reals
+                res = std::to_chars (first, std::end (buffer), val, std::chars_format::hex);
+                break;
+            }
+
+            // large fixed values, or large precisions, won't fit
+            if (res.ec != std::errc {})
+                return false;
+
+            if (spec.representation == specifier::HEX) {
+                const bool negative = *first == '-';
+                if (negative)
+                    ++first;
+                *--first = 'x';
+                *--first = '0';
+                if (negative)
+                    *--first = '-';
+            }
+
+            if (spec.upper)
+                std::transform (first, res.ptr, first, [] (char c) { return c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c; });
+
+            if (spec.flags.plus && !std::signbit (val))
+                *--first = '+';
+
+            emit (dst, spec, { first, size_t (res.ptr - first) }, true);
+            return true;
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename ValueT>
+        constexpr bool is_character_v =
+            std::is_same_v<ValueT, char> ||
+            std::is_same_v<ValueT, signed char> ||
+            std::is_same_v<ValueT, unsigned char>;
+
+
+        //---------------------------------------------------------------------
+        /// returns the text of string-like values, or nothing for other
+        /// values (including null strings).
+        template <typename ValueT>
+        std::optional<std::string_view>
+        string_of (const ValueT &val)
+        {
+            using value_t = std::decay_t<ValueT>;
+
+            if constexpr (std::is_array_v<ValueT> && is_character_v<std::remove_extent_t<ValueT>>) {
+                static_assert (std::extent_v<ValueT> > 0);
+                return std::string_view (val, std::extent_v<ValueT> - 1);
+            } else if constexpr (std::is_same_v<value_t, const char*> || std::is_same_v<value_t, char*>) {
+                if (!val)
+                    return std::nullopt;
+                return std::string_view (val);
+            } else if constexpr (std::is_same_v<value_t, std::string>) {
+                return std::string_view (val);
+            } else if constexpr (std::is_same_v<value_t, util::view<const char*>>) {
+                return std::string_view (std::begin (val), val.size ());
+            } else {
+                return std::nullopt;
+            }
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename OutputT, typename ValueT>
+        void
+        render (OutputT &dst, const specifier &spec, const ValueT &val)
+        {
+            using value_t = std::decay_t<ValueT>;
+
+            // let the stream renderer raise the appropriate error
+            if (!accepts<ValueT> (spec))
+                return fallback (dst, spec, val);
+
+            switch (spec.type) {
+            case type_t::USER:
+                if (auto text = string_of (val))
+                    return dst.append (*text);
+
+                if constexpr (std::is_same_v<value_t, bool>) {
+                    return dst.append (val ? "1" : "0");
+                } else if constexpr (is_character_v<value_t>) {
+                    return dst.fill (char (val), 1);
+                } else if constexpr (std::is_integral_v<value_t>) {
+                    char buffer[4 + sizeof (value_t) * 3];
+                    auto last = std::to_chars (std::begin (buffer), std::end (buffer), val).ptr;
+                    return dst.append ({ buffer, size_t (last - buffer) });
+                } else if constexpr (std::is_floating_point_v<value_t>) {
+                    specifier real;
+                    real.type = type_t::REAL;
+                    if (render_real (dst, real, val))
+                        return;
+                }
+                break;
+
+            case type_t::SIGNED:
+            case type_t::UNSIGNED:
+                if constexpr (std::is_integral_v<value_t>)
+                    return render_integer (dst, spec, val);
+                break;
+
+            case type_t::REAL:
+                if constexpr (std::is_floating_point_v<value_t>)
+                    if (render_real (dst, spec, val))
+                        return;
+                break;
+
+            case type_t::STRING:
+                if (auto text = string_of (val)) {
+                    if (spec.precision >= 0)
+                        *text = text->substr (0, spec.precision);
+                    return emit (dst, spec, *text, false);
+                }
+                break;
+
+            case type_t::CHAR:
+                if constexpr (is_character_v<value_t>) {
+                    const char c = val;
+                    return emit (dst, spec, { &c, 1 }, false);
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            fallback (dst, spec, val);
+        }
+
+
+        //---------------------------------------------------------------------
+        /// renders each specifier in turn to `dst`; the counterpart of the
+        /// stream based `write`.
+        template <int Index, typename OutputT, typename SpecifiersT, template <typename...> class HolderT, typename ...DataT>
+        void
+        render_all (OutputT &dst, const SpecifiersT &specifiers, const HolderT<DataT...> &data)
+        {
+            for (auto cursor = std::cbegin (specifiers); cursor != std::cend (specifiers); ++cursor) {
+                const auto &s = *cursor;
+
+                if (s.type == type_t::LITERAL) {
+                    dst.append ({ std::begin (s.fmt), s.fmt.size () });
+                    continue;
+                }
+
+                if (s.type == type_t::ESCAPE) {
+                    dst.fill ('%', 1);
+                    continue;
+                }
+
+                if constexpr (Index < sizeof... (DataT)) {
+                    using value_t = std::tuple_element_t<Index,std::tuple<DataT...>>;
+                    render<OutputT, value_t> (dst, s, data.template get<Index> ());
+                    return render_all<Index+1> (dst, util::make_view (cursor+1,specifiers.end ()), data);
+                } else {
+                    throw std::runtime_error ("insufficient data parameters");
+                }
+            }
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// the result of rendering to a fixed buffer
+    struct format_to_n_result {
+        /// one past the last character written
+        char *out;
+        /// the size of the complete output, which may exceed the buffer.
+        size_t size;
+    };
+
+
+    /// renders at most `size` characters into `dst`, without a terminating
+    /// null.
+    template <template <typename...> class HolderT, typename ...Args>
+    format_to_n_result
+    format_to_n (char *dst, size_t size, const HolderT<Args...> &fmt)
+    {
+        detail::fixed_output out { dst, dst + size };
+        detail::render_all<0> (out, fmt.specifiers (), fmt);
+        return { out.cursor, out.total };
+    }
+
+
+    /// appends the rendered output to `dst`.
+    template <template <typename...> class HolderT, typename ...Args>
+    std::string&
+    format_to (std::string &dst, const HolderT<Args...> &fmt)
+    {
+        detail::string_output out { dst };
+        detail::render_all<0> (out, fmt.specifiers (), fmt);
+        return dst;
+    }
+
+
+    //-------------------------------------------------------------------------
     template <typename ...Args>
     std::string
     to_string (const bound<Args...> &fmt)
     {
-        std::ostringstream os;
-        os << fmt;
-        return os.str ();
+        std::string res;
+        format_to (res, fmt);
+        return res;
     }
 
     template <typename ...Args>
     std::string
     to_string (const stored<Args...> &fmt)
     {
-        std::ostringstream os;
-        os << fmt;
-        return os.str ();
+        std::string res;
+        format_to (res, fmt);
+        return res;
     }
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+/// parses a literal printf format string at compile time, yielding a
+/// util::format::compiled value.
+#define FORMAT_PRINTF(FMT) (                                                \
+    ::util::format::detail::compile_printf<                                 \
+        ::util::format::detail::count_printf (FMT)                          \
+    > (FMT)                                                                 \
+)
+
 #endif
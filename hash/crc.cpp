@@ -125,6 +125,110 @@ util::hash::crc<
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    // A linear operator over GF(2) acting on digest sized bit vectors. Entry
+    // `i` stores the image of the basis vector which has only bit `i` set.
+    template <typename DigestT>
+    using gf2_matrix = std::array<DigestT, sizeof (DigestT) * 8>;
+
+
+    //-------------------------------------------------------------------------
+    template <typename DigestT>
+    DigestT
+    gf2_apply (const gf2_matrix<DigestT> &m, DigestT v) noexcept
+    {
+        DigestT sum = 0;
+
+        for (std::size_t i = 0; v; ++i, v >>= 1u)
+            if (v & 1u)
+                sum ^= m[i];
+
+        return sum;
+    }
+
+
+    //-------------------------------------------------------------------------
+    template <typename DigestT>
+    gf2_matrix<DigestT>
+    gf2_square (const gf2_matrix<DigestT> &m) noexcept
+    {
+        gf2_matrix<DigestT> res {};
+        for (std::size_t i = 0; i < res.size (); ++i)
+            res[i] = gf2_apply (m, m[i]);
+        return res;
+    }
+
+
+    //-------------------------------------------------------------------------
+    // Operators that advance the raw (ie, unreflected and unfinalised) CRC
+    // register across runs of 2^i zero bytes, for every i that can appear
+    // in a size_t length.
+    template <typename CrcT>
+    std::array<gf2_matrix<typename CrcT::digest_t>, sizeof (std::size_t) * 8>
+    zeroes_operators (void)
+    {
+        using digest_t = typename CrcT::digest_t;
+        const auto table = CrcT::table ();
+
+        std::array<gf2_matrix<digest_t>, sizeof (std::size_t) * 8> res {};
+
+        for (std::size_t i = 0; i < res[0].size (); ++i) {
+            digest_t accum = digest_t (1) << i;
+
+            if (CrcT::reflect_in)
+                accum = table[accum & 0xFFu] ^ (accum >> 8u);
+            else {
+                constexpr auto shift = sizeof (digest_t) * 8u - 8u;
+                accum = (accum << 8u) ^ table[accum >> shift];
+            }
+
+            res[0][i] = accum;
+        }
+
+        for (std::size_t i = 1; i < res.size (); ++i)
+            res[i] = gf2_square (res[i - 1]);
+
+        return res;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Given the raw register R(X) after processing X from the initial value I,
+// and Z^n being the operator for n zero bytes, we have:
+//
+//     R(AB) = Z^|B| (R(A) ^ I) ^ R(B)
+//
+// The finalisation (an optional bit reversal and an xor) is affine, so we
+// unwrap A, apply the operator, and rewrap before xoring B's digest.
+template <typename CrcT>
+typename CrcT::digest_t
+util::hash::crc_combine (
+    const typename CrcT::digest_t a,
+    const typename CrcT::digest_t b,
+    std::size_t len_b
+) noexcept {
+    using digest_t = typename CrcT::digest_t;
+
+    if (!len_b)
+        return a;
+
+    static const auto s_zeroes = zeroes_operators<CrcT> ();
+
+    const auto reflect = [] (digest_t val) {
+        return CrcT::reflect_in != CrcT::reflect_out ? util::reverse (val) : val;
+    };
+
+    digest_t accum = reflect (a ^ CrcT::final) ^ CrcT::initial;
+    for (std::size_t i = 0; len_b; ++i, len_b >>= 1u)
+        if (len_b & 1u)
+            accum = gf2_apply (s_zeroes[i], accum);
+
+    return reflect (accum) ^ b;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 template class util::hash::crc<uint32_t, 0x04C11DB7, 0xffffffff, 0xffffffff, true,  true >; // crc32
 template class util::hash::crc<uint32_t, 0x04C11DB7, 0xffffffff, 0xffffffff, false, false>; // crc32b
@@ -133,4 +237,17 @@ template class util::hash::crc<uint32_t, 0xa833982b, 0xffffffff, 0xffffffff, tru
 
 template class util::hash::crc<uint32_t, 0x04C11DB7, 0x00000000, 0x00000000, false, false>; // ogg
 
-template class util::hash::crc<uint64_t, 0x42f0e1eba9ea3693, 0, 0, false, false>; // crc64
\ No newline at end of file
+template class util::hash::crc<uint64_t, 0x42f0e1eba9ea3693, 0, 0, false, false>; // crc64
+
+
+//-----------------------------------------------------------------------------
+#define INSTANTIATE_COMBINE(KLASS) \
+template \
+KLASS::digest_t \
+util::hash::crc_combine<KLASS> (KLASS::digest_t, KLASS::digest_t, std::size_t) noexcept;
+
+INSTANTIATE_COMBINE(util::hash::crc32)
+INSTANTIATE_COMBINE(util::hash::crc32b)
+INSTANTIATE_COMBINE(util::hash::crc32c)
+INSTANTIATE_COMBINE(util::hash::crc32d)
+INSTANTIATE_COMBINE(util::hash::crc64)
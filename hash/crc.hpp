@@ -54,6 +54,10 @@ namespace util::hash {
         using digest_t = DigestT;
 
         static constexpr auto generator = Generator;
+        static constexpr auto initial   = Initial;
+        static constexpr auto final     = Final;
+        static constexpr auto reflect_in  = ReflectIn;
+        static constexpr auto reflect_out = ReflectOut;
 
         digest_t operator() (util::view<const uint8_t*>) const noexcept;
 
@@ -72,6 +76,25 @@ namespace util::hash {
     using crc32d = crc<uint32_t, 0xa833982b, 0xffffffff, 0xffffffff, true,  true>;
 
     using crc64 = crc<uint64_t, 0x42f0e1eba9ea3693, 0, 0, false, false>;
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Computes the checksum of the concatenation of two buffers, A and B,
+    // given only the checksum of each and the length of B in bytes.
+    //
+    // The result is identical to the checksum of the serial data, which
+    // allows the checksum of large buffers to be calculated in parallel
+    // chunks then merged.
+    //
+    // Runs in O(log len_b) time using precomputed operators for runs of
+    // 2^n zero bytes. Adapted from zlib's crc32_combine.
+    template <typename CrcT>
+    typename CrcT::digest_t
+    crc_combine (
+        typename CrcT::digest_t a,
+        typename CrcT::digest_t b,
+        std::size_t len_b
+    ) noexcept;
 }
 
 #endif
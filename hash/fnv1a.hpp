@@ -21,15 +21,94 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <string_view>
 
 namespace util::hash {
+    namespace detail::fnv1a {
+        // Prime is,
+        //   32: 2^ 24 + 2^8 + 0x93
+        //   64: 2^ 40 + 2^8 + 0xb3
+        //  128: 2^ 88 + 2^8 + 0x3B
+        //  256: 2^168 + 2^8 + 0x63
+        //  512: 2^344 + 2^8 + 0x57
+        // 1024: 2^680 + 2^8 + 0x8D
+        //
+        // Bias is the FNV-0 hash of "chongo <Landon Curt Noll> /\\../\\"
+        template <typename DigestT>
+        struct constants { };
+
+        template <>
+        struct constants<uint32_t> {
+            static constexpr uint32_t prime =   16777619u;
+            static constexpr uint32_t bias  = 2166136261u;
+        };
+
+        template <>
+        struct constants<uint64_t> {
+            static constexpr uint64_t prime = 1099511628211u;
+            static constexpr uint64_t bias  = 14695981039346656037u;
+        };
+
+
+        /// hashes the bytes in [first, last). used by both the runtime and
+        /// the constexpr entry points so that their results are identical.
+        template <typename DigestT, typename IteratorT>
+        constexpr DigestT
+        eval (IteratorT first, IteratorT last) noexcept
+        {
+            auto result = constants<DigestT>::bias;
+
+            for (; first != last; ++first) {
+                result ^= static_cast<uint8_t> (*first);
+                result *= constants<DigestT>::prime;
+            }
+
+            return result;
+        }
+    }
+
+
     // Fast and general hashing using FNV-1a
     template <typename DigestT>
     struct fnv1a {
         using digest_t = DigestT;
 
         digest_t operator() (util::view<const uint8_t*>) const noexcept;
+
+        /// hashes the characters of a string at compile time. the result is
+        /// identical to hashing the same bytes with the view overload.
+        constexpr digest_t
+        operator() (std::string_view data) const noexcept
+        {
+            return detail::fnv1a::eval<DigestT> (data.begin (), data.end ());
+        }
+
+        /// hashes a string literal, excluding the trailing null.
+        template <size_t N>
+        constexpr digest_t
+        operator() (const char (&data)[N]) const noexcept
+        {
+            return (*this) (std::string_view (data, N - 1));
+        }
     };
+
+    using fnv1a32 = fnv1a<uint32_t>;
+    using fnv1a64 = fnv1a<uint64_t>;
+
+
+    namespace literals {
+        constexpr uint32_t
+        operator"" _fnv1a32 (const char *str, std::size_t len) noexcept
+        {
+            return fnv1a32 {} (std::string_view (str, len));
+        }
+
+        constexpr uint64_t
+        operator"" _fnv1a64 (const char *str, std::size_t len) noexcept
+        {
+            return fnv1a64 {} (std::string_view (str, len));
+        }
+    }
 }
 
 #endif
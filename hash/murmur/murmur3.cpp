@@ -24,31 +24,13 @@
 using util::hash::murmur3;
 
 
-///////////////////////////////////////////////////////////////////////////////
-static
-uint32_t
-read_u32 (const uint8_t *bytes)
-{
-    return bytes[0] <<  0 |
-           bytes[1] <<  8 |
-           bytes[2] << 16 |
-           bytes[3] << 24;
-}
-
-
 ///////////////////////////////////////////////////////////////////////////////
 // Finalization mix - force all bits of a hash block to avalanche
 template <size_t DigestBits, size_t ArchBits>
 uint32_t
 murmur3<DigestBits,ArchBits>::mix (uint32_t h)
 {
-    h ^= h >> 16;
-    h *= 0x85ebca6b;
-    h ^= h >> 13;
-    h *= 0xc2b2ae35;
-    h ^= h >> 16;
-
-    return h;
+    return util::hash::detail::murmur3::mix (h);
 }
 
 
@@ -77,48 +59,7 @@ template <size_t ArchBits>
 struct hash<32,ArchBits> {
     static auto eval (util::view<const uint8_t*> data, uint32_t seed)
     {
-        auto nblocks = data.size () / sizeof (uint32_t);
-
-        uint32_t h1 = seed;
-
-        static const uint32_t c1 = 0xcc9e2d51;
-        static const uint32_t c2 = 0x1b873593;
-
-        //----------
-        // body
-        auto cursor = data.begin ();
-        auto last   = cursor + nblocks * sizeof (uint32_t);
-        for (; cursor < last; cursor += sizeof (uint32_t)) {
-            uint32_t k1 = read_u32 (cursor);
-
-            k1 *= c1;
-            k1 = util::rotatel (k1, 15);
-            k1 *= c2;
-            h1 ^= k1;
-
-            h1 = util::rotatel (h1, 13);
-            h1 += 0;
-            h1 = h1 * 5 + 0xe6546b64;
-        }
-
-        //----------
-        // tail
-        if (data.size () % sizeof (uint32_t)) {
-            uint32_t k1 = 0 ^ util::hash::murmur::tail<uint32_t> (cursor, data.size ());
-
-            k1 *= c1;
-            k1  = util::rotatel (k1, 15);
-            k1 *= c2;
-            h1 ^= k1;
-        }
-
-        //----------
-        // finalization
-
-        h1 ^= data.size ();
-        h1  = util::hash::murmur3<32,ArchBits>::mix (h1);
-
-        return h1;
+        return util::hash::detail::murmur3::eval32 (data.data (), data.size (), seed);
     }
 };
 
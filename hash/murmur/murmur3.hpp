@@ -18,10 +18,13 @@
 #define __UTIL_HASH_MURMUR_MURMUR3_HPP
 
 #include "../../view.hpp"
+#include "../../bitwise.hpp"
 
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <string_view>
+#include <type_traits>
 
 // Austin Appleby's MurmurHash3
 namespace util::hash {
@@ -32,12 +35,82 @@ namespace util::hash {
         template <> struct digest_type< 32,32> { using type = uint32_t; };
         template <> struct digest_type<128,32> { using type = std::array<uint32_t,4>; };
         template <> struct digest_type<128,64> { using type = std::array<uint64_t,2>; };
+
+
+        // Finalization mix - force all bits of a hash block to avalanche
+        constexpr uint32_t
+        mix (uint32_t h) noexcept
+        {
+            h ^= h >> 16;
+            h *= 0x85ebca6b;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35;
+            h ^= h >> 16;
+
+            return h;
+        }
+
+
+        /// hashes `len` bytes starting at `data` with the 32 bit variant.
+        ///
+        /// blocks are read a byte at a time so that the same code can be
+        /// evaluated at compile time over characters and at run time over
+        /// raw bytes, guaranteeing identical results for each.
+        template <typename ByteT>
+        constexpr uint32_t
+        eval32 (const ByteT *data, const size_t len, const uint32_t seed) noexcept
+        {
+            constexpr uint32_t c1 = 0xcc9e2d51;
+            constexpr uint32_t c2 = 0x1b873593;
+
+            const auto byte = [data] (size_t i) -> uint32_t {
+                return static_cast<uint8_t> (data[i]);
+            };
+
+            uint32_t h1 = seed;
+
+            // body
+            const size_t nblocks = len / sizeof (uint32_t);
+            for (size_t i = 0; i < nblocks; ++i) {
+                const size_t base = i * sizeof (uint32_t);
+                uint32_t k1 = byte (base + 0) <<  0 |
+                              byte (base + 1) <<  8 |
+                              byte (base + 2) << 16 |
+                              byte (base + 3) << 24;
+
+                k1 *= c1;
+                k1  = util::rotatel (k1, 15);
+                k1 *= c2;
+                h1 ^= k1;
+
+                h1 = util::rotatel (h1, 13);
+                h1 = h1 * 5 + 0xe6546b64;
+            }
+
+            // tail
+            const size_t tail = nblocks * sizeof (uint32_t);
+            uint32_t k1 = 0;
+
+            switch (len % sizeof (uint32_t)) {
+            case 3: k1 ^= byte (tail + 2) << 16; [[fallthrough]];
+            case 2: k1 ^= byte (tail + 1) <<  8; [[fallthrough]];
+            case 1: k1 ^= byte (tail + 0);
+                    k1 *= c1;
+                    k1  = util::rotatel (k1, 15);
+                    k1 *= c2;
+                    h1 ^= k1;
+            }
+
+            // finalization
+            h1 ^= static_cast<uint32_t> (len);
+            return mix (h1);
+        }
     };
 
     template <size_t DigestBits, size_t ArchBits>
     class murmur3 {
     public:
-        murmur3 (uint32_t _seed):
+        constexpr murmur3 (uint32_t _seed):
             m_seed (_seed)
         { ; }
 
@@ -51,6 +124,31 @@ namespace util::hash {
         digest_t
         operator() (util::view<const uint8_t*> data) const noexcept;
 
+        /// hashes the characters of a string at compile time. only available
+        /// for the 32 bit digest. the result is identical to hashing the
+        /// same bytes with the view overload.
+        template <
+            size_t BitsV = DigestBits,
+            typename = std::enable_if_t<BitsV == 32>
+        >
+        constexpr digest_t
+        operator() (std::string_view data) const noexcept
+        {
+            return detail::murmur3::eval32 (data.data (), data.size (), m_seed);
+        }
+
+        /// hashes a string literal, excluding the trailing null.
+        template <
+            size_t N,
+            size_t BitsV = DigestBits,
+            typename = std::enable_if_t<BitsV == 32>
+        >
+        constexpr digest_t
+        operator() (const char (&data)[N]) const noexcept
+        {
+            return (*this) (std::string_view (data, N - 1));
+        }
+
     private:
         uint32_t m_seed;
     };
@@ -58,6 +156,15 @@ namespace util::hash {
     using murmur3_32      = murmur3< 32,32>;
     using murmur3_128_x86 = murmur3<128,32>;
     using murmur3_128_x64 = murmur3<128,64>;
+
+
+    namespace literals {
+        constexpr uint32_t
+        operator"" _murmur3_32 (const char *str, std::size_t len) noexcept
+        {
+            return murmur3_32 (0) (std::string_view (str, len));
+        }
+    }
 }
 
 #endif
@@ -0,0 +1,190 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_HASH_TREE_HPP
+#define CRUFT_UTIL_HASH_TREE_HPP
+
+#include "crc.hpp"
+
+#include "../debug.hpp"
+#include "../endian.hpp"
+#include "../job/queue.hpp"
+#include "../view.hpp"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace util::hash {
+    /// Merges the digests of two adjacent subtrees into the digest of their
+    /// parent.
+    ///
+    /// The default forms a Merkle tree by hashing the little-endian
+    /// concatenation of the two child digests.
+    template <typename HashT>
+    struct tree_combine {
+        using digest_t = typename HashT::digest_t;
+
+        digest_t
+        operator() (HashT &hash, digest_t a, digest_t b, std::size_t) const
+        {
+            const std::array<digest_t,2> children { htol (a), htol (b) };
+            return hash ({
+                reinterpret_cast<const uint8_t*> (children.data ()),
+                sizeof (children)
+            });
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    /// CRCs can be merged exactly, so the tree digest is identical to the
+    /// serial digest regardless of the leaf size.
+    template <
+        typename DigestT,
+        DigestT Generator,
+        DigestT Initial,
+        DigestT Final,
+        bool ReflectIn,
+        bool ReflectOut
+    >
+    struct tree_combine<
+        crc<DigestT,Generator,Initial,Final,ReflectIn,ReflectOut>
+    > {
+        using hash_t = crc<DigestT,Generator,Initial,Final,ReflectIn,ReflectOut>;
+        using digest_t = DigestT;
+
+        digest_t
+        operator() (hash_t&, digest_t a, digest_t b, std::size_t len_b) const noexcept
+        {
+            return crc_combine<hash_t> (a, b, len_b);
+        }
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Hashes large buffers in parallel by splitting them into fixed size
+    /// leaves, hashing each leaf on a job queue, then merging adjacent
+    /// digests pairwise until a single root remains. An odd digest at the end
+    /// of a level is promoted to the next level unchanged.
+    ///
+    /// The result is deterministic for a given leaf size, but for
+    /// non-CRC hashes it only matches the serial digest when the data fits
+    /// in a single leaf.
+    ///
+    /// The caller blocks until all leaves are complete, so this must not be
+    /// invoked from within a job running on the same queue.
+    template <typename HashT, typename CombineT = tree_combine<HashT>>
+    class tree {
+    public:
+        using digest_t = typename HashT::digest_t;
+
+        static constexpr std::size_t DEFAULT_LEAF = 1u << 20;
+
+        explicit tree (
+            util::job::queue &_jobs,
+            std::size_t _leaf = DEFAULT_LEAF,
+            HashT _hash = {},
+            CombineT _combine = {}
+        ):
+            m_jobs    (_jobs),
+            m_leaf    (_leaf),
+            m_hash    (std::move (_hash)),
+            m_combine (std::move (_combine))
+        {
+            CHECK_GT (m_leaf, 0u);
+        }
+
+
+        //---------------------------------------------------------------------
+        digest_t
+        operator() (const util::view<const uint8_t*> data)
+        {
+            if (data.size () <= m_leaf)
+                return HashT (m_hash) (data);
+
+            const std::size_t count = (data.size () + m_leaf - 1) / m_leaf;
+            std::vector<node> nodes (count);
+
+            // dispatch a job for each leaf and wait for the last one to
+            // signal completion. the counter is only touched under the lock
+            // so that `state` can't be destroyed while a job still uses it.
+            struct {
+                std::size_t remain;
+                std::mutex mutex;
+                std::condition_variable cv;
+            } state;
+            state.remain = count;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                m_jobs.submit ([&] (std::size_t idx) {
+                    const auto first = data.begin () + idx * m_leaf;
+                    const auto last  = std::min (first + m_leaf, data.end ());
+
+                    nodes[idx] = {
+                        HashT (m_hash) ({ first, last }),
+                        static_cast<std::size_t> (last - first)
+                    };
+
+                    std::lock_guard<std::mutex> lk (state.mutex);
+                    if (--state.remain == 0)
+                        state.cv.notify_one ();
+                }, i);
+            }
+
+            {
+                std::unique_lock<std::mutex> lk (state.mutex);
+                state.cv.wait (lk, [&] () { return state.remain == 0; });
+            }
+
+            // merge each level in place until we hit the root
+            HashT hash (m_hash);
+
+            for (auto size = nodes.size (); size > 1; size = (size + 1) / 2) {
+                for (std::size_t i = 0; i + 1 < size; i += 2) {
+                    nodes[i / 2] = {
+                        m_combine (hash, nodes[i].digest, nodes[i + 1].digest, nodes[i + 1].size),
+                        nodes[i].size + nodes[i + 1].size
+                    };
+                }
+
+                if (size % 2)
+                    nodes[size / 2] = nodes[size - 1];
+            }
+
+            return nodes[0].digest;
+        }
+
+    private:
+        struct node {
+            digest_t digest;
+            std::size_t size;
+        };
+
+        util::job::queue &m_jobs;
+        std::size_t m_leaf;
+        HashT m_hash;
+        CombineT m_combine;
+    };
+}
+
+#endif
@@ -71,6 +71,14 @@ mapped_file::empty (void) const
 }
 
 
+//-----------------------------------------------------------------------------
+void
+mapped_file::advise (int advice) const
+{
+    ::util::posix::error::try_value (madvise (m_data, m_size, advice));
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 uint8_t*
 mapped_file::data (void) &
@@ -52,6 +52,10 @@ namespace util {
 
             bool empty (void) const;
 
+            /// hints the expected access pattern of the mapping to the
+            /// kernel; eg, MADV_SEQUENTIAL for a single forward pass.
+            void advise (int advice) const;
+
             /// returns the total allocated mapped region in bytes.
             ///
             /// result is typed size_t (rather than a signed type) because we
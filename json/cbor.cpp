@@ -0,0 +1,699 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./cbor.hpp"
+
+#include "./except.hpp"
+#include "./tree.hpp"
+#include "./writer.hpp"
+
+#include "../debug.hpp"
+#include "../json2/event.hpp"
+#include "../json2/string.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using json::cbor::reader;
+using json::cbor::encoder;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// major types, already shifted into the top three bits of the initial byte
+enum : uint8_t {
+    MAJOR_UINT   = 0 << 5,
+    MAJOR_NINT   = 1 << 5,
+    MAJOR_BYTES  = 2 << 5,
+    MAJOR_STRING = 3 << 5,
+    MAJOR_ARRAY  = 4 << 5,
+    MAJOR_MAP    = 5 << 5,
+    MAJOR_TAG    = 6 << 5,
+    MAJOR_SIMPLE = 7 << 5,
+};
+
+
+//-----------------------------------------------------------------------------
+// additional information values with special meaning
+enum : uint8_t {
+    INFO_UINT8      = 24,
+    INFO_UINT16     = 25,
+    INFO_UINT32     = 26,
+    INFO_UINT64     = 27,
+    INFO_INDEFINITE = 31,
+};
+
+
+//-----------------------------------------------------------------------------
+// simple values and floating point encodings within major type 7
+enum : uint8_t {
+    SIMPLE_FALSE     = MAJOR_SIMPLE | 20,
+    SIMPLE_TRUE      = MAJOR_SIMPLE | 21,
+    SIMPLE_NULL      = MAJOR_SIMPLE | 22,
+    SIMPLE_UNDEFINED = MAJOR_SIMPLE | 23,
+    SIMPLE_HALF      = MAJOR_SIMPLE | INFO_UINT16,
+    SIMPLE_FLOAT     = MAJOR_SIMPLE | INFO_UINT32,
+    SIMPLE_DOUBLE    = MAJOR_SIMPLE | INFO_UINT64,
+    SIMPLE_BREAK     = MAJOR_SIMPLE | INFO_INDEFINITE,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+static double
+from_half (uint16_t bits)
+{
+    const int exponent = (bits >> 10) & 0x1f;
+    const int mantissa = bits & 0x3ff;
+
+    double value;
+    if (exponent == 0)
+        value = std::ldexp (mantissa, -24);
+    else if (exponent != 31)
+        value = std::ldexp (mantissa + 1024, exponent - 25);
+    else
+        value = mantissa == 0 ? INFINITY : NAN;
+
+    return bits & 0x8000 ? -value : value;
+}
+
+
+//-----------------------------------------------------------------------------
+/// reads `N` big endian bytes starting at `ptr`
+template <int N>
+static uint64_t
+read_be (const uint8_t *ptr)
+{
+    uint64_t accum = 0;
+    for (int i = 0; i < N; ++i)
+        accum = accum << 8 | ptr[i];
+    return accum;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+util::view<const uint8_t*>
+reader::take (uint64_t size)
+{
+    if (size > uint64_t (m_end - m_cursor))
+        throw json::error ("truncated cbor");
+
+    auto first = m_cursor;
+    m_cursor += size;
+    return { first, m_cursor };
+}
+
+
+//-----------------------------------------------------------------------------
+uint64_t
+reader::argument (uint8_t info)
+{
+    switch (info) {
+    case 0 ... 23:    return info;
+    case INFO_UINT8:  return read_be<1> (take (1).data ());
+    case INFO_UINT16: return read_be<2> (take (2).data ());
+    case INFO_UINT32: return read_be<4> (take (4).data ());
+    case INFO_UINT64: return read_be<8> (take (8).data ());
+    }
+
+    throw json::error ("reserved cbor argument");
+}
+
+
+//-----------------------------------------------------------------------------
+json::cbor::item
+reader::next (void)
+{
+    item res { kind::NONE, { 0 }, { m_cursor, m_cursor } };
+
+    do {
+        const uint8_t initial = take (1)[0];
+        const uint8_t major = initial & 0xe0;
+        const uint8_t info  = initial & 0x1f;
+
+        switch (major) {
+        case MAJOR_UINT:
+            res.type = kind::UINT;
+            res.uint = argument (info);
+            return res;
+
+        case MAJOR_NINT: {
+            const auto arg = argument (info);
+            if (arg > uint64_t (std::numeric_limits<intmax_t>::max ()))
+                throw json::error ("cbor integer out of range");
+
+            res.type = kind::SINT;
+            res.sint = -1 - intmax_t (arg);
+            return res;
+        }
+
+        case MAJOR_BYTES:
+        case MAJOR_STRING:
+            if (info == INFO_INDEFINITE)
+                throw json::error ("indefinite length cbor strings are unsupported");
+
+            res.type = major == MAJOR_BYTES ? kind::BYTES : kind::STRING;
+            res.data = take (argument (info));
+            return res;
+
+        case MAJOR_ARRAY:
+        case MAJOR_MAP:
+            res.type = major == MAJOR_ARRAY ? kind::ARRAY : kind::OBJECT;
+            res.length = info == INFO_INDEFINITE ? INDEFINITE : argument (info);
+            return res;
+
+        case MAJOR_TAG:
+            // tags annotate the following item; JSON has no use for them.
+            argument (info);
+            continue;
+
+        case MAJOR_SIMPLE:
+            switch (initial) {
+            case SIMPLE_FALSE:
+            case SIMPLE_TRUE:
+                res.type = kind::BOOLEAN;
+                res.boolean = initial == SIMPLE_TRUE;
+                return res;
+
+            case SIMPLE_NULL:
+            case SIMPLE_UNDEFINED:
+                res.type = kind::NONE;
+                return res;
+
+            case SIMPLE_HALF:
+                res.type = kind::REAL;
+                res.real = from_half (uint16_t (read_be<2> (take (2).data ())));
+                return res;
+
+            case SIMPLE_FLOAT: {
+                const uint32_t bits = uint32_t (read_be<4> (take (4).data ()));
+                float val;
+                memcpy (&val, &bits, sizeof (val));
+
+                res.type = kind::REAL;
+                res.real = val;
+                return res;
+            }
+
+            case SIMPLE_DOUBLE: {
+                const uint64_t bits = read_be<8> (take (8).data ());
+                memcpy (&res.real, &bits, sizeof (res.real));
+                res.type = kind::REAL;
+                return res;
+            }
+
+            case SIMPLE_BREAK:
+                res.type = kind::END;
+                return res;
+            }
+
+            throw json::error ("unsupported cbor simple value");
+        }
+
+        unreachable ();
+    } while (true);
+}
+
+
+//-----------------------------------------------------------------------------
+void
+reader::skip (const item &val)
+{
+    if (val.type != kind::ARRAY && val.type != kind::OBJECT)
+        return;
+
+    // the number of items outstanding in each open container, innermost
+    // last. this is kept on the heap rather than recursing so that hostile
+    // nesting can't exhaust the stack.
+    std::vector<size_t> outstanding;
+
+    const auto open = [&] (const item &container) {
+        if (container.length == INDEFINITE) {
+            outstanding.push_back (INDEFINITE);
+            return;
+        }
+
+        // every item occupies at least one byte, which also rules out
+        // overflow when counting the members of an object.
+        const size_t per = container.type == kind::OBJECT ? 2 : 1;
+        if (container.length > size_t (m_end - m_cursor) / per)
+            throw json::error ("truncated cbor");
+
+        outstanding.push_back (container.length * per);
+    };
+
+    open (val);
+
+    while (!outstanding.empty ()) {
+        if (outstanding.back () == 0) {
+            outstanding.pop_back ();
+            continue;
+        }
+
+        const auto child = next ();
+
+        if (child.type == kind::END) {
+            if (outstanding.back () != INDEFINITE)
+                throw json::error ("unexpected cbor break");
+
+            outstanding.pop_back ();
+            continue;
+        }
+
+        if (outstanding.back () != INDEFINITE)
+            --outstanding.back ();
+
+        if (child.type == kind::ARRAY || child.type == kind::OBJECT)
+            open (child);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+encoder::header (uint8_t major, uint64_t argument)
+{
+    if (argument < INFO_UINT8) {
+        m_data.push_back (uint8_t (major | argument));
+        return;
+    }
+
+    int width;
+    uint8_t info;
+
+    if (argument <= 0xff)            { width = 1; info = INFO_UINT8;  }
+    else if (argument <= 0xffff)     { width = 2; info = INFO_UINT16; }
+    else if (argument <= 0xffffffff) { width = 4; info = INFO_UINT32; }
+    else                             { width = 8; info = INFO_UINT64; }
+
+    m_data.push_back (major | info);
+    for (int i = width - 1; i >= 0; --i)
+        m_data.push_back (uint8_t (argument >> (i * 8)));
+}
+
+
+//-----------------------------------------------------------------------------
+encoder& encoder::begin_array  (size_t size) { header (MAJOR_ARRAY, size); return *this; }
+encoder& encoder::begin_object (size_t size) { header (MAJOR_MAP,   size); return *this; }
+
+encoder& encoder::begin_array  (void) { m_data.push_back (MAJOR_ARRAY | INFO_INDEFINITE); return *this; }
+encoder& encoder::begin_object (void) { m_data.push_back (MAJOR_MAP   | INFO_INDEFINITE); return *this; }
+
+encoder& encoder::end (void) { m_data.push_back (SIMPLE_BREAK); return *this; }
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (std::string_view str)
+{
+    header (MAJOR_STRING, str.size ());
+    m_data.insert (m_data.end (), str.begin (), str.end ());
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::bytes (util::view<const uint8_t*> data)
+{
+    header (MAJOR_BYTES, data.size ());
+    m_data.insert (m_data.end (), data.begin (), data.end ());
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (bool val)
+{
+    m_data.push_back (val ? SIMPLE_TRUE : SIMPLE_FALSE);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (std::nullptr_t)
+{
+    m_data.push_back (SIMPLE_NULL);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (uintmax_t val)
+{
+    header (MAJOR_UINT, val);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (intmax_t val)
+{
+    if (val >= 0)
+        header (MAJOR_UINT, uint64_t (val));
+    else
+        header (MAJOR_NINT, uint64_t (-1 - val));
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (double val)
+{
+    // use single precision whenever it's lossless; it's a common case for
+    // values that originated as text.
+    if (const float narrow = float (val); double (narrow) == val || std::isnan (val)) {
+        uint32_t bits;
+        memcpy (&bits, &narrow, sizeof (bits));
+
+        m_data.push_back (SIMPLE_FLOAT);
+        for (int i = 3; i >= 0; --i)
+            m_data.push_back (uint8_t (bits >> (i * 8)));
+        return *this;
+    }
+
+    uint64_t bits;
+    memcpy (&bits, &val, sizeof (bits));
+
+    m_data.push_back (SIMPLE_DOUBLE);
+    for (int i = 7; i >= 0; --i)
+        m_data.push_back (uint8_t (bits >> (i * 8)));
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the unescaped body of a string stored within a json::tree, or
+/// within a json2 event, avoiding the copy when there are no escapes.
+static std::string_view
+unescaped (std::string_view body, std::string &storage)
+{
+    if (body.find ('\\') == std::string_view::npos)
+        return body;
+
+    storage = util::json2::unescape (body);
+    return storage;
+}
+
+
+//-----------------------------------------------------------------------------
+encoder&
+encoder::value (const json::tree::node &node)
+{
+    std::string storage;
+
+    switch (node.type ()) {
+    case json::tree::OBJECT: {
+        const auto &obj = node.as_object ();
+        begin_object (obj.size ());
+        for (const auto &kv: obj) {
+            value (unescaped (kv.first, storage));
+            value (*kv.second);
+        }
+        return *this;
+    }
+
+    case json::tree::ARRAY: {
+        const auto &arr = node.as_array ();
+        begin_array (arr.size ());
+        for (const auto &i: arr)
+            value (i);
+        return *this;
+    }
+
+    case json::tree::STRING:
+        return value (unescaped (node.as_string ().native (), storage));
+
+    case json::tree::NUMBER: {
+        const auto &num = node.as_number ();
+        switch (num.repr ()) {
+        case json::tree::number::REAL: return value (double (num.real ()));
+        case json::tree::number::SINT: return value (intmax_t (num.sint ()));
+        case json::tree::number::UINT: return value (uintmax_t (num.uint ()));
+        }
+        unreachable ();
+    }
+
+    case json::tree::BOOLEAN:
+        return value (node.as_bool ());
+
+    case json::tree::NONE:
+        return value (nullptr);
+    }
+
+    unreachable ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+encoder::operator() (const util::json2::event::packet &p)
+{
+    using util::json2::event::type_t;
+
+    switch (p.type ()) {
+    case type_t::OBJECT_BEGIN: begin_object (); return;
+    case type_t::ARRAY_BEGIN:  begin_array  (); return;
+
+    case type_t::OBJECT_END:
+    case type_t::ARRAY_END:
+        end ();
+        return;
+
+    case type_t::STRING: {
+        std::string storage;
+        value (unescaped ({ p.first + 1, size_t (p.last - p.first - 2) }, storage));
+        return;
+    }
+
+    case type_t::BOOLEAN: value (*p.first == 't'); return;
+    case type_t::NONE:    value (nullptr);        return;
+
+    case type_t::NUMBER: {
+        const bool integral = std::none_of (p.first, p.last, [] (char c) {
+            return c == '.' || c == 'e' || c == 'E';
+        });
+
+        // integers that overflow 64 bits fall through to a real
+        if (integral) {
+            if (*p.first == '-') {
+                intmax_t val;
+                if (auto [ptr, ec] = std::from_chars (p.first, p.last, val); ec == std::errc () && ptr == p.last) {
+                    value (val);
+                    return;
+                }
+            } else {
+                uintmax_t val;
+                if (auto [ptr, ec] = std::from_chars (p.first, p.last, val); ec == std::errc () && ptr == p.last) {
+                    value (val);
+                    return;
+                }
+            }
+        }
+
+        value (std::strtod (std::string (p.first, p.last).c_str (), nullptr));
+        return;
+    }
+    }
+
+    unreachable ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<uint8_t>
+json::cbor::encode (const json::tree::node &node)
+{
+    encoder enc;
+    enc.value (node);
+    return std::move (enc).data ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// throws if a container at `depth` would exceed the nesting limit, so that
+// hostile input can't exhaust the stack through recursion.
+static void
+check_depth (size_t depth)
+{
+    if (depth >= json::cbor::MAX_DEPTH)
+        throw json::parse_error ("cbor nesting is too deep");
+}
+
+
+//-----------------------------------------------------------------------------
+static std::unique_ptr<json::tree::node>
+decode (reader &src, const json::cbor::item &val, size_t depth)
+{
+    using json::cbor::kind;
+    using json::cbor::INDEFINITE;
+
+    switch (val.type) {
+    case kind::UINT: return std::make_unique<json::tree::number> (json::tree::number::uint_t (val.uint));
+    case kind::SINT: return std::make_unique<json::tree::number> (json::tree::number::sint_t (val.sint));
+    case kind::REAL: return std::make_unique<json::tree::number> (json::tree::number::real_t (val.real));
+
+    case kind::BOOLEAN: return std::make_unique<json::tree::boolean> (val.boolean);
+    case kind::NONE:    return std::make_unique<json::tree::null> ();
+
+    case kind::STRING: {
+        std::string str;
+        json::escape (val.text (), str);
+        return std::make_unique<json::tree::string> (str);
+    }
+
+    case kind::BYTES:
+        throw json::type_error ("cbor byte strings have no json representation");
+
+    case kind::ARRAY: {
+        check_depth (depth);
+
+        auto arr = std::make_unique<json::tree::array> ();
+        for (size_t i = 0; i < val.length; ++i) {
+            auto child = src.next ();
+            if (child.type == kind::END) {
+                if (val.length != INDEFINITE)
+                    throw json::error ("unexpected cbor break");
+                break;
+            }
+
+            arr->insert (decode (src, child, depth + 1));
+        }
+        return arr;
+    }
+
+    case kind::OBJECT: {
+        check_depth (depth);
+
+        auto obj = std::make_unique<json::tree::object> ();
+        std::string key;
+
+        for (size_t i = 0; i < val.length; ++i) {
+            auto name = src.next ();
+            if (name.type == kind::END) {
+                if (val.length != INDEFINITE)
+                    throw json::error ("unexpected cbor break");
+                break;
+            }
+
+            if (name.type != kind::STRING)
+                throw json::type_error ("cbor object keys must be strings");
+
+            key.clear ();
+            json::escape (name.text (), key);
+            obj->insert (key, decode (src, src.next (), depth + 1));
+        }
+        return obj;
+    }
+
+    case kind::END:
+        throw json::error ("unexpected cbor break");
+    }
+
+    unreachable ();
+}
+
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<json::tree::node>
+json::cbor::decode (util::view<const uint8_t*> data)
+{
+    reader src (data);
+    return ::decode (src, src.next (), 0);
+}
+
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<json::tree::node>
+json::cbor::decode (const util::mapped_file &data)
+{
+    return decode (util::view<const uint8_t*> (data.begin (), data.end ()));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+static void
+transcode (reader &src, const json::cbor::item &val, json::writer &dst, size_t depth)
+{
+    using json::cbor::kind;
+    using json::cbor::INDEFINITE;
+
+    switch (val.type) {
+    case kind::UINT:    dst.value (val.uint);    return;
+    case kind::SINT:    dst.value (val.sint);    return;
+    case kind::REAL:    dst.value (val.real);    return;
+    case kind::BOOLEAN: dst.value (val.boolean); return;
+    case kind::NONE:    dst.value (nullptr);     return;
+    case kind::STRING:  dst.value (val.text ()); return;
+
+    case kind::BYTES:
+        dst.begin_array ();
+        for (auto b: val.data)
+            dst.value (unsigned (b));
+        dst.end_array ();
+        return;
+
+    case kind::ARRAY:
+        check_depth (depth);
+
+        dst.begin_array ();
+        for (size_t i = 0; i < val.length; ++i) {
+            auto child = src.next ();
+            if (child.type == kind::END && val.length == INDEFINITE)
+                break;
+            transcode (src, child, dst, depth + 1);
+        }
+        dst.end_array ();
+        return;
+
+    case kind::OBJECT:
+        check_depth (depth);
+
+        dst.begin_object ();
+        for (size_t i = 0; i < val.length; ++i) {
+            auto name = src.next ();
+            if (name.type == kind::END && val.length == INDEFINITE)
+                break;
+            if (name.type != kind::STRING)
+                throw json::type_error ("cbor object keys must be strings");
+
+            dst.key (name.text ());
+            transcode (src, src.next (), dst, depth + 1);
+        }
+        dst.end_object ();
+        return;
+
+    case kind::END:
+        throw json::error ("unexpected cbor break");
+    }
+
+    unreachable ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::cbor::transcode (reader &src, json::writer &dst)
+{
+    ::transcode (src, src.next (), dst, 0);
+}
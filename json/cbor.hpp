@@ -0,0 +1,201 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_CBOR_HPP
+#define __UTIL_JSON_CBOR_HPP
+
+#include "./fwd.hpp"
+
+#include "../io.hpp"
+#include "../view.hpp"
+#include "../json2/fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A binary encoding of JSON values using CBOR (RFC 7049).
+//
+// Only the subset of CBOR that maps onto JSON is produced, along with byte
+// strings for opaque data. When reading, tags are skipped, half precision
+// reals are widened, and 'undefined' is treated as null. Indefinite length
+// strings are rejected so that every string can be returned as a view into
+// the source buffer.
+namespace json::cbor {
+    enum class kind {
+        UINT,
+        SINT,
+        REAL,
+        STRING,
+        BYTES,
+        BOOLEAN,
+        NONE,
+        ARRAY,
+        OBJECT,
+        /// the terminator of an indefinite length array or object
+        END,
+    };
+
+
+    /// the length of an array or object whose extent is marked by an END
+    /// item rather than declared up front.
+    static constexpr size_t INDEFINITE = std::numeric_limits<size_t>::max ();
+
+    /// the deepest nesting of arrays and objects that decode and transcode
+    /// accept, as for the json2 incremental parser.
+    static constexpr size_t MAX_DEPTH = 1024;
+
+
+    //-------------------------------------------------------------------------
+    struct item {
+        kind type;
+
+        union {
+            uintmax_t uint;
+            intmax_t  sint;
+            double    real;
+            bool      boolean;
+            /// the number of elements of an ARRAY, or members of an OBJECT.
+            size_t    length;
+        };
+
+        /// the payload of a STRING or BYTES item, within the source buffer
+        util::view<const uint8_t*> data;
+
+        std::string_view
+        text (void) const noexcept
+        {
+            return {
+                reinterpret_cast<const char*> (data.data ()),
+                data.size ()
+            };
+        }
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Pulls items from an encoded buffer one at a time.
+    //
+    // Containers are reported by a single item holding their length; their
+    // contents follow as subsequent items. No memory is allocated and the
+    // buffer must outlive any items returned.
+    class reader {
+    public:
+        explicit reader (util::view<const uint8_t*> src) noexcept:
+            m_cursor (src.begin ()),
+            m_end (src.end ())
+        { ; }
+
+        explicit reader (const util::mapped_file &src):
+            reader (util::view<const uint8_t*> (src.begin (), src.end ()))
+        { ; }
+
+        /// returns true if there are no further bytes to read
+        bool done (void) const noexcept { return m_cursor == m_end; }
+
+        /// decodes the next item. throws json::error if the buffer is
+        /// truncated or malformed.
+        item next (void);
+
+        /// discards the contents of a container previously returned by next,
+        /// or does nothing for a scalar. throws json::error if the contents
+        /// are truncated or malformed; nesting depth is only bounded by the
+        /// size of the buffer.
+        void skip (const item&);
+
+        /// the bytes that have not yet been read
+        util::view<const uint8_t*>
+        remain (void) const noexcept
+        {
+            return { m_cursor, m_end };
+        }
+
+    private:
+        uint64_t argument (uint8_t info);
+        util::view<const uint8_t*> take (uint64_t size);
+
+        const uint8_t *m_cursor;
+        const uint8_t *m_end;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Appends encoded items to a growable buffer.
+    //
+    // Containers may either declare their size up front, or be left open
+    // and closed with a call to `end`. The encoder is also a json2 event
+    // sink, so text may be transcoded without building a tree:
+    //
+    //     json::cbor::encoder enc;
+    //     util::json2::event::parse (enc, first, last);
+    class encoder {
+    public:
+        encoder& begin_array (size_t);
+        encoder& begin_array (void);
+        encoder& begin_object (size_t);
+        encoder& begin_object (void);
+        /// closes the innermost indefinite length container
+        encoder& end (void);
+
+        encoder& value (std::string_view);
+        encoder& value (const char *str) { return value (std::string_view (str)); }
+        encoder& value (bool);
+        encoder& value (intmax_t);
+        encoder& value (uintmax_t);
+        encoder& value (int v) { return value (intmax_t (v)); }
+        encoder& value (unsigned v) { return value (uintmax_t (v)); }
+        encoder& value (double);
+        encoder& value (std::nullptr_t);
+        encoder& value (const json::tree::node&);
+
+        encoder& bytes (util::view<const uint8_t*>);
+
+        void operator() (const util::json2::event::packet&);
+
+        //---------------------------------------------------------------------
+        const std::vector<uint8_t>& data (void) const& noexcept { return m_data; }
+        std::vector<uint8_t> data (void) && noexcept { return std::move (m_data); }
+
+        void clear (void) noexcept { m_data.clear (); }
+
+    private:
+        void header (uint8_t major, uint64_t argument);
+
+        std::vector<uint8_t> m_data;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    std::vector<uint8_t> encode (const json::tree::node&);
+
+    /// builds a tree from the first encoded item in the buffer. byte strings
+    /// have no JSON equivalent and raise a json::type_error, and nesting
+    /// beyond MAX_DEPTH raises a json::parse_error.
+    std::unique_ptr<json::tree::node> decode (util::view<const uint8_t*>);
+    std::unique_ptr<json::tree::node> decode (const util::mapped_file&);
+
+    /// writes the next item from the reader as JSON text, without an
+    /// intermediate tree. byte strings are written as arrays of integers.
+    /// nesting beyond MAX_DEPTH raises a json::parse_error.
+    void transcode (reader&, json::writer&);
+}
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "compact.hpp"
+
+#include "except.hpp"
+#include "structural.hpp"
+
+#include "../debug.hpp"
+#include "../json2/string.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <vector>
+
+using json::compact::value;
+using json::compact::member;
+using json::flat::type;
+
+
+///////////////////////////////////////////////////////////////////////////////
+json::compact::layout::layout (util::view<const char*> src):
+    m_items (json::structural::parse (src)),
+    m_children (m_items.size (), 0),
+    m_count (0)
+{
+    // count the direct children of each container item
+    std::vector<size_t> stack;
+
+    for (size_t i = 0; i < m_items.size (); ++i) {
+        switch (m_items[i].tag) {
+        case type::OBJECT_END:
+        case type::ARRAY_END:
+            stack.pop_back ();
+            continue;
+
+        default:
+            break;
+        }
+
+        ++m_count;
+        if (!stack.empty ())
+            ++m_children[stack.back ()];
+
+        if (m_items[i].tag == type::OBJECT_BEGIN || m_items[i].tag == type::ARRAY_BEGIN)
+            stack.push_back (i);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace json::compact {
+    struct builder {
+        const layout &src;
+        util::alloc::raw::linear &store;
+
+        //---------------------------------------------------------------------
+        template <typename T>
+        T*
+        allocate (size_t count)
+        {
+            return reinterpret_cast<T*> (
+                store.allocate (count * sizeof (T), alignof (T))
+            );
+        }
+
+
+        //---------------------------------------------------------------------
+        /// fills `dst` from the item at `idx`, returning the index of the
+        /// item that follows it.
+        size_t
+        build (value &dst, size_t idx)
+        {
+            const auto &item = src.m_items[idx];
+            dst.m_escaped = false;
+            dst.m_size = 0;
+
+            switch (item.tag) {
+            case type::NUL:
+                dst.m_tag = kind::NUL;
+                return idx + 1;
+
+            case type::BOOLEAN:
+                dst.m_tag = kind::BOOLEAN;
+                dst.m_boolean = *item.first == 't';
+                return idx + 1;
+
+            case type::INTEGER: {
+                dst.m_tag = kind::INTEGER;
+                auto const res = std::from_chars (item.first, item.last, dst.m_integer);
+                if (res.ec == std::errc () && res.ptr == item.last)
+                    return idx + 1;
+
+                // too large for an integer, or written with an exponent (eg,
+                // 1e5); fall back to a real
+                [[fallthrough]];
+            }
+
+            case type::REAL:
+                dst.m_tag = kind::REAL;
+                std::from_chars (item.first, item.last, dst.m_real);
+                return idx + 1;
+
+            case type::STRING:
+                dst.m_tag = kind::STRING;
+                dst.m_string = item.first + 1;
+                dst.m_size = uint32_t (item.last - item.first - 2);
+                dst.m_escaped = std::find (item.first + 1, item.last - 1, '\\') != item.last - 1;
+                return idx + 1;
+
+            case type::ARRAY_BEGIN: {
+                const uint32_t count = src.m_children[idx];
+                auto elements = allocate<value> (count);
+
+                dst.m_tag = kind::ARRAY;
+                dst.m_size = count;
+                dst.m_elements = elements;
+
+                ++idx;
+                for (uint32_t i = 0; i < count; ++i)
+                    idx = build (elements[i], idx);
+
+                CHECK_EQ (src.m_items[idx].tag, type::ARRAY_END);
+                return idx + 1;
+            }
+
+            case type::OBJECT_BEGIN: {
+                const uint32_t count = src.m_children[idx] / 2;
+                auto members = allocate<member> (count);
+
+                dst.m_tag = kind::OBJECT;
+                dst.m_size = count;
+                dst.m_members = members;
+
+                ++idx;
+                for (uint32_t i = 0; i < count; ++i) {
+                    idx = build (members[i].key, idx);
+                    idx = build (members[i].val, idx);
+                }
+
+                CHECK_EQ (src.m_items[idx].tag, type::OBJECT_END);
+                return idx + 1;
+            }
+
+            case type::UNKNOWN:
+            case type::OBJECT_END:
+            case type::ARRAY_END:
+                break;
+            }
+
+            unreachable ();
+        }
+
+
+        //---------------------------------------------------------------------
+        const value&
+        operator() (void)
+        {
+            auto root = allocate<value> (1);
+            build (*root, 0);
+            return *root;
+        }
+    };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+bool
+value::as_boolean (void) const
+{
+    if (!is_boolean ())
+        throw json::type_error ("value is not a boolean");
+    return m_boolean;
+}
+
+
+//-----------------------------------------------------------------------------
+intmax_t
+value::as_integer (void) const
+{
+    if (!is_integer ())
+        throw json::type_error ("value is not an integer");
+    return m_integer;
+}
+
+
+//-----------------------------------------------------------------------------
+double
+value::as_real (void) const
+{
+    switch (m_tag) {
+    case kind::REAL:    return m_real;
+    case kind::INTEGER: return double (m_integer);
+    default:
+        throw json::type_error ("value is not a number");
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+value::as_string (void) const
+{
+    return m_escaped ? util::json2::unescape (raw ()) : std::string (raw ());
+}
+
+
+//-----------------------------------------------------------------------------
+std::string_view
+value::raw (void) const
+{
+    if (!is_string ())
+        throw json::type_error ("value is not a string");
+    return { m_string, m_size };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+size_t
+value::size (void) const
+{
+    if (!is_array () && !is_object ())
+        throw json::type_error ("value is not a container");
+    return m_size;
+}
+
+
+//-----------------------------------------------------------------------------
+const value&
+value::operator[] (size_t idx) const
+{
+    if (!is_array ())
+        throw json::type_error ("value is not an array");
+    if (idx >= m_size)
+        throw std::out_of_range ("array index out of range");
+    return m_elements[idx];
+}
+
+
+//-----------------------------------------------------------------------------
+util::view<const value*>
+value::elements (void) const
+{
+    if (!is_array ())
+        throw json::type_error ("value is not an array");
+    return { m_elements, m_elements + m_size };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+const value*
+value::find (std::string_view key) const
+{
+    if (!is_object ())
+        throw json::type_error ("value is not an object");
+
+    for (const auto &m: members ()) {
+        if (m.key.m_escaped ? m.key.as_string () == key : m.key.raw () == key)
+            return &m.val;
+    }
+
+    return nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+const value&
+value::operator[] (std::string_view key) const
+{
+    if (auto res = find (key))
+        return *res;
+    throw json::key_error (std::string (key));
+}
+
+
+//-----------------------------------------------------------------------------
+util::view<const member*>
+value::members (void) const
+{
+    if (!is_object ())
+        throw json::type_error ("value is not an object");
+    return { m_members, m_members + m_size };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+size_t
+json::compact::required (util::view<const char*> src)
+{
+    return layout (src).bytes ();
+}
+
+
+//-----------------------------------------------------------------------------
+const value&
+json::compact::parse (util::view<const char*> src, util::alloc::raw::linear &store)
+{
+    return parse (layout (src), store);
+}
+
+
+//-----------------------------------------------------------------------------
+const value&
+json::compact::parse (const layout &src, util::alloc::raw::linear &store)
+{
+    return builder { src, store } ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+json::compact::document::document (util::view<const char*> src)
+{
+    const layout items (src);
+
+    m_buffer.reset (new std::byte[items.bytes ()]);
+    m_store  = std::make_unique<util::alloc::raw::linear> (
+        m_buffer.get (), m_buffer.get () + items.bytes ()
+    );
+
+    m_root = &builder { items, *m_store } ();
+}
@@ -0,0 +1,188 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_COMPACT_HPP
+#define __UTIL_JSON_COMPACT_HPP
+
+#include "flat.hpp"
+
+#include "../alloc/raw/linear.hpp"
+#include "../view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A read-only DOM stored as tagged values in a single linear arena.
+//
+// The children of each container are laid out contiguously, strings refer
+// directly into the source buffer and are only unescaped when requested, and
+// the whole document is released at once by resetting (or dropping) the
+// arena. The source buffer must outlive any values parsed from it.
+namespace json::compact {
+    enum class kind : uint8_t {
+        NUL,
+        BOOLEAN,
+        INTEGER,
+        REAL,
+        STRING,
+        ARRAY,
+        OBJECT,
+    };
+
+    struct member;
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    class value {
+    public:
+        kind tag (void) const noexcept { return m_tag; }
+
+        bool is_null    (void) const noexcept { return m_tag == kind::NUL;     }
+        bool is_boolean (void) const noexcept { return m_tag == kind::BOOLEAN; }
+        bool is_integer (void) const noexcept { return m_tag == kind::INTEGER; }
+        bool is_real    (void) const noexcept { return m_tag == kind::REAL;    }
+        bool is_number  (void) const noexcept { return is_integer () || is_real (); }
+        bool is_string  (void) const noexcept { return m_tag == kind::STRING;  }
+        bool is_array   (void) const noexcept { return m_tag == kind::ARRAY;   }
+        bool is_object  (void) const noexcept { return m_tag == kind::OBJECT;  }
+
+        //---------------------------------------------------------------------
+        // scalar access. these throw json::type_error on a type mismatch.
+        bool     as_boolean (void) const;
+        intmax_t as_integer (void) const;
+        double   as_real    (void) const;
+
+        /// returns the unescaped string.
+        std::string as_string (void) const;
+
+        /// returns the string as it appears in the source, without quotes
+        /// and without unescaping.
+        std::string_view raw (void) const;
+
+        /// returns true if the string contains escapes; ie, raw and
+        /// as_string may differ.
+        bool escaped (void) const noexcept { return m_escaped; }
+
+        //---------------------------------------------------------------------
+        /// returns the number of elements of an array, or members of an
+        /// object.
+        size_t size (void) const;
+
+        // array access
+        const value& operator[] (size_t idx) const;
+        util::view<const value*> elements (void) const;
+
+        // object access. find returns nullptr for missing keys, whereas the
+        // index operator throws json::key_error.
+        const value* find (std::string_view key) const;
+        const value& operator[] (std::string_view key) const;
+        bool has (std::string_view key) const { return find (key) != nullptr; }
+
+        util::view<const member*> members (void) const;
+
+    private:
+        friend struct builder;
+
+        kind     m_tag;
+        bool     m_escaped;
+        uint32_t m_size;
+
+        union {
+            bool          m_boolean;
+            intmax_t      m_integer;
+            double        m_real;
+            const char   *m_string;
+            const value  *m_elements;
+            const member *m_members;
+        };
+    };
+
+
+    //-------------------------------------------------------------------------
+    struct member {
+        value key;
+        value val;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// the scanned structure of a document, from which the exact arena size
+    /// is known before any values are built. a caller sizing its own arena
+    /// can scan once, allocate `bytes`, and then parse from the layout.
+    ///
+    /// throws json::parse_error if `src` is malformed. `src` must outlive
+    /// the layout.
+    class layout {
+    public:
+        explicit layout (util::view<const char*> src);
+
+        /// the number of bytes parsing will allocate.
+        size_t bytes (void) const noexcept { return m_count * sizeof (value); }
+
+    private:
+        friend struct builder;
+
+        std::vector<json::flat::item<const char*>> m_items;
+        std::vector<uint32_t> m_children;
+        size_t m_count;
+    };
+
+
+    //-------------------------------------------------------------------------
+    /// returns the number of bytes parsing `src` will allocate.
+    ///
+    /// this scans the document; to also parse it, construct a layout and
+    /// use its `bytes` instead to avoid scanning twice.
+    size_t required (util::view<const char*> src);
+
+    /// parses `src` into values allocated from `store`.
+    ///
+    /// throws std::bad_alloc if `store` is exhausted, and json::parse_error
+    /// if `src` is malformed.
+    const value& parse (util::view<const char*> src, util::alloc::raw::linear &store);
+
+    /// builds the values of an already scanned document from `store`.
+    ///
+    /// throws std::bad_alloc if `store` is exhausted.
+    const value& parse (const layout&, util::alloc::raw::linear &store);
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// a parsed document that owns an exactly sized arena.
+    class document {
+    public:
+        explicit document (util::view<const char*> src);
+
+        const value& root (void) const { return *m_root; }
+        const value* operator-> (void) const { return m_root; }
+
+        /// the number of bytes occupied by the arena.
+        size_t bytes (void) const { return m_store->used (); }
+
+    private:
+        std::unique_ptr<std::byte[]> m_buffer;
+        std::unique_ptr<util::alloc::raw::linear> m_store;
+        const value *m_root;
+    };
+}
+
+#endif
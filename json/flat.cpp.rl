@@ -21,10 +21,12 @@
 
 #include "debug.hpp"
 #include "json/except.hpp"
+#include "json/structural.hpp"
 #include "preprocessor.hpp"
 
 #include <deque>
 #include <iostream>
+#include <type_traits>
 
 //-----------------------------------------------------------------------------
 %%{
@@ -147,6 +149,13 @@ template <typename T>
 std::vector<json::flat::item<T>>
 json::flat::parse (const util::view<T> src)
 {
+    // contiguous buffers go through the vectorised structural index; the
+    // machine below remains for everything else, including buffers too
+    // large for the index's 32 bit offsets.
+    if constexpr (std::is_convertible_v<T, const char*>)
+        if (json::structural::indexable (src.size ()))
+            return json::structural::parse (src);
+
     auto p   = src.cbegin ();
     auto pe  = src.cend   ();
     auto eof = pe;
@@ -28,6 +28,8 @@ namespace json {
         class null;
     }
 
+    class writer;
+
     struct error;
     struct type_error;
     struct parse_error;
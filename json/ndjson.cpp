@@ -0,0 +1,161 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./ndjson.hpp"
+
+#include "./except.hpp"
+#include "./flat.hpp"
+
+#include "../debug.hpp"
+
+#include <algorithm>
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<json::ndjson::chunk>
+json::ndjson::split (util::view<const char*> data, size_t size)
+{
+    CHECK_NEZ (size);
+
+    std::vector<chunk> res;
+    size_t line = 1;
+
+    for (auto cursor = data.begin (); cursor != data.end (); ) {
+        auto remain = size_t (data.end () - cursor);
+        auto target = cursor + std::min (size, remain);
+
+        // extend the chunk to include the newline at or after the target
+        auto last = std::find (target - 1, data.end (), '\n');
+        if (last != data.end ())
+            ++last;
+
+        res.push_back ({ { cursor, last }, line });
+        line += std::count (cursor, last, '\n');
+        cursor = last;
+    }
+
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+json::ndjson::detail::for_each_line (
+    const chunk &src,
+    const std::function<void(size_t, util::view<const char*>)> &func
+) {
+    auto line = src.line;
+
+    for (auto cursor = src.data.begin (); cursor != src.data.end (); ++line) {
+        auto last = std::find (cursor, src.data.end (), '\n');
+
+        const bool blank = std::all_of (cursor, last, [] (char c) {
+            return c == ' ' || c == '\t' || c == '\r';
+        });
+
+        if (!blank)
+            func (line, { cursor, last });
+
+        cursor = last == src.data.end () ? last : last + 1;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+json::ndjson::detail::window (void)
+{
+    return 2 * std::max (1u, std::thread::hardware_concurrency ());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+json::ndjson::parse (util::job::queue &queue,
+                     util::view<const char*> data,
+                     order ordering,
+                     const std::function<void(size_t, parsed&&)> &deliver,
+                     size_t chunk_size)
+{
+    map<parsed> (
+        queue, data, ordering,
+        [] (size_t, util::view<const char*> text) -> parsed {
+            try {
+                return { json::tree::parse (text), {} };
+            } catch (const json::error &x) {
+                return { nullptr, x.what () };
+            }
+        },
+        deliver,
+        chunk_size
+    );
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::ndjson::parse (util::job::queue &queue,
+                     const util::mapped_file &src,
+                     order ordering,
+                     const std::function<void(size_t, parsed&&)> &deliver,
+                     size_t chunk_size)
+{
+    parse (queue, util::view{src}.cast<const char> (), ordering, deliver, chunk_size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<json::ndjson::failure>
+json::ndjson::validate (util::job::queue &queue,
+                        util::view<const char*> data,
+                        size_t chunk_size)
+{
+    // successful lines produce an empty message, and aren't recorded
+    std::vector<failure> res;
+
+    map<std::string> (
+        queue, data, order::UNORDERED,
+        [] (size_t, util::view<const char*> text) -> std::string {
+            try {
+                json::flat::parse (text);
+                return {};
+            } catch (const json::error &x) {
+                return x.what ();
+            }
+        },
+        [&res] (size_t line, std::string &&message) {
+            if (!message.empty ())
+                res.push_back ({ line, std::move (message) });
+        },
+        chunk_size
+    );
+
+    std::sort (res.begin (), res.end (), [] (const auto &a, const auto &b) {
+        return a.line < b.line;
+    });
+
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+std::vector<json::ndjson::failure>
+json::ndjson::validate (util::job::queue &queue,
+                        const util::mapped_file &src,
+                        size_t chunk_size)
+{
+    return validate (queue, util::view{src}.cast<const char> (), chunk_size);
+}
@@ -0,0 +1,135 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_NDJSON_HPP
+#define __UTIL_JSON_NDJSON_HPP
+
+#include "./tree.hpp"
+
+#include "../io.hpp"
+#include "../view.hpp"
+#include "../job/queue.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Newline delimited JSON; a sequence of documents with one per line.
+//
+// The input is split into chunks at line boundaries and each chunk is
+// processed by a job on a util::job::queue. Results are always delivered on
+// the calling thread, either in line order or in the order the chunks
+// complete. Only a bounded number of chunks are in flight at once so memory
+// use doesn't grow with the size of the input.
+//
+// Lines that contain only whitespace are skipped. Line numbers start at 1.
+namespace json::ndjson {
+    enum class order {
+        /// results are delivered in the order of the input lines
+        SEQUENTIAL,
+        /// results are delivered as soon as their chunk completes. lines
+        /// within a chunk are still delivered in order.
+        UNORDERED,
+    };
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+
+    //-------------------------------------------------------------------------
+    struct chunk {
+        util::view<const char*> data;
+        /// the line number of the first line within the chunk
+        size_t line;
+    };
+
+
+    /// splits the data into chunks of approximately `size` bytes, each
+    /// ending immediately after a newline (or at the end of the data).
+    std::vector<chunk>
+    split (util::view<const char*> data, size_t size = DEFAULT_CHUNK_SIZE);
+
+
+    //-------------------------------------------------------------------------
+    /// applies `work` to each line in parallel and passes each result to
+    /// `deliver` on the calling thread.
+    ///
+    /// exceptions thrown by either function are rethrown once any
+    /// outstanding jobs have completed; no further results are delivered.
+    template <typename ResultT>
+    void
+    map (util::job::queue&,
+         util::view<const char*> data,
+         order,
+         const std::function<ResultT(size_t line, util::view<const char*> text)> &work,
+         const std::function<void(size_t line, ResultT&&)> &deliver,
+         size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+
+    //-------------------------------------------------------------------------
+    struct parsed {
+        /// the document, or null if the line failed to parse
+        std::unique_ptr<json::tree::node> value;
+        /// a description of the failure if `value` is null
+        std::string error;
+    };
+
+
+    /// parses every line into a json::tree. malformed lines are reported
+    /// through parsed::error rather than by throwing.
+    void
+    parse (util::job::queue&,
+           util::view<const char*> data,
+           order,
+           const std::function<void(size_t line, parsed&&)>&,
+           size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    void
+    parse (util::job::queue&,
+           const util::mapped_file&,
+           order,
+           const std::function<void(size_t line, parsed&&)>&,
+           size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+
+    //-------------------------------------------------------------------------
+    struct failure {
+        size_t line;
+        std::string message;
+    };
+
+
+    /// checks that every line is well formed without building any trees.
+    ///
+    /// returns the malformed lines in line order; an empty result means the
+    /// input is valid.
+    std::vector<failure>
+    validate (util::job::queue&,
+              util::view<const char*> data,
+              size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    std::vector<failure>
+    validate (util::job::queue&,
+              const util::mapped_file&,
+              size_t chunk_size = DEFAULT_CHUNK_SIZE);
+}
+
+#include "./ndjson.ipp"
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifdef __UTIL_JSON_NDJSON_IPP
+#error
+#endif
+
+#define __UTIL_JSON_NDJSON_IPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace json::ndjson::detail {
+    /// calls `func` with the line number and text of each non-blank line
+    /// within the chunk.
+    void
+    for_each_line (
+        const chunk&,
+        const std::function<void(size_t, util::view<const char*>)> &func
+    );
+
+    /// the number of chunks that may be in flight at once.
+    size_t window (void);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename ResultT>
+void
+json::ndjson::map (util::job::queue &queue,
+                   util::view<const char*> data,
+                   order ordering,
+                   const std::function<ResultT(size_t, util::view<const char*>)> &work,
+                   const std::function<void(size_t, ResultT&&)> &deliver,
+                   size_t chunk_size)
+{
+    struct slot {
+        std::vector<std::pair<size_t,ResultT>> values;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    const auto chunks = split (data, chunk_size);
+    std::vector<slot> slots (chunks.size ());
+
+    // guards the slot flags, the completion order, and the finished count.
+    // workers notify while holding the lock so that the condition variable
+    // can't be destroyed underneath them once we return.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<size_t> completed;
+    size_t finished = 0;
+
+    size_t submitted = 0;
+    size_t delivered = 0;
+    const size_t window = detail::window ();
+
+    auto submit = [&] (size_t idx) {
+        queue.submit ([&, idx] () {
+            auto &target = slots[idx];
+
+            try {
+                detail::for_each_line (
+                    chunks[idx],
+                    [&] (size_t line, util::view<const char*> text) {
+                        target.values.emplace_back (line, work (line, text));
+                    }
+                );
+            } catch (...) {
+                target.error = std::current_exception ();
+            }
+
+            std::lock_guard<std::mutex> lk (mutex);
+            target.done = true;
+            completed.push_back (idx);
+            ++finished;
+            cv.notify_all ();
+        });
+    };
+
+    try {
+        while (delivered < chunks.size ()) {
+            while (submitted < chunks.size () && submitted - delivered < window)
+                submit (submitted++);
+
+            size_t idx;
+            {
+                std::unique_lock<std::mutex> lk (mutex);
+
+                if (ordering == order::SEQUENTIAL) {
+                    idx = delivered;
+                    cv.wait (lk, [&] () { return slots[idx].done; });
+                } else {
+                    cv.wait (lk, [&] () { return !completed.empty (); });
+                    idx = completed.front ();
+                    completed.pop_front ();
+                }
+            }
+
+            ++delivered;
+
+            auto &source = slots[idx];
+            if (source.error)
+                std::rethrow_exception (source.error);
+
+            for (auto &[line, value]: source.values)
+                deliver (line, std::move (value));
+
+            // release the results now rather than holding the entire
+            // output in memory until we return.
+            source.values = decltype (source.values) {};
+        }
+    } catch (...) {
+        // jobs refer to our locals so they must all finish before we unwind
+        std::unique_lock<std::mutex> lk (mutex);
+        cv.wait (lk, [&] () { return finished == submitted; });
+        throw;
+    }
+}
@@ -0,0 +1,192 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./pointer.hpp"
+
+#include "./compact.hpp"
+#include "./except.hpp"
+#include "./writer.hpp"
+
+#include <limits>
+
+using json::pointer;
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// returns the index named by an array reference token, or `fallback` if the
+/// token isn't a canonical non-negative integer. '-' names the element past
+/// the end of an array, so can never be found, and also maps to `fallback`.
+static size_t
+parse_index (std::string_view token, size_t fallback)
+{
+    if (token.empty () || token.size () > std::numeric_limits<size_t>::digits10)
+        return fallback;
+
+    // leading zeros are not permitted
+    if (token.size () > 1 && token[0] == '0')
+        return fallback;
+
+    size_t accum = 0;
+    for (auto c: token) {
+        if (c < '0' || c > '9')
+            return fallback;
+        accum = accum * 10 + size_t (c - '0');
+    }
+
+    return accum;
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the token escaped as it would be stored as a json::tree key.
+///
+/// the tree keeps the source text of its keys, so a key written with
+/// different, but equivalent, escapes (eg, "\u0041" for "A") won't match.
+static std::string
+escape_key (std::string_view token)
+{
+    std::string res;
+    json::escape (token, res);
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+pointer::pointer (std::string_view text):
+    m_text (text)
+{
+    if (text.empty ())
+        return;
+
+    if (text[0] != '/')
+        throw json::error ("json pointer must begin with '/'");
+
+    std::string name;
+
+    for (size_t pos = 1; ; ) {
+        const auto next = std::min (text.find ('/', pos), text.size ());
+
+        name.clear ();
+        for (size_t i = pos; i < next; ++i) {
+            if (text[i] != '~') {
+                name += text[i];
+                continue;
+            }
+
+            if (++i == next || (text[i] != '0' && text[i] != '1'))
+                throw json::error ("invalid escape in json pointer");
+            name += text[i] == '0' ? '~' : '/';
+        }
+
+        m_tokens.push_back ({
+            name,
+            tree::key (escape_key (name)),
+            parse_index (name, NOT_AN_INDEX)
+        });
+
+        if (next == text.size ())
+            break;
+        pos = next + 1;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+const json::tree::node*
+pointer::find (const tree::node &root) const
+{
+    const tree::node *cursor = &root;
+
+    for (const auto &t: m_tokens) {
+        switch (cursor->type ()) {
+        case tree::OBJECT: {
+            const auto &obj = cursor->as_object ();
+            auto pos = obj.find (t.key);
+            if (pos == obj.end ())
+                return nullptr;
+            cursor = pos->second.get ();
+            break;
+        }
+
+        case tree::ARRAY: {
+            const auto &arr = cursor->as_array ();
+            if (t.index >= arr.size ())
+                return nullptr;
+            cursor = &arr[t.index];
+            break;
+        }
+
+        default:
+            return nullptr;
+        }
+    }
+
+    return cursor;
+}
+
+
+//-----------------------------------------------------------------------------
+json::tree::node*
+pointer::find (tree::node &root) const
+{
+    return const_cast<tree::node*> (find (const_cast<const tree::node&> (root)));
+}
+
+
+//-----------------------------------------------------------------------------
+const json::compact::value*
+pointer::find (const compact::value &root) const
+{
+    const compact::value *cursor = &root;
+
+    for (const auto &t: m_tokens) {
+        if (cursor->is_object ()) {
+            cursor = cursor->find (t.name);
+            if (!cursor)
+                return nullptr;
+        } else if (cursor->is_array ()) {
+            if (t.index >= cursor->size ())
+                return nullptr;
+            cursor = &(*cursor)[t.index];
+        } else {
+            return nullptr;
+        }
+    }
+
+    return cursor;
+}
+
+
+//-----------------------------------------------------------------------------
+std::optional<util::json2::cursor>
+pointer::find (util::json2::cursor root) const
+{
+    std::optional<util::json2::cursor> cursor = root;
+
+    for (const auto &t: m_tokens) {
+        if (cursor->is_object ())
+            cursor = cursor->find (t.name);
+        else if (cursor->is_array () && t.index != NOT_AN_INDEX)
+            cursor = cursor->at (t.index);
+        else
+            return std::nullopt;
+
+        if (!cursor)
+            return std::nullopt;
+    }
+
+    return cursor;
+}
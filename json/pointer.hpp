@@ -0,0 +1,94 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_POINTER_HPP
+#define __UTIL_JSON_POINTER_HPP
+
+#include "./fwd.hpp"
+#include "./tree.hpp"
+
+#include "../json2/cursor.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace json {
+    namespace compact { class value; }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // An RFC 6901 JSON Pointer, eg "/a/b/3/c".
+    //
+    // The text is split and unescaped once on construction, and each
+    // reference token is prepared for every representation it may be
+    // evaluated against: an interned key for json::tree objects, and the
+    // array index if the token is a valid one.
+    //
+    // Evaluation never throws for missing members, out of range indices, or
+    // type mismatches; it reports absence in the same way as the `find`
+    // method of the representation it's evaluated against.
+    class pointer {
+    public:
+        /// throws json::error if `text` is neither empty nor begins with a
+        /// '/', or contains a '~' which isn't followed by '0' or '1'.
+        explicit pointer (std::string_view text);
+
+        /// returns the value referred to within `root`, or nullptr.
+        const tree::node* find (const tree::node &root) const;
+        tree::node* find (tree::node &root) const;
+
+        /// returns the value referred to within `root`, or nullptr.
+        const compact::value* find (const compact::value &root) const;
+
+        /// returns the value referred to within `root`, or nothing.
+        ///
+        /// may throw util::json2::parse_error if the traversed parts of the
+        /// buffer are malformed.
+        std::optional<util::json2::cursor> find (util::json2::cursor root) const;
+
+        /// the number of reference tokens; zero refers to the whole document.
+        size_t size (void) const noexcept { return m_tokens.size (); }
+
+        /// the unescaped reference token at `idx`.
+        const std::string& operator[] (size_t idx) const& { return m_tokens[idx].name; }
+
+        /// the text the pointer was constructed from.
+        const std::string& str (void) const& noexcept { return m_text; }
+
+    private:
+        static constexpr size_t NOT_AN_INDEX = ~size_t (0);
+
+        struct token {
+            /// the unescaped token
+            std::string name;
+            /// the token as it appears among json::tree keys, which retain
+            /// their JSON string escapes.
+            tree::key key;
+            /// the array index named by the token, or NOT_AN_INDEX.
+            size_t index;
+        };
+
+        std::string m_text;
+        std::vector<token> m_tokens;
+    };
+}
+
+#endif
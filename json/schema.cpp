@@ -23,7 +23,15 @@
 #include "../io.hpp"
 #include "../maths.hpp"
 
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
 #include <regex>
+#include <string>
+#include <utility>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -43,127 +51,491 @@ struct format_error : public json::schema_error {
 
 
 ///////////////////////////////////////////////////////////////////////////////
-static void validate (json::tree::node&, const json::tree::object&);
+// bitmask of the types accepted by a 'type' keyword. integers also carry the
+// NUMBER bit so that they satisfy "number".
+enum : uint8_t {
+    TYPE_OBJECT  = 1u << 0,
+    TYPE_ARRAY   = 1u << 1,
+    TYPE_STRING  = 1u << 2,
+    TYPE_NUMBER  = 1u << 3,
+    TYPE_INTEGER = 1u << 4,
+    TYPE_BOOLEAN = 1u << 5,
+    TYPE_NULL    = 1u << 6,
+
+    TYPE_ANY     = 0xff,
+};
+
+
+//-----------------------------------------------------------------------------
+static uint8_t
+type_bits (const json::tree::node &node)
+{
+    switch (node.type ()) {
+    case json::tree::OBJECT:  return TYPE_OBJECT;
+    case json::tree::ARRAY:   return TYPE_ARRAY;
+    case json::tree::STRING:  return TYPE_STRING;
+    case json::tree::BOOLEAN: return TYPE_BOOLEAN;
+    case json::tree::NONE:    return TYPE_NULL;
+    case json::tree::NUMBER:
+        return node.is_integer () ? TYPE_NUMBER | TYPE_INTEGER : TYPE_NUMBER;
+    }
+
+    unreachable ();
+}
+
+
+//-----------------------------------------------------------------------------
+// a single named type may be "integer", but the names within a list of types
+// must match the node's type name exactly.
+static uint8_t
+type_bits (const std::string &name, bool allow_integer)
+{
+    if (name == "object")   return TYPE_OBJECT;
+    if (name == "array")    return TYPE_ARRAY;
+    if (name == "string")   return TYPE_STRING;
+    if (name == "number")   return TYPE_NUMBER;
+    if (name == "boolean")  return TYPE_BOOLEAN;
+    if (name == "null")     return TYPE_NULL;
+    if (name == "integer")  return allow_integer ? TYPE_INTEGER : 0;
+
+    return 0;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
-static void
-validate (json::tree::object &node,
-          const json::tree::object &schema)
+// The compiled form of one schema object. Subschemas are referred to by
+// their index within the validator's rule table, and constraint values
+// point into the validator's private copy of the schema.
+struct json::schema::detail::rule {
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max ();
+
+    // generic
+    const json::tree::array *enumeration = nullptr;
+    uint8_t types = TYPE_ANY;
+
+    std::vector<size_t> all_of;
+    std::vector<size_t> any_of;
+    std::vector<size_t> one_of;
+    std::vector<size_t> none_of;
+
+    // object
+    struct property {
+        std::string name;
+        size_t rule;
+        const json::tree::node *fallback;
+    };
+
+    struct pattern {
+        std::regex expr;
+        size_t rule;
+    };
+
+    std::vector<property> properties;
+    std::vector<pattern> pattern_properties;
+    bool forbid_additional = false;
+    std::optional<uintmax_t> max_properties;
+    std::optional<uintmax_t> min_properties;
+    std::vector<std::string> required;
+
+    // array
+    size_t items = NONE;
+    std::vector<size_t> item_list;
+    enum {
+        ADDITIONAL_UNSPECIFIED,
+        ADDITIONAL_ALLOW,
+        ADDITIONAL_FORBID,
+        ADDITIONAL_SCHEMA,
+        ADDITIONAL_INVALID,
+    } additional_items = ADDITIONAL_UNSPECIFIED;
+    size_t additional_rule = NONE;
+    std::optional<uintmax_t> max_items;
+    std::optional<uintmax_t> min_items;
+    bool unique_items = false;
+
+    // string
+    std::optional<uintmax_t> max_length;
+    std::optional<uintmax_t> min_length;
+    std::optional<std::regex> pattern_expr;
+
+    // number
+    const json::tree::number *multiple_of = nullptr;
+    const json::tree::number *maximum = nullptr;
+    const json::tree::number *minimum = nullptr;
+    std::optional<bool> exclusive_maximum;
+    std::optional<bool> exclusive_minimum;
+};
+
+
+using json::schema::detail::rule;
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    class compiler {
+    public:
+        compiler (const json::tree::object &root, std::vector<rule> &rules):
+            m_root (root),
+            m_rules (rules)
+        { ; }
+
+        size_t compile (const json::tree::object&);
+
+    private:
+        const json::tree::object& resolve (const std::string &ref) const;
+        std::vector<size_t> compile_list (const json::tree::node&);
+
+        const json::tree::object &m_root;
+        std::vector<rule> &m_rules;
+
+        // indices of schemas that have been, or are being, compiled. this
+        // lets recursive references terminate.
+        std::map<const json::tree::object*, size_t> m_done;
+    };
+}
+
+
+//-----------------------------------------------------------------------------
+// resolves a JSON pointer fragment relative to the root schema.
+const json::tree::object&
+compiler::resolve (const std::string &ref) const
 {
-    auto properties = schema.find ("properties");
-    auto additional = schema.find ("additionalProperties");
-    auto pattern    = schema.find ("patternProperties");
+    if (ref.empty () || ref[0] != '#')
+        throw json::schema_error ("$ref");
 
-    if (properties != schema.cend ()) {
-        for (const auto &kv: properties->second->as_object ()) {
-            auto p = node.find (kv.first);
-            if (p != node.cend ())
-                validate (*p->second, kv.second->as_object ());
-            else {
-                try {
-                    node.insert (kv.first, (*kv.second)["default"].clone ());
-                    validate (node[kv.first], kv.second->as_object ());
-                    continue;
-                } catch (const json::key_error&)
-                { ; }
-
-                if (additional != schema.cend ()) {
-                    if (additional->second->is_boolean () && !additional->second->as_bool ())
-                        throw json::schema_error ("additionalProperties");
-
-                    validate (*p->second, additional->second->as_object ());
-                }
+    const json::tree::node *cursor = &m_root;
+
+    for (size_t pos = 1; pos < ref.size (); ) {
+        if (ref[pos] != '/')
+            throw json::schema_error ("$ref");
+
+        auto next = ref.find ('/', pos + 1);
+        if (next == std::string::npos)
+            next = ref.size ();
+
+        // unescape the reference token; '~1' is '/' and '~0' is '~'
+        std::string token;
+        for (size_t i = pos + 1; i < next; ++i) {
+            if (ref[i] != '~') {
+                token.push_back (ref[i]);
+                continue;
+            }
+
+            if (i + 1 == next)
+                throw json::schema_error ("$ref");
+
+            switch (ref[++i]) {
+            case '0': token.push_back ('~'); break;
+            case '1': token.push_back ('/'); break;
+            default:
+                throw json::schema_error ("$ref");
+            }
+        }
+
+        if (cursor->is_object ()) {
+            const auto &obj = cursor->as_object ();
+            auto child = obj.find (token);
+            if (child == obj.cend ())
+                throw json::schema_error ("$ref");
+            cursor = child->second.get ();
+        } else if (cursor->is_array ()) {
+            const auto &arr = cursor->as_array ();
+            size_t idx;
+            try {
+                size_t used;
+                idx = std::stoul (token, &used);
+                if (used != token.size ())
+                    throw json::schema_error ("$ref");
+            } catch (const std::logic_error&) {
+                throw json::schema_error ("$ref");
             }
+
+            if (idx >= arr.size ())
+                throw json::schema_error ("$ref");
+            cursor = &arr[idx];
+        } else {
+            throw json::schema_error ("$ref");
         }
+
+        pos = next;
     }
 
-    if (pattern != schema.cend ()) {
-        for (auto &cond: pattern->second->as_object ()) {
-            std::regex expr (cond.first, std::regex_constants::ECMAScript);
+    if (!cursor->is_object ())
+        throw json::schema_error ("$ref");
+    return cursor->as_object ();
+}
+
 
-            for (auto &props: node) {
-                if (std::regex_search (props.first, expr))
-                    validate (*props.second, cond.second->as_object ());
-            }
+//-----------------------------------------------------------------------------
+std::vector<size_t>
+compiler::compile_list (const json::tree::node &list)
+{
+    std::vector<size_t> res;
+
+    if (list.is_object ()) {
+        res.push_back (compile (list.as_object ()));
+    } else {
+        for (const auto &i: list.as_array ())
+            res.push_back (compile (i.as_object ()));
+    }
+
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+compiler::compile (const json::tree::object &schema)
+{
+    if (auto pos = m_done.find (&schema); pos != m_done.end ())
+        return pos->second;
+
+    // a reference replaces the entire schema that contains it
+    if (auto ref = schema.find ("$ref"); ref != schema.cend ()) {
+        const auto &target = resolve (ref->second->as_string ().native ());
+        if (&target == &schema)
+            throw json::schema_error ("$ref");
+
+        // reserve our slot before recursing in case the target refers back
+        // to us.
+        const auto idx = m_rules.size ();
+        m_rules.emplace_back ();
+        m_done.emplace (&schema, idx);
+
+        const auto res = compile (target);
+        m_rules[idx].all_of.push_back (res);
+        return idx;
+    }
+
+    const auto idx = m_rules.size ();
+    m_rules.emplace_back ();
+    m_done.emplace (&schema, idx);
+
+    // build the rule locally as m_rules may be reallocated as we recurse
+    rule res;
+
+    if (auto title = schema.find ("title"); title != schema.cend ())
+        if (!title->second->is_string ())
+            throw json::schema_error ("title");
+
+    if (auto description = schema.find ("description"); description != schema.cend ())
+        if (!description->second->is_string ())
+            throw json::schema_error ("description");
+
+    // generic
+    if (auto enumPos = schema.find ("enum"); enumPos != schema.cend ())
+        res.enumeration = &enumPos->second->as_array ();
+
+    if (auto type = schema.find ("type"); type != schema.cend ()) {
+        if (type->second->is_string ()) {
+            res.types = type_bits (type->second->as_string ().native (), true);
+        } else if (type->second->is_array ()) {
+            res.types = 0;
+            for (const auto &i: type->second->as_array ())
+                res.types |= type_bits (i.as_string ().native (), false);
+        } else {
+            throw json::schema_error ("type");
+        }
+    }
+
+    if (auto allOf = schema.find ("allOf"); allOf != schema.cend ())
+        res.all_of = compile_list (*allOf->second);
+    if (auto anyOf = schema.find ("anyOf"); anyOf != schema.cend ())
+        res.any_of = compile_list (*anyOf->second);
+    if (auto oneOf = schema.find ("oneOf"); oneOf != schema.cend ())
+        res.one_of = compile_list (*oneOf->second);
+    if (auto notSchema = schema.find ("not"); notSchema != schema.cend ())
+        res.none_of = compile_list (*notSchema->second);
+
+    // object
+    if (auto properties = schema.find ("properties"); properties != schema.cend ()) {
+        for (const auto &kv: properties->second->as_object ()) {
+            const auto &sub = kv.second->as_object ();
+            auto fallback = sub.find ("default");
+
+            res.properties.push_back ({
+                kv.first,
+                compile (sub),
+                fallback == sub.cend () ? nullptr : fallback->second.get ()
+            });
+        }
+    }
+
+    if (auto additional = schema.find ("additionalProperties"); additional != schema.cend ())
+        res.forbid_additional = additional->second->is_boolean () && !additional->second->as_bool ();
+
+    if (auto pattern = schema.find ("patternProperties"); pattern != schema.cend ()) {
+        for (const auto &cond: pattern->second->as_object ()) {
+            res.pattern_properties.push_back ({
+                std::regex (cond.first.str (), std::regex_constants::ECMAScript),
+                compile (cond.second->as_object ())
+            });
         }
     }
 
     if (schema.has ("dependencies"))
         not_implemented ();
 
+    if (auto maxProperties = schema.find ("maxProperties"); maxProperties != schema.cend ())
+        res.max_properties = maxProperties->second->as_uint ();
+    if (auto minProperties = schema.find ("minProperties"); minProperties != schema.cend ())
+        res.min_properties = minProperties->second->as_uint ();
+
+    if (auto required = schema.find ("required"); required != schema.cend ())
+        for (const auto &i: required->second->as_array ())
+            res.required.push_back (i.as_string ().native ());
+
+    // array
+    if (auto items = schema.find ("items"); items != schema.cend ()) {
+        if (items->second->is_object ()) {
+            res.items = compile (items->second->as_object ());
+        } else if (items->second->is_array ()) {
+            for (const auto &i: items->second->as_array ())
+                res.item_list.push_back (compile (i.as_object ()));
+
+            auto additional = schema.find ("additionalItems");
+            if (additional == schema.cend ()) {
+                res.additional_items = rule::ADDITIONAL_UNSPECIFIED;
+            } else if (additional->second->is_boolean ()) {
+                res.additional_items = additional->second->as_bool ()
+                    ? rule::ADDITIONAL_ALLOW
+                    : rule::ADDITIONAL_FORBID;
+            } else if (additional->second->is_object ()) {
+                res.additional_items = rule::ADDITIONAL_SCHEMA;
+                res.additional_rule = compile (additional->second->as_object ());
+            } else {
+                res.additional_items = rule::ADDITIONAL_INVALID;
+            }
+        }
+    }
+
+    if (auto maxItems = schema.find ("maxItems"); maxItems != schema.cend ())
+        res.max_items = maxItems->second->as_uint ();
+    if (auto minItems = schema.find ("minItems"); minItems != schema.cend ())
+        res.min_items = minItems->second->as_uint ();
+
+    if (auto unique = schema.find ("uniqueItems"); unique != schema.cend ())
+        res.unique_items = unique->second->as_boolean ();
+
+    // string
+    if (auto maxLength = schema.find ("maxLength"); maxLength != schema.cend ())
+        res.max_length = maxLength->second->as_number ().uint ();
+    if (auto minLength = schema.find ("minLength"); minLength != schema.cend ())
+        res.min_length = minLength->second->as_number ().uint ();
+
+    // Note: this uses the c++11 regex engine which slightly differs from ECMA 262
+    if (auto pattern = schema.find ("pattern"); pattern != schema.cend ())
+        res.pattern_expr.emplace (
+            pattern->second->as_string ().native (),
+            std::regex_constants::ECMAScript
+        );
+
+    // number
+    if (auto mult = schema.find ("multipleOf"); mult != schema.cend ())
+        res.multiple_of = &mult->second->as_number ();
+    if (auto max = schema.find ("maximum"); max != schema.cend ())
+        res.maximum = &max->second->as_number ();
+    if (auto min = schema.find ("minimum"); min != schema.cend ())
+        res.minimum = &min->second->as_number ();
+    if (auto exclusiveMax = schema.find ("exclusiveMaximum"); exclusiveMax != schema.cend ())
+        res.exclusive_maximum = exclusiveMax->second->as_boolean ();
+    if (auto exclusiveMin = schema.find ("exclusiveMinimum"); exclusiveMin != schema.cend ())
+        res.exclusive_minimum = exclusiveMin->second->as_boolean ();
+
+    m_rules[idx] = std::move (res);
+    return idx;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+static void validate (json::tree::node&, const std::vector<rule>&, size_t);
+
+
+///////////////////////////////////////////////////////////////////////////////
+static void
+validate (json::tree::object &node,
+          const std::vector<rule> &rules,
+          const rule &schema)
+{
+    for (const auto &prop: schema.properties) {
+        auto p = node.find (prop.name);
+        if (p != node.cend ()) {
+            validate (*p->second, rules, prop.rule);
+        } else if (prop.fallback) {
+            node.insert (prop.name, prop.fallback->clone ());
+            validate (node[prop.name], rules, prop.rule);
+        } else if (schema.forbid_additional) {
+            throw json::schema_error ("additionalProperties");
+        }
+    }
+
+    for (const auto &cond: schema.pattern_properties) {
+        for (auto &props: node) {
+            if (std::regex_search (props.first.str (), cond.expr))
+                validate (*props.second, rules, cond.rule);
+        }
+    }
+
     // properties must be checked after the 'properties' check has a chance to
     // create the defaulted entries.
-    auto maxProperties = schema.find ("maxProperties");
-    if (maxProperties != schema.cend ())
-        if (node.size () > maxProperties->second->as_uint ())
-            throw json::schema_error ("maxProperties");
-
-    auto minProperties = schema.find ("minProperties");
-    if (minProperties != schema.cend ())
-        if (node.size () < minProperties->second->as_uint ())
-            throw json::schema_error ("minProperties");
-
-    auto required = schema.find ("required");
-    if (required != schema.cend ())
-        for (const auto &i: required->second->as_array ())
-            if (!node.has (i.as_string ()))
-                throw json::schema_error ("required");
+    if (schema.max_properties && node.size () > *schema.max_properties)
+        throw json::schema_error ("maxProperties");
+
+    if (schema.min_properties && node.size () < *schema.min_properties)
+        throw json::schema_error ("minProperties");
+
+    for (const auto &i: schema.required)
+        if (!node.has (i))
+            throw json::schema_error ("required");
 }
 
 
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::array &node,
-          const json::tree::object &schema)
+          const std::vector<rule> &rules,
+          const rule &schema)
 {
-    // attempt to match the item and additionalItem schemas
-    auto items = schema.find ("items");
-    auto additional = schema.find ("additionalItems");
+    // items is an object, test all elements with it as a schema
+    if (schema.items != rule::NONE) {
+        for (auto &i: node)
+            validate (i, rules, schema.items);
+    // items is a list of schemas, test n-elements with it as a schema
+    } else if (!schema.item_list.empty ()) {
+        size_t i = 0;
+        for (; i < schema.item_list.size () && i < node.size (); ++i)
+            validate (node[i], rules, schema.item_list[i]);
+
+        // we've exhausted the schema list, use the additional schema
+        if (i == schema.item_list.size ()) {
+            switch (schema.additional_items) {
+            case rule::ADDITIONAL_UNSPECIFIED:
+            case rule::ADDITIONAL_ALLOW:
+                break;
 
-    if (items != schema.cend ()) {
-        // items is an object, test all elements with it as a schema
-        if (items->second->is_object ()) {
-            for (auto &i: node)
-                validate (i, items->second->as_object ());
-        // items is a list of schemas, test n-elements with it as a schema
-        } else if (items->second->is_array ()) {
-            const auto &itemArray = items->second->as_array ();
-
-            size_t i = 0;
-            for (; i < itemArray.size () && i < node.size (); ++i)
-                validate (node[i], itemArray[i].as_object ());
-
-            // we've exhausted the schema list, use the additional schema
-            if (i == itemArray.size ()) {
-                if (additional->second->is_boolean ()) {
-                    if (!additional->second->as_boolean ())
-                        throw json::schema_error ("additional");
-                } else if (additional->second->is_object ()) {
-                    for ( ; i < node.size (); ++i)
-                        validate (node[i], additional->second->as_object ());
-                } else {
-                    throw json::schema_error ("items");
-                }
+            case rule::ADDITIONAL_FORBID:
+                throw json::schema_error ("additional");
+
+            case rule::ADDITIONAL_SCHEMA:
+                for ( ; i < node.size (); ++i)
+                    validate (node[i], rules, schema.additional_rule);
+                break;
+
+            case rule::ADDITIONAL_INVALID:
+                throw json::schema_error ("items");
             }
         }
     }
 
-    auto maxItems = schema.find ("maxItems");
-    if (maxItems != schema.cend ())
-        if (node.size () > maxItems->second->as_uint ())
-            throw json::schema_error ("maxItems");
+    if (schema.max_items && node.size () > *schema.max_items)
+        throw json::schema_error ("maxItems");
 
-    auto minItems = schema.find ("minItems");
-    if (minItems != schema.cend ())
-        if (node.size () < minItems->second->as_uint ())
-            throw json::schema_error ("minItems");
+    if (schema.min_items && node.size () < *schema.min_items)
+        throw json::schema_error ("minItems");
 
     // check all element are unique
     // XXX: uses a naive n^2 brute force search on equality because it's 2am
     // and I don't want to write a type aware comparator for the sort.
-    auto unique = schema.find ("uniqueItems");
-    if (unique != schema.cend () && unique->second->as_boolean ())
+    if (schema.unique_items)
         for (size_t a = 0; a < node.size (); ++a)
             for (size_t b = a + 1; b < node.size (); ++b)
                 if (node[a] == node[b])
@@ -174,54 +546,34 @@ validate (json::tree::array &node,
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::string &node,
-          const json::tree::object &schema)
+          const std::vector<rule>&,
+          const rule &schema)
 {
     const auto &val = node.native ();
 
     // check length is less than a maximum
-    auto maxLength = schema.find ("maxLength");
-    if (maxLength != schema.cend ()) {
-        auto cmp = maxLength->second->as_number ().uint ();
-        if (!util::is_integer (cmp))
-            throw length_error ("maxLength");
-
-        if (val.size () > cmp)
-            throw length_error ("maxLength");
-    }
+    if (schema.max_length && val.size () > *schema.max_length)
+        throw length_error ("maxLength");
 
     // check length is greater than a maximum
-    auto minLength = schema.find ("minLength");
-    if (minLength != schema.cend ()) {
-        auto cmp = minLength->second->as_number ().uint ();
-        if (!util::is_integer (cmp))
-            throw length_error ("minLength");
-
-        if (val.size () < cmp)
-            throw length_error ("minLength");
-    }
+    if (schema.min_length && val.size () < *schema.min_length)
+        throw length_error ("minLength");
 
     // check the string conforms to a regex
-    // Note: this uses the c++11 regex engine which slightly differs from ECMA 262
-    auto pattern = schema.find ("pattern");
-    if (pattern != schema.cend ()) {
-        std::regex r (pattern->second->as_string ().native (),
-                      std::regex_constants::ECMAScript);
-        if (!std::regex_search (val, r))
-            throw format_error ("pattern");
-    }
+    if (schema.pattern_expr && !std::regex_search (val, *schema.pattern_expr))
+        throw format_error ("pattern");
 }
 
 
 //-----------------------------------------------------------------------------
 template <typename T>
 static void
-validate_number (T val, const json::tree::object &schema) {
+validate_number (T val, const rule &schema) {
     using R = json::tree::number::repr_t;
 
     // check strictly positive integer multiple
-    auto mult = schema.find ("multipleOf");
-    if (mult != schema.cend ()) {
-        const auto &div = mult->second->as_number ();
+    if (schema.multiple_of) {
+        const auto &div = *schema.multiple_of;
 
         switch (div.repr ()) {
             case R::REAL:  if (util::exactly_zero (std::fmod (val, div.real ()))) throw json::schema_error ("multipleOf"); break;
@@ -231,12 +583,10 @@ validate_number (T val, const json::tree::object &schema) {
     }
 
     // check maximum holds. exclusive requires max condition.
-    auto max = schema.find ("maximum");
-    auto exclusiveMax = schema.find ("exclusiveMaximum");
-    if (max != schema.end ()) {
-        const auto &cmp = max->second->as_number ();
+    if (schema.maximum) {
+        const auto &cmp = *schema.maximum;
 
-        if (exclusiveMax != schema.end () && exclusiveMax->second->as_boolean ()) {
+        if (schema.exclusive_maximum.value_or (false)) {
             switch (cmp.repr ()) {
             case R::REAL:
                 if (T(val) >= cmp.real ())
@@ -282,17 +632,15 @@ validate_number (T val, const json::tree::object &schema) {
             }
         }
     } else {
-        if (exclusiveMax != schema.cend ())
+        if (schema.exclusive_maximum)
             throw json::schema_error ("exclusiveMax");
     }
 
     // check minimum holds. exclusive requires min condition
-    auto min = schema.find ("minimum");
-    auto exclusiveMin = schema.find ("exclusiveMinimum");
-    if (min != schema.end ()) {
-        const auto &cmp = min->second->as_number ();
+    if (schema.minimum) {
+        const auto &cmp = *schema.minimum;
 
-        if (exclusiveMin != schema.end () && exclusiveMin->second->as_boolean ()) {
+        if (schema.exclusive_minimum.value_or (false)) {
             switch (cmp.repr ()) {
             case R::REAL:
                 if (T(val) < cmp.real ())
@@ -338,7 +686,7 @@ validate_number (T val, const json::tree::object &schema) {
             }
         }
     } else {
-        if (exclusiveMin != schema.cend ())
+        if (schema.exclusive_minimum)
             throw json::schema_error ("exclusiveMin");
     }
 
@@ -348,7 +696,8 @@ validate_number (T val, const json::tree::object &schema) {
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::number &node,
-          const json::tree::object &schema)
+          const std::vector<rule>&,
+          const rule &schema)
 {
     using N = json::tree::number;
     using R = N::repr_t;
@@ -364,95 +713,48 @@ validate (json::tree::number &node,
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::boolean&,
-          const json::tree::object&)
+          const std::vector<rule>&,
+          const rule&)
 { ; }
 
 
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::null&,
-          const json::tree::object&)
+          const std::vector<rule>&,
+          const rule&)
 { ; }
 
 
-//-----------------------------------------------------------------------------
-static std::string
-to_string (json::tree::type_t t)
-{
-    switch (t) {
-        case json::tree::OBJECT:    return "object";
-        case json::tree::ARRAY:     return "array";
-        case json::tree::STRING:    return "string";
-        case json::tree::NUMBER:    return "number";
-        case json::tree::BOOLEAN:   return "boolean";
-        case json::tree::NONE:      return "null";
-    }
-
-    unreachable ();
-}
-
-
-//-----------------------------------------------------------------------------
-static bool
-is_type_valid (const json::tree::node &node, const std::string &type)
-{
-    if (type == "integer")  return node.is_integer ();
-    if (type == "number")   return node.is_number ();
-    if (type == "string")   return node.is_string ();
-    if (type == "object")   return node.is_object ();
-    if (type == "array")    return node.is_array ();
-    if (type == "boolean")  return node.is_boolean ();
-    if (type == "null")     return node.is_null ();
-
-    return false;
-}
-
-
 //-----------------------------------------------------------------------------
 static void
 validate (json::tree::node &node,
-          const json::tree::object &schema)
+          const std::vector<rule> &rules,
+          size_t idx)
 {
+    const auto &schema = rules[idx];
+
     // check the value is in the prescribed list
-    auto enumPos = schema.find ("enum");
-    if (enumPos != schema.cend ()) {
-        auto pos = std::find (enumPos->second->as_array ().cbegin (),
-                              enumPos->second->as_array ().cend (),
+    if (schema.enumeration) {
+        auto pos = std::find (schema.enumeration->cbegin (),
+                              schema.enumeration->cend (),
                               node);
-        if (pos == enumPos->second->as_array ().cend ())
+        if (pos == schema.enumeration->cend ())
             throw json::schema_error ("enum");
     }
 
     // check the value is the correct type
-    auto type = schema.find ("type");
-    if (type != schema.cend ()) {
-        // check against a single named type
-        if (type->second->is_string ()) {
-            if (!is_type_valid (node, type->second->as_string ()))
-                throw json::schema_error ("type");
-        // check against an array of types
-        } else if (type->second->is_array ()) {
-            auto pos = std::find_if (type->second->as_array ().begin (),
-                                     type->second->as_array ().end (),
-                                     [&] (const auto &i) { return i.as_string () == to_string (node.type ()); });
-            if (pos == type->second->as_array ().end ())
-                throw json::schema_error ("type");
-        } else
-            throw json::schema_error ("type");
-    }
+    if (!(schema.types & type_bits (node)))
+        throw json::schema_error ("type");
 
-    auto allOf = schema.find ("allOf");
-    if (allOf != schema.cend ()) {
-        for (const auto &i: allOf->second->as_array ())
-            validate (node, i.as_object ());
-    }
+    for (const auto &i: schema.all_of)
+        validate (node, rules, i);
 
-    auto anyOf = schema.find ("anyOf");
-    if (anyOf != schema.cend ()) {
+    if (!schema.any_of.empty ()) {
         bool success = false;
-        for (const auto &i: anyOf->second->as_array ()) {
+        for (const auto &i: schema.any_of) {
             try {
-                validate (node, i.as_object ());
+                validate (node, rules, i);
                 success = true;
                 break;
             } catch (const json::schema_error&)
@@ -463,13 +765,12 @@ validate (json::tree::node &node,
             throw json::schema_error ("anyOf");
     }
 
-    auto oneOf = schema.find ("oneOf");
-    if (oneOf != schema.cend ()) {
+    if (!schema.one_of.empty ()) {
         unsigned count = 0;
 
-        for (const auto &i: oneOf->second->as_array ()) {
+        for (const auto &i: schema.one_of) {
             try {
-                validate (node, i.as_object ());
+                validate (node, rules, i);
                 count++;
             } catch (const json::schema_error&)
             { ; }
@@ -482,50 +783,144 @@ validate (json::tree::node &node,
             throw json::schema_error ("oneOf");
     }
 
-    auto notSchema = schema.find ("not");
-    if (notSchema != schema.cend ()) {
-        for (const auto &i: notSchema->second->as_array ()) {
-            bool valid = false;
-            try {
-                validate (node, i.as_object ());
-                valid = true;
-            } catch (const json::schema_error&)
-            { ; }
+    for (const auto &i: schema.none_of) {
+        bool valid = false;
+        try {
+            validate (node, rules, i);
+            valid = true;
+        } catch (const json::schema_error&)
+        { ; }
 
-            if (valid)
-                throw json::schema_error ("not");
-        }
+        if (valid)
+            throw json::schema_error ("not");
     }
 
     switch (node.type ()) {
-        case json::tree::OBJECT:    validate (node.as_object (),     schema); return;
-        case json::tree::ARRAY:     validate (node.as_array (),      schema); return;
-        case json::tree::STRING:    validate (node.as_string (),     schema); return;
-        case json::tree::NUMBER:    validate (node.as_number (),     schema); return;
-        case json::tree::BOOLEAN:   validate (node.as_boolean (),    schema); return;
-        case json::tree::NONE:      validate (node.as_null (),       schema); return;
+        case json::tree::OBJECT:    validate (node.as_object (),  rules, schema); return;
+        case json::tree::ARRAY:     validate (node.as_array (),   rules, schema); return;
+        case json::tree::STRING:    validate (node.as_string (),  rules, schema); return;
+        case json::tree::NUMBER:    validate (node.as_number (),  rules, schema); return;
+        case json::tree::BOOLEAN:   validate (node.as_boolean (), rules, schema); return;
+        case json::tree::NONE:      validate (node.as_null (),    rules, schema); return;
     }
 
     unreachable ();
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// rejects rule tables where a rule can reach itself without descending into
+// the instance; ie, through $ref, allOf, anyOf, oneOf, or not. validating
+// against such a cycle would never terminate.
+//
+// references that pass through properties or items are fine as each step
+// consumes a level of the instance.
+static void
+check_cycles (const std::vector<rule> &rules)
+{
+    enum : uint8_t { UNVISITED, ACTIVE, FINISHED };
+    std::vector<uint8_t> state (rules.size (), UNVISITED);
+
+    // an explicit stack of (rule, next edge) pairs so that deep schemas
+    // can't exhaust the call stack.
+    std::vector<std::pair<size_t,size_t>> stack;
+
+    const auto edges = [&] (size_t idx) {
+        const auto &r = rules[idx];
+        return std::array<const std::vector<size_t>*, 4> {
+            &r.all_of, &r.any_of, &r.one_of, &r.none_of
+        };
+    };
+
+    const auto edge = [&] (size_t idx, size_t n) -> std::optional<size_t> {
+        for (const auto *list: edges (idx)) {
+            if (n < list->size ())
+                return (*list)[n];
+            n -= list->size ();
+        }
+        return std::nullopt;
+    };
+
+    for (size_t root = 0; root < rules.size (); ++root) {
+        if (state[root] != UNVISITED)
+            continue;
+
+        state[root] = ACTIVE;
+        stack.emplace_back (root, 0);
+
+        while (!stack.empty ()) {
+            auto &[idx, next] = stack.back ();
+            const auto child = edge (idx, next++);
+
+            if (!child) {
+                state[idx] = FINISHED;
+                stack.pop_back ();
+                continue;
+            }
+
+            switch (state[*child]) {
+            case ACTIVE:
+                throw json::schema_error ("$ref");
+            case FINISHED:
+                break;
+            case UNVISITED:
+                state[*child] = ACTIVE;
+                stack.emplace_back (*child, 0);
+                break;
+            }
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+json::schema::validator::validator (const json::tree::object &schema):
+    m_schema (schema.clone ())
+{
+    compiler (m_schema->as_object (), m_rules).compile (m_schema->as_object ());
+    check_cycles (m_rules);
+}
+
+
+//-----------------------------------------------------------------------------
+static std::unique_ptr<json::tree::node>
+load (const std::experimental::filesystem::path &schema_path)
+{
+    const util::mapped_file schema_data (schema_path);
+    return json::tree::parse (util::view{schema_data}.cast<const char> ());
+}
+
+
+//-----------------------------------------------------------------------------
+json::schema::validator::validator (const std::experimental::filesystem::path &schema_path):
+    m_schema (load (schema_path))
+{
+    compiler (m_schema->as_object (), m_rules).compile (m_schema->as_object ());
+    check_cycles (m_rules);
+}
+
+
+//-----------------------------------------------------------------------------
+json::schema::validator::validator (validator&&) noexcept = default;
+json::schema::validator& json::schema::validator::operator= (validator&&) noexcept = default;
+json::schema::validator::~validator () = default;
+
+
 //-----------------------------------------------------------------------------
 void
-json::schema::validate (json::tree::node &data,
-                        const json::tree::object &schema)
+json::schema::validator::validate (json::tree::node &data) const
 {
-    auto title = schema.find ("title");
-    if (title != schema.cend ())
-        if (!title->second->is_string ())
-            throw json::schema_error ("title");
+    // the root schema is always compiled first
+    ::validate (data, m_rules, 0);
+}
 
-    auto description = schema.find ("description");
-    if (description != schema.cend ())
-        if (!description->second->is_string ())
-            throw json::schema_error ("description");
 
-    return ::validate (data, schema.as_object ());
+///////////////////////////////////////////////////////////////////////////////
+void
+json::schema::validate (json::tree::node &data,
+                        const json::tree::object &schema)
+{
+    validator (schema).validate (data);
 }
 
 
@@ -534,7 +929,5 @@ void
 json::schema::validate (json::tree::node &data,
                         const std::experimental::filesystem::path &schema_path)
 {
-    const util::mapped_file schema_data (schema_path);
-    auto schema_object = json::tree::parse (util::view{schema_data}.cast<const char> ());
-    validate (data, schema_object->as_object ());
+    validator (schema_path).validate (data);
 }
@@ -20,6 +20,8 @@
 #include "fwd.hpp"
 
 #include <experimental/filesystem>
+#include <memory>
+#include <vector>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -31,6 +33,40 @@ namespace json::schema {
     // default, it will be realised in the data object.
     void validate (json::tree::node &data, const json::tree::object &schema);
     void validate (json::tree::node &data, const std::experimental::filesystem::path &schema);
+
+
+    namespace detail { struct rule; }
+
+
+    // A schema compiled once for validating many documents.
+    //
+    // The keywords of each schema object are gathered into a flat table of
+    // rules at construction: references are resolved, regular expressions
+    // are built, and constraints are extracted so that validation performs
+    // no lookups into the schema itself. The schema is copied, so the
+    // source object need not outlive the validator.
+    //
+    // Only local references ("#" and "#/json/pointer") are supported. A
+    // json::schema_error is thrown for references that loop back to a
+    // schema without descending into the instance, as they would never
+    // finish validating.
+    class validator {
+    public:
+        explicit validator (const json::tree::object &schema);
+        explicit validator (const std::experimental::filesystem::path &schema);
+
+        validator (validator&&) noexcept;
+        validator& operator= (validator&&) noexcept;
+        ~validator ();
+
+        // Throws a json::schema_error if the data does not conform. As with
+        // json::schema::validate, missing values may be defaulted.
+        void validate (json::tree::node &data) const;
+
+    private:
+        std::unique_ptr<json::tree::node> m_schema;
+        std::vector<detail::rule> m_rules;
+    };
 }
 
 #endif
@@ -0,0 +1,699 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "structural.hpp"
+
+#include "except.hpp"
+
+#include "../preprocessor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using json::flat::type;
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    /// per-block classification of the characters stage one cares about.
+    /// bit `i` of each mask refers to byte `i` of the block.
+    struct masks {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;
+        uint64_t space;
+    };
+
+
+    //-------------------------------------------------------------------------
+    void
+    classify_generic (const char *src, masks &dst) noexcept
+    {
+        dst = {};
+
+        for (unsigned i = 0; i < 64; ++i) {
+            const uint64_t bit = uint64_t{1} << i;
+
+            switch (src[i]) {
+            case '"':  dst.quote     |= bit; break;
+            case '\\': dst.backslash |= bit; break;
+
+            case '{': case '}':
+            case '[': case ']':
+            case ':': case ',':
+                dst.op |= bit;
+                break;
+
+            case ' ': case '\t': case '\n': case '\r':
+                dst.space |= bit;
+                break;
+            }
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    uint64_t
+    prefix_xor_generic (uint64_t bits) noexcept
+    {
+        bits ^= bits <<  1;
+        bits ^= bits <<  2;
+        bits ^= bits <<  4;
+        bits ^= bits <<  8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+
+#if defined(__x86_64__)
+    ///////////////////////////////////////////////////////////////////////////
+    // '[' and ']' differ from '{' and '}' only in bit 5, so or-ing it in
+    // lets one comparison catch both brackets.
+    void
+    classify_sse2 (const char *src, masks &dst) noexcept
+    {
+        dst = {};
+
+        for (unsigned i = 0; i < 4; ++i) {
+            const __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + i * 16));
+            const __m128i folded = _mm_or_si128 (v, _mm_set1_epi8 (0x20));
+
+            auto const eq = [&] (__m128i a, char c) {
+                return _mm_cmpeq_epi8 (a, _mm_set1_epi8 (c));
+            };
+
+            auto const mask = [] (__m128i a) {
+                return uint64_t (unsigned (_mm_movemask_epi8 (a)));
+            };
+
+            const __m128i op = _mm_or_si128 (
+                _mm_or_si128 (eq (folded, '{'), eq (folded, '}')),
+                _mm_or_si128 (eq (v, ':'), eq (v, ','))
+            );
+
+            const __m128i space = _mm_or_si128 (
+                _mm_or_si128 (eq (v, ' '),  eq (v, '\t')),
+                _mm_or_si128 (eq (v, '\n'), eq (v, '\r'))
+            );
+
+            dst.quote     |= mask (eq (v, '"'))  << (i * 16);
+            dst.backslash |= mask (eq (v, '\\')) << (i * 16);
+            dst.op        |= mask (op)           << (i * 16);
+            dst.space     |= mask (space)        << (i * 16);
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    inline __m256i
+    eq_avx2 (__m256i a, char c) noexcept
+    {
+        return _mm256_cmpeq_epi8 (a, _mm256_set1_epi8 (c));
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    inline uint64_t
+    mask_avx2 (__m256i a) noexcept
+    {
+        return uint64_t (uint32_t (_mm256_movemask_epi8 (a)));
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2")]]
+    void
+    classify_avx2 (const char *src, masks &dst) noexcept
+    {
+        dst = {};
+
+        for (unsigned i = 0; i < 2; ++i) {
+            const __m256i v = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (src + i * 32));
+            const __m256i folded = _mm256_or_si256 (v, _mm256_set1_epi8 (0x20));
+
+            const __m256i op = _mm256_or_si256 (
+                _mm256_or_si256 (eq_avx2 (folded, '{'), eq_avx2 (folded, '}')),
+                _mm256_or_si256 (eq_avx2 (v, ':'), eq_avx2 (v, ','))
+            );
+
+            const __m256i space = _mm256_or_si256 (
+                _mm256_or_si256 (eq_avx2 (v, ' '),  eq_avx2 (v, '\t')),
+                _mm256_or_si256 (eq_avx2 (v, '\n'), eq_avx2 (v, '\r'))
+            );
+
+            dst.quote     |= mask_avx2 (eq_avx2 (v, '"'))  << (i * 32);
+            dst.backslash |= mask_avx2 (eq_avx2 (v, '\\')) << (i * 32);
+            dst.op        |= mask_avx2 (op)                << (i * 32);
+            dst.space     |= mask_avx2 (space)             << (i * 32);
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    // a carry-less multiply by all-ones computes the running xor of every
+    // lower bit, which turns the quote mask into a mask of string interiors.
+    [[gnu::target("pclmul")]]
+    uint64_t
+    prefix_xor_clmul (uint64_t bits) noexcept
+    {
+        const __m128i v = _mm_set_epi64x (0, int64_t (bits));
+        const __m128i r = _mm_clmulepi64_si128 (v, _mm_set1_epi8 (-1), 0);
+        return uint64_t (_mm_cvtsi128_si64 (r));
+    }
+#endif
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// returns the mask of characters preceded by an odd length run of
+    /// backslashes, ie, the escaped characters.
+    ///
+    /// `carry` is set if the block ends in an odd length run so that the
+    /// next block can account for it.
+    uint64_t
+    find_escaped (uint64_t backslash, uint64_t &carry) noexcept
+    {
+        constexpr uint64_t even_bits = 0x5555555555555555ull;
+        constexpr uint64_t odd_bits  = ~even_bits;
+
+        const uint64_t starts = backslash & ~(backslash << 1);
+        const uint64_t even_start_mask = even_bits ^ carry;
+        const uint64_t even_starts = starts &  even_start_mask;
+        const uint64_t odd_starts  = starts & ~even_start_mask;
+
+        const uint64_t even_carries = backslash + even_starts;
+
+        uint64_t odd_carries;
+        const bool overflow = __builtin_add_overflow (backslash, odd_starts, &odd_carries);
+        odd_carries |= carry;
+        carry = overflow ? 1 : 0;
+
+        const uint64_t even_carry_ends = even_carries & ~backslash;
+        const uint64_t odd_carry_ends  = odd_carries  & ~backslash;
+
+        return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    template <
+        void     (*ClassifyV) (const char*, masks&) noexcept,
+        uint64_t (*PrefixV)   (uint64_t) noexcept
+    >
+    [[gnu::always_inline]]
+    inline void
+    scan (const char *src, size_t len, std::vector<uint32_t> &dst)
+    {
+        uint64_t escape_carry = 0;
+        uint64_t string_carry = 0;
+        // the start of the input behaves as if preceded by whitespace
+        uint64_t scalar_carry = 1;
+
+        char tail[64];
+
+        for (size_t base = 0; base < len; base += 64) {
+            const char *block = src + base;
+            if (len - base < 64) {
+                std::fill (std::copy (block, src + len, tail), std::end (tail), ' ');
+                block = tail;
+            }
+
+            masks m;
+            ClassifyV (block, m);
+
+            const uint64_t quote = m.quote & ~find_escaped (m.backslash, escape_carry);
+
+            // covers each opening quote and the string body, but not the
+            // closing quote.
+            const uint64_t inside = PrefixV (quote) ^ string_carry;
+            string_carry = uint64_t (int64_t (inside) >> 63);
+
+            uint64_t structurals = (m.op & ~inside) | quote;
+
+            // scalars start at any non-space outside of a string that
+            // follows a space or a structural character.
+            const uint64_t pred = structurals | m.space;
+            const uint64_t scalars = ((pred << 1) | scalar_carry) & ~m.space & ~inside;
+            scalar_carry = pred >> 63;
+
+            structurals |= scalars;
+            structurals &= ~(quote & ~inside);
+
+            while (structurals) {
+                dst.push_back (uint32_t (base + __builtin_ctzll (structurals)));
+                structurals &= structurals - 1;
+            }
+        }
+
+        if (string_carry)
+            throw json::parse_error ("unterminated string");
+    }
+
+
+    //-------------------------------------------------------------------------
+    using index_t = void (*) (const char*, size_t, std::vector<uint32_t>&);
+
+
+    //-------------------------------------------------------------------------
+    void
+    index_generic (const char *src, size_t len, std::vector<uint32_t> &dst)
+    {
+        scan<classify_generic, prefix_xor_generic> (src, len, dst);
+    }
+
+
+#if defined(__x86_64__)
+    //-------------------------------------------------------------------------
+    void
+    index_sse2 (const char *src, size_t len, std::vector<uint32_t> &dst)
+    {
+        scan<classify_sse2, prefix_xor_generic> (src, len, dst);
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("sse2,pclmul")]]
+    void
+    index_clmul (const char *src, size_t len, std::vector<uint32_t> &dst)
+    {
+        scan<classify_sse2, prefix_xor_clmul> (src, len, dst);
+    }
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("avx2,pclmul")]]
+    void
+    index_avx2 (const char *src, size_t len, std::vector<uint32_t> &dst)
+    {
+        scan<classify_avx2, prefix_xor_clmul> (src, len, dst);
+    }
+#endif
+
+
+    //-------------------------------------------------------------------------
+    index_t
+    select_index (void)
+    {
+#if defined(__x86_64__)
+        __builtin_cpu_init ();
+
+        if (__builtin_cpu_supports ("pclmul")) {
+            if (__builtin_cpu_supports ("avx2"))
+                return index_avx2;
+            return index_clmul;
+        }
+
+        if (__builtin_cpu_supports ("sse2"))
+            return index_sse2;
+
+        return index_generic;
+#else
+        return index_generic;
+#endif
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<uint32_t>
+json::structural::index (util::view<const char*> src)
+{
+    if (!indexable (src.size ()))
+        throw json::parse_error ("input too large to index");
+
+    static const index_t s_index = select_index ();
+
+    std::vector<uint32_t> res;
+    res.reserve (src.size () / 8);
+    s_index (src.begin (), src.size (), res);
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stage two: scalar validation
+namespace {
+    constexpr bool
+    is_space (char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+
+    //-------------------------------------------------------------------------
+    constexpr bool
+    is_digit (char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+
+    //-------------------------------------------------------------------------
+    constexpr bool
+    is_xdigit (char c)
+    {
+        return is_digit (c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// returns the length of the multibyte UTF-8 sequence at `cursor`, or
+    /// zero if it is malformed.
+    ///
+    /// this follows RFC 3629 exactly, as the flat parser's grammar does: the
+    /// lead byte and the bounds of the second byte exclude overlong forms,
+    /// surrogates, and values beyond U+10FFFF.
+    int
+    utf8_sequence (const char *cursor, const char *last)
+    {
+        const auto byte = [&] (int i) { return uint8_t (cursor[i]); };
+        const auto tail = [&] (int i) { return (byte (i) & 0xC0) == 0x80; };
+
+        const auto lead = byte (0);
+        int len;
+        uint8_t lo = 0x80, hi = 0xBF;
+
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            len = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            len = 3;
+            if (lead == 0xE0) lo = 0xA0;
+            if (lead == 0xED) hi = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            len = 4;
+            if (lead == 0xF0) lo = 0x90;
+            if (lead == 0xF4) hi = 0x8F;
+        } else {
+            return 0;
+        }
+
+        if (last - cursor < len)
+            return 0;
+        if (byte (1) < lo || byte (1) > hi)
+            return 0;
+        for (int i = 2; i < len; ++i)
+            if (!tail (i))
+                return 0;
+
+        return len;
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// validates the body of a string, excluding the quotes.
+    bool
+    valid_string (const char *first, const char *last)
+    {
+        for (auto cursor = first; cursor != last; ++cursor) {
+            if (*cursor & 0x80) {
+                const auto len = utf8_sequence (cursor, last);
+                if (!len)
+                    return false;
+                cursor += len - 1;
+                continue;
+            }
+
+            if (*cursor != '\\')
+                continue;
+
+            if (++cursor == last)
+                return false;
+
+            switch (*cursor) {
+            case '"': case '\\': case '/':
+            case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+
+            case 'u':
+                if (last - cursor < 5)
+                    return false;
+                for (int i = 1; i <= 4; ++i)
+                    if (!is_xdigit (cursor[i]))
+                        return false;
+                cursor += 4;
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    //-------------------------------------------------------------------------
+    /// returns INTEGER or REAL for valid numbers, or UNKNOWN otherwise.
+    type
+    classify_number (const char *first, const char *last)
+    {
+        auto cursor = first;
+        if (cursor != last && *cursor == '-')
+            ++cursor;
+
+        if (cursor == last)
+            return type::UNKNOWN;
+
+        if (*cursor == '0') {
+            ++cursor;
+        } else if (is_digit (*cursor)) {
+            while (cursor != last && is_digit (*cursor))
+                ++cursor;
+        } else {
+            return type::UNKNOWN;
+        }
+
+        auto tag = type::INTEGER;
+
+        if (cursor != last && *cursor == '.') {
+            tag = type::REAL;
+
+            auto const digits = ++cursor;
+            while (cursor != last && is_digit (*cursor))
+                ++cursor;
+            if (cursor == digits)
+                return type::UNKNOWN;
+        }
+
+        // as in the flat parser only a fraction makes a number real, so
+        // eg "1e5" is an integer.
+        if (cursor != last && (*cursor == 'e' || *cursor == 'E')) {
+            if (++cursor != last && (*cursor == '+' || *cursor == '-'))
+                ++cursor;
+
+            auto const digits = cursor;
+            while (cursor != last && is_digit (*cursor))
+                ++cursor;
+            if (cursor == digits)
+                return type::UNKNOWN;
+        }
+
+        return cursor == last ? tag : type::UNKNOWN;
+    }
+
+
+    //-------------------------------------------------------------------------
+    type
+    classify_scalar (const char *first, const char *last)
+    {
+        const auto len = last - first;
+
+        switch (*first) {
+        case 't':
+            return len == 4 && !memcmp (first, "true",  4) ? type::BOOLEAN : type::UNKNOWN;
+        case 'f':
+            return len == 5 && !memcmp (first, "false", 5) ? type::BOOLEAN : type::UNKNOWN;
+        case 'n':
+            return len == 4 && !memcmp (first, "null",  4) ? type::NUL     : type::UNKNOWN;
+        }
+
+        return classify_number (first, last);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+std::vector<json::flat::item<T>>
+json::structural::parse (const util::view<T> src)
+{
+    const char *const first = src.begin ();
+    const size_t len = src.size ();
+
+    auto const error = [&] (size_t offset) {
+        return json::parse_error (
+            "parse error",
+            size_t (std::count (first, first + offset, '\n'))
+        );
+    };
+
+    auto const indices = index ({ first, first + len });
+
+    std::vector<flat::item<T>> parsed;
+    parsed.reserve (indices.size ());
+
+    // the containers we are currently nested within, as their opening
+    // character.
+    std::vector<char> stack;
+
+    enum {
+        VALUE,
+        VALUE_OR_CLOSE,
+        KEY,
+        KEY_OR_CLOSE,
+        COLON,
+        NEXT,
+        DONE,
+    } state = VALUE;
+
+    for (size_t i = 0; i < indices.size (); ++i) {
+        const size_t pos = indices[i];
+        const size_t next = i + 1 < indices.size () ? indices[i + 1] : len;
+        const char c = first[pos];
+
+        T const here = src.begin () + pos;
+
+        auto const close = [&] (char open, type tag) {
+            if (stack.empty () || stack.back () != open)
+                throw error (pos);
+
+            stack.pop_back ();
+            parsed.push_back ({ tag, here, here + 1 });
+            state = stack.empty () ? DONE : NEXT;
+        };
+
+        auto const string = [&] {
+            auto end = next;
+            while (end > pos + 1 && is_space (first[end - 1]))
+                --end;
+
+            if (end < pos + 2 || first[end - 1] != '"')
+                throw error (pos);
+            if (!valid_string (first + pos + 1, first + end - 1))
+                throw error (pos);
+
+            parsed.push_back ({ type::STRING, here, src.begin () + end });
+        };
+
+        switch (state) {
+        case VALUE_OR_CLOSE:
+            if (c == ']') {
+                close ('[', type::ARRAY_END);
+                break;
+            }
+            [[fallthrough]];
+
+        case VALUE:
+            switch (c) {
+            case '{':
+                parsed.push_back ({ type::OBJECT_BEGIN, here, here + 1 });
+                stack.push_back (c);
+                state = KEY_OR_CLOSE;
+                break;
+
+            case '[':
+                parsed.push_back ({ type::ARRAY_BEGIN, here, here + 1 });
+                stack.push_back (c);
+                state = VALUE_OR_CLOSE;
+                break;
+
+            case '}': case ']': case ':': case ',':
+                throw error (pos);
+
+            case '"':
+                string ();
+                state = stack.empty () ? DONE : NEXT;
+                break;
+
+            default: {
+                auto end = next;
+                while (end > pos && is_space (first[end - 1]))
+                    --end;
+
+                auto const tag = classify_scalar (first + pos, first + end);
+                if (tag == type::UNKNOWN)
+                    throw error (pos);
+
+                parsed.push_back ({ tag, here, src.begin () + end });
+                state = stack.empty () ? DONE : NEXT;
+                break;
+            }
+            }
+            break;
+
+        case KEY_OR_CLOSE:
+            if (c == '}') {
+                close ('{', type::OBJECT_END);
+                break;
+            }
+            [[fallthrough]];
+
+        case KEY:
+            if (c != '"')
+                throw error (pos);
+            string ();
+            state = COLON;
+            break;
+
+        case COLON:
+            if (c != ':')
+                throw error (pos);
+            state = VALUE;
+            break;
+
+        case NEXT:
+            switch (c) {
+            case ',': state = stack.back () == '{' ? KEY : VALUE; break;
+            case ']': close ('[', type::ARRAY_END);  break;
+            case '}': close ('{', type::OBJECT_END); break;
+            default:
+                throw error (pos);
+            }
+            break;
+
+        case DONE:
+            throw error (pos);
+        }
+    }
+
+    if (state != DONE)
+        throw error (len);
+
+    return parsed;
+}
+
+
+//-----------------------------------------------------------------------------
+#define INSTANTIATE(KLASS)                  \
+template                                    \
+std::vector<json::flat::item<KLASS>>        \
+json::structural::parse (util::view<KLASS>);
+
+MAP0(INSTANTIATE,
+    const char* restrict,
+    const char*,
+    char *restrict,
+    char *
+)
+
+#undef INSTANTIATE
@@ -0,0 +1,64 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_STRUCTURAL_HPP
+#define __UTIL_JSON_STRUCTURAL_HPP
+
+#include "flat.hpp"
+
+#include "../view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A two stage parser for contiguous JSON buffers, after simdjson.
+//
+// Stage one classifies the input in 64 byte blocks and records the offset of
+// every structural character outside of strings, every opening quote, and
+// the first byte of every other scalar. Stage two walks those offsets to
+// check the grammar, and only inspects the bytes between them to validate
+// the scalars.
+namespace json::structural {
+    /// the largest input that can be indexed with 32 bit offsets.
+    static constexpr size_t MAX_SIZE = std::numeric_limits<uint32_t>::max ();
+
+    /// returns whether `size` bytes can be indexed; larger inputs must be
+    /// parsed by some other means, eg the json::flat state machine.
+    constexpr bool indexable (size_t size) noexcept { return size <= MAX_SIZE; }
+
+
+    /// returns the byte offsets of the structural positions within `src`.
+    ///
+    /// throws json::parse_error if a string is left unterminated, or if the
+    /// input is too large to be indexed with 32 bit offsets.
+    std::vector<uint32_t>
+    index (util::view<const char*> src);
+
+
+    /// parses the contiguous buffer `src` into the same item stream that
+    /// json::flat::parse would produce.
+    ///
+    /// instantiated for char pointer types only.
+    template <typename T>
+    std::vector<json::flat::item<T>>
+    parse (util::view<T> src);
+}
+
+#endif
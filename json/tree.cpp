@@ -21,15 +21,21 @@
 #include "flat.hpp"
 
 #include "../debug.hpp"
+#include "../hash/fnv1a.hpp"
 #include "../io.hpp"
 #include "../maths.hpp"
 #include "../stream.hpp"
+#include "../json2/event.hpp"
+#include "../json2/incremental.hpp"
+#include "../posix/fd.hpp"
 
 #include "preprocessor.hpp"
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <iomanip>
+#include <optional>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +82,7 @@ static
 typename std::vector<json::flat::item<T>>::const_iterator
 parse (typename std::vector<json::flat::item<T>>::const_iterator first,
        typename std::vector<json::flat::item<T>>::const_iterator last,
+       json::tree::interner &keys,
        std::unique_ptr<json::tree::node> &output);
 
 
@@ -85,6 +92,7 @@ static
 typename std::vector<json::flat::item<T>>::const_iterator
 parse (typename std::vector<json::flat::item<T>>::const_iterator first,
        typename std::vector<json::flat::item<T>>::const_iterator last,
+       json::tree::interner &keys,
        json::tree::array &parent)
 {
     for (auto cursor = first; cursor != last; ) {
@@ -92,7 +100,7 @@ parse (typename std::vector<json::flat::item<T>>::const_iterator first,
             return cursor + 1;
 
         std::unique_ptr<json::tree::node> value;
-        cursor = ::parse<T> (cursor, last, value);
+        cursor = ::parse<T> (cursor, last, keys, value);
         parent.insert (std::move (value));
     }
 
@@ -106,6 +114,7 @@ static
 typename std::vector<json::flat::item<T>>::const_iterator
 parse (typename std::vector<json::flat::item<T>>::const_iterator first,
        typename std::vector<json::flat::item<T>>::const_iterator last,
+       json::tree::interner &keys,
        json::tree::object &parent)
 {
     for (auto cursor = first; cursor != last; ) {
@@ -114,13 +123,16 @@ parse (typename std::vector<json::flat::item<T>>::const_iterator first,
 
         CHECK_EQ (cursor->tag, json::flat::type::STRING);
 
-        std::string key (cursor->first + 1, cursor->last - 1);
+        auto key = keys.intern ({
+            &*cursor->first + 1,
+            size_t (cursor->last - cursor->first - 2)
+        });
         ++cursor;
 
         std::unique_ptr<json::tree::node> val;
-        cursor = ::parse<T> (cursor, last, val);
+        cursor = ::parse<T> (cursor, last, keys, val);
 
-        parent.insert (key, std::move (val));
+        parent.insert (std::move (key), std::move (val));
     }
 
     unreachable ();
@@ -133,6 +145,7 @@ static
 typename std::vector<json::flat::item<T>>::const_iterator
 parse (typename std::vector<json::flat::item<T>>::const_iterator first,
        typename std::vector<json::flat::item<T>>::const_iterator last,
+       json::tree::interner &keys,
        std::unique_ptr<json::tree::node> &output)
 {
     CHECK (first != last);
@@ -185,14 +198,14 @@ parse (typename std::vector<json::flat::item<T>>::const_iterator first,
 
         case F::ARRAY_BEGIN: {
             auto value = std::make_unique<json::tree::array> ();
-            auto cursor = ::parse<T> (first + 1, last, *value);
+            auto cursor = ::parse<T> (first + 1, last, keys, *value);
             output = std::move (value);
             return cursor;
         }
 
         case F::OBJECT_BEGIN: {
             auto value = std::make_unique<json::tree::object> ();
-            auto cursor = ::parse<T> (first + 1, last, *value);
+            auto cursor = ::parse<T> (first + 1, last, keys, *value);
             output = std::move (value);
             return cursor;
         }
@@ -210,11 +223,11 @@ parse (typename std::vector<json::flat::item<T>>::const_iterator first,
 ///////////////////////////////////////////////////////////////////////////////
 template <typename T>
 std::unique_ptr<json::tree::node>
-json::tree::parse (const util::view<T> &src)
+json::tree::parse (const util::view<T> &src, interner &keys)
 {
     std::unique_ptr<json::tree::node> output;
     auto data = json::flat::parse (src);
-    auto end  = ::parse<T> (data.cbegin (), data.cend (), output);
+    auto end  = ::parse<T> (data.cbegin (), data.cend (), keys, output);
 
     CHECK (end == data.cend ());
     (void)end;
@@ -222,10 +235,24 @@ json::tree::parse (const util::view<T> &src)
     return output;
 }
 
+
+//-----------------------------------------------------------------------------
+template <typename T>
+std::unique_ptr<json::tree::node>
+json::tree::parse (const util::view<T> &src)
+{
+    interner keys;
+    return parse (src, keys);
+}
+
 #define INSTANTIATE(KLASS)          \
 template                            \
 std::unique_ptr<json::tree::node>   \
-json::tree::parse (const util::view<KLASS>&);
+json::tree::parse (const util::view<KLASS>&); \
+                                    \
+template                            \
+std::unique_ptr<json::tree::node>   \
+json::tree::parse (const util::view<KLASS>&, interner&);
 
 MAP0(INSTANTIATE,
     std::string::iterator,
@@ -244,10 +271,178 @@ std::unique_ptr<json::tree::node>
 json::tree::parse (const std::experimental::filesystem::path &src)
 {
     const util::mapped_file data (src);
+
+#ifndef PLATFORM_WIN32
+    // we make a single forward pass over the data, so encourage the kernel
+    // to read ahead aggressively and to reclaim pages behind us.
+    data.advise (MADV_SEQUENTIAL);
+#endif
+
     return parse (util::view{data}.cast<const char> ());
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    /// builds a tree from a stream of json2 events.
+    ///
+    /// packets are only valid for the duration of each call, so everything
+    /// required is copied out immediately.
+    class builder {
+    public:
+        explicit builder (json::tree::interner &_keys):
+            m_keys (_keys)
+        { ; }
+
+        void
+        operator() (const util::json2::event::packet &p)
+        {
+            using util::json2::event::type_t;
+
+            switch (p.type ()) {
+            case type_t::OBJECT_BEGIN: open (std::make_unique<json::tree::object> ()); return;
+            case type_t::ARRAY_BEGIN:  open (std::make_unique<json::tree::array>  ()); return;
+
+            case type_t::OBJECT_END:
+            case type_t::ARRAY_END:
+                CHECK (!m_stack.empty ());
+                m_stack.pop_back ();
+                return;
+
+            case type_t::STRING:
+                // the first string at each position within an object is
+                // the key of the member that follows.
+                if (!m_stack.empty () && m_stack.back ()->is_object () && !m_key) {
+                    m_key = m_keys.intern ({ p.first + 1, size_t (p.last - p.first - 2) });
+                    return;
+                }
+
+                insert (std::make_unique<json::tree::string> (p.first + 1, p.last - 1));
+                return;
+
+            case type_t::NUMBER:
+                insert (number (p.first, p.last));
+                return;
+
+            case type_t::BOOLEAN:
+                insert (std::make_unique<json::tree::boolean> (*p.first == 't'));
+                return;
+
+            case type_t::NONE:
+                insert (std::make_unique<json::tree::null> ());
+                return;
+            }
+
+            unreachable ();
+        }
+
+        std::unique_ptr<json::tree::node>
+        finish (void)
+        {
+            CHECK (m_stack.empty ());
+            return std::move (m_root);
+        }
+
+    private:
+        // numbers are classified as in the flat parser: integral unless
+        // there is a fraction or exponent.
+        static std::unique_ptr<json::tree::node>
+        number (const char *first, const char *last)
+        {
+            const bool real = std::any_of (first, last, [] (char c) {
+                return c == '.' || c == 'e' || c == 'E';
+            });
+
+            if (real)
+                return std::make_unique<json::tree::number> (std::atof (std::string (first, last).c_str ()));
+
+            const bool negative = *first == '-';
+            if (negative)
+                ++first;
+
+            uintmax_t v = 0;
+            for ( ; first != last; ++first)
+                v = v * 10 + uintmax_t (*first - '0');
+
+            if (negative)
+                return std::make_unique<json::tree::number> (-intmax_t (v));
+            return std::make_unique<json::tree::number> (v);
+        }
+
+        void
+        insert (std::unique_ptr<json::tree::node> &&value)
+        {
+            if (m_stack.empty ()) {
+                m_root = std::move (value);
+                return;
+            }
+
+            auto &parent = *m_stack.back ();
+            if (parent.is_array ()) {
+                parent.as_array ().insert (std::move (value));
+                return;
+            }
+
+            CHECK (m_key);
+            parent.as_object ().insert (std::move (*m_key), std::move (value));
+            m_key.reset ();
+        }
+
+        void
+        open (std::unique_ptr<json::tree::node> &&value)
+        {
+            auto ptr = value.get ();
+            insert (std::move (value));
+            m_stack.push_back (ptr);
+        }
+
+        json::tree::interner &m_keys;
+        std::unique_ptr<json::tree::node> m_root;
+        std::vector<json::tree::node*> m_stack;
+        std::optional<json::tree::key> m_key;
+    };
+}
+
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<json::tree::node>
+json::tree::parse_stream (util::posix::fd &src,
+                          size_t chunk_size,
+                          size_t max_token)
+{
+    CHECK_NEZ (chunk_size);
+
+    interner keys;
+    builder dst (keys);
+    const std::function<util::json2::callback_t> cb = std::ref (dst);
+
+    util::json2::event::incremental<> parser (max_token);
+    const auto buffer = std::make_unique<char[]> (chunk_size);
+
+    while (true) {
+        const auto size = src.read (buffer.get (), chunk_size);
+        if (size == 0)
+            break;
+
+        parser.feed (cb, buffer.get (), buffer.get () + size);
+    }
+
+    parser.finish (cb);
+    return dst.finish ();
+}
+
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<json::tree::node>
+json::tree::parse_stream (const std::experimental::filesystem::path &src,
+                          size_t chunk_size,
+                          size_t max_token)
+{
+    util::posix::fd fd (src, O_RDONLY | O_BINARY);
+    return parse_stream (fd, chunk_size, max_token);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 void
 json::tree::write (const json::tree::node &node, std::ostream &os)
@@ -501,6 +696,42 @@ json::tree::node::operator[] (size_t idx) const&
     { return as_array()[idx]; }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Keys
+static uint32_t
+hash_key (std::string_view key)
+{
+    return util::hash::fnv1a32 {} (key);
+}
+
+
+//-----------------------------------------------------------------------------
+json::tree::key::key (std::string_view text):
+    m_entry (std::make_shared<entry> (entry { std::string (text), hash_key (text) }))
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+std::ostream&
+json::tree::operator<< (std::ostream &os, const key &k)
+{
+    return os << k.str ();
+}
+
+
+//-----------------------------------------------------------------------------
+json::tree::key
+json::tree::interner::intern (std::string_view text)
+{
+    if (auto pos = m_keys.find (text); pos != m_keys.end ())
+        return pos->second;
+
+    key res (text);
+    m_keys.emplace (res.str (), res);
+    return res;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Object
 json::tree::object::~object ()
@@ -524,13 +755,15 @@ json::tree::object::clone (void) const
 bool
 json::tree::object::operator ==(const json::tree::object &rhs) const
 {
-    for (auto i = rhs.m_values.begin (), j = m_values.begin ();
-         i != rhs.m_values.end () && j != m_values.end ();
-         ++i, ++j)
-    {
-        if (i->first != j->first)
+    if (size () != rhs.size ())
+        return false;
+
+    // members may appear in any order, so look each one up on the right.
+    for (const auto &i: m_values) {
+        auto j = rhs.lookup (i.first);
+        if (j == rhs.m_values.size ())
             return false;
-        if ((*i->second) != (*j->second))
+        if (*i.second != *rhs.m_values[j].second)
             return false;
     }
 
@@ -538,11 +771,117 @@ json::tree::object::operator ==(const json::tree::object &rhs) const
 }
 
 
+//-----------------------------------------------------------------------------
+size_t
+json::tree::object::lookup (std::string_view name, uint32_t hash) const
+{
+    const auto mask = m_index.size () - 1;
+
+    for (size_t pos = hash & mask; m_index[pos].index; pos = (pos + 1) & mask) {
+        const auto &s = m_index[pos];
+        if (s.hash == hash && m_values[s.index - 1].first == name)
+            return s.index - 1;
+    }
+
+    return m_values.size ();
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+json::tree::object::lookup (const std::string &name) const
+{
+    if (m_index.empty ()) {
+        for (size_t i = 0; i < m_values.size (); ++i)
+            if (m_values[i].first == name)
+                return i;
+        return m_values.size ();
+    }
+
+    return lookup (name, hash_key (name));
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+json::tree::object::lookup (const key &name) const
+{
+    // interned keys usually match by identity, and otherwise the cached
+    // hash rejects most mismatches without touching the text.
+    if (m_index.empty ()) {
+        for (size_t i = 0; i < m_values.size (); ++i)
+            if (m_values[i].first == name)
+                return i;
+        return m_values.size ();
+    }
+
+    return lookup (name.str (), name.hash ());
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::tree::object::index (size_t idx)
+{
+    const auto hash = m_values[idx].first.hash ();
+    const auto mask = m_index.size () - 1;
+
+    size_t pos = hash & mask;
+    while (m_index[pos].index)
+        pos = (pos + 1) & mask;
+
+    m_index[pos] = { hash, uint32_t (idx + 1) };
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::tree::object::reindex (void)
+{
+    m_index.clear ();
+    if (m_values.size () < INDEX_THRESHOLD)
+        return;
+
+    // keep the load factor at or below one half
+    size_t capacity = 2 * INDEX_THRESHOLD;
+    while (capacity < m_values.size () * 2)
+        capacity *= 2;
+
+    m_index.resize (capacity, slot { 0, 0 });
+    for (size_t i = 0; i < m_values.size (); ++i)
+        index (i);
+}
+
+
 //-----------------------------------------------------------------------------
 void
 json::tree::object::insert (const std::string &_key, std::unique_ptr<json::tree::node> &&value)
 {
-    m_values[_key] = move(value);
+    insert (key (_key), std::move (value));
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::tree::object::insert (key _key, std::unique_ptr<json::tree::node> &&value)
+{
+    // replacing a value keeps the key's original position
+    auto pos = lookup (_key);
+    if (pos != m_values.size ()) {
+        m_values[pos].second = std::move (value);
+        return;
+    }
+
+    m_values.emplace_back (std::move (_key), std::move (value));
+
+    if (m_index.empty ()) {
+        if (m_values.size () >= INDEX_THRESHOLD)
+            reindex ();
+    } else if (m_values.size () * 2 > m_index.size ()) {
+        reindex ();
+    } else {
+        index (m_values.size () - 1);
+    }
 }
 
 
@@ -550,11 +889,11 @@ json::tree::object::insert (const std::string &_key, std::unique_ptr<json::tree:
 json::tree::node&
 json::tree::object::operator[](const std::string &key)&
 {
-    auto value = m_values.find (key);
-    if (value == m_values.end ())
+    auto pos = lookup (key);
+    if (pos == m_values.size ())
         throw json::key_error (key);
 
-    return *value->second;
+    return *m_values[pos].second;
 }
 
 
@@ -562,11 +901,11 @@ json::tree::object::operator[](const std::string &key)&
 const json::tree::node&
 json::tree::object::operator[](const std::string &key) const&
 {
-    auto value = m_values.find (key);
-    if (value == m_values.end ())
+    auto pos = lookup (key);
+    if (pos == m_values.size ())
         throw json::key_error (key);
 
-    return *value->second;
+    return *m_values[pos].second;
 }
 
 
@@ -574,7 +913,7 @@ json::tree::object::operator[](const std::string &key) const&
 bool
 json::tree::object::has (const std::string &key) const
 {
-    return m_values.find (key) != m_values.end ();
+    return lookup (key) != m_values.size ();
 }
 
 
@@ -582,7 +921,15 @@ json::tree::object::has (const std::string &key) const
 json::tree::object::const_iterator
 json::tree::object::find (const std::string &key) const
 {
-    return m_values.find (key);
+    return m_values.cbegin () + lookup (key);
+}
+
+
+//-----------------------------------------------------------------------------
+json::tree::object::const_iterator
+json::tree::object::find (const key &name) const
+{
+    return m_values.cbegin () + lookup (name);
 }
 
 
@@ -611,6 +958,7 @@ void
 json::tree::object::clear (void)
 {
     m_values.clear ();
+    m_index.clear ();
 }
 
 
@@ -618,11 +966,12 @@ json::tree::object::clear (void)
 void
 json::tree::object::erase (const std::string &key)
 {
-    auto pos = m_values.find (key);
-    if (pos == m_values.end ())
+    auto pos = lookup (key);
+    if (pos == m_values.size ())
         throw json::error ("erasing invalid key");
 
-    m_values.erase (key);
+    m_values.erase (m_values.begin () + pos);
+    reindex ();
 }
 
 
@@ -20,13 +20,19 @@
 #include "flat.hpp"
 #include "fwd.hpp"
 
+#include "../posix/fwd.hpp"
+
 #include "../iterator.hpp"
 #include "../view.hpp"
 
+#include <cstdint>
+#include <limits>
 #include <ostream>
-#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <experimental/filesystem>
@@ -43,14 +49,101 @@ namespace json::tree {
         NONE
     };
 
+    /// An immutable object member name.
+    ///
+    /// Keys are reference counted handles to a string and its hash. Copying
+    /// a key never allocates, and keys obtained from the same interner share
+    /// storage so that equal keys usually compare by identity alone.
+    class key {
+        public:
+            explicit key (std::string_view);
+
+            const std::string& str  (void) const noexcept { return m_entry->text; }
+            uint32_t           hash (void) const noexcept { return m_entry->hash; }
+
+            operator const std::string& (void) const noexcept { return str (); }
+            operator std::string_view   (void) const noexcept { return str (); }
+
+            bool operator== (const key &rhs) const noexcept
+            {
+                return m_entry == rhs.m_entry ||
+                    (hash () == rhs.hash () && str () == rhs.str ());
+            }
+
+            bool operator!= (const key &rhs) const noexcept
+                { return !(*this == rhs); }
+
+        private:
+            struct entry {
+                std::string text;
+                uint32_t hash;
+            };
+
+            std::shared_ptr<const entry> m_entry;
+    };
+
+    inline bool operator== (const key &a, std::string_view b) noexcept { return a.str () == b; }
+    inline bool operator!= (const key &a, std::string_view b) noexcept { return a.str () != b; }
+
+    std::ostream& operator<< (std::ostream&, const key&);
+
+
+    /// Deduplicates object keys across one or more parses.
+    ///
+    /// Trees built with the same interner share a single allocation for
+    /// each distinct key. Keys remain valid after the interner is cleared or
+    /// destroyed. Not thread safe; use one interner per thread.
+    class interner {
+        public:
+            key intern (std::string_view);
+
+            size_t size (void) const noexcept { return m_keys.size (); }
+            void clear (void) noexcept { m_keys.clear (); }
+
+        private:
+            // the map's own keys view the interned text, which is kept alive
+            // by the mapped value.
+            std::unordered_map<std::string_view, key> m_keys;
+    };
+
+
     /// Parse an encoded form of JSON into a tree structure
+    ///
+    /// Object keys are interned within the document. Supply an interner to
+    /// share keys between documents, eg, across a stream of messages.
     template <typename T>
     std::unique_ptr<node>
     parse (const util::view<T> &data);
 
+    template <typename T>
+    std::unique_ptr<node>
+    parse (const util::view<T> &data, interner&);
+
+    /// Parse a file in place through a read-only mapping, without copying
+    /// it into memory first.
     std::unique_ptr<node>
     parse (const std::experimental::filesystem::path &);
 
+    /// Parse a file while it is being read, holding at most `chunk_size`
+    /// bytes of the input (plus any single token that straddles a chunk)
+    /// in memory at once. Suitable for pipes and other unmappable sources.
+    ///
+    /// A token straddling chunks is carried over in a buffer of at most
+    /// `max_token` bytes. The resulting tree holds every string anyway so
+    /// by default this is unbounded; supply a limit for untrusted input.
+    ///
+    /// Throws util::json2::parse_error if the input is malformed, or if a
+    /// token exceeds `max_token` bytes.
+    std::unique_ptr<node>
+    parse_stream (util::posix::fd&,
+                  size_t chunk_size = 64 * 1024,
+                  size_t max_token = std::numeric_limits<size_t>::max ());
+
+    std::unique_ptr<node>
+    parse_stream (const std::experimental::filesystem::path&,
+                  size_t chunk_size = 64 * 1024,
+                  size_t max_token = std::numeric_limits<size_t>::max ());
+
     extern void write (const json::tree::node&, std::ostream&);
 
     /// Abstract base for all JSON values
@@ -122,12 +215,23 @@ namespace json::tree {
 
 
     /// Represents a JSON object, and contains its children.
+    ///
+    /// Members are stored contiguously in insertion order, which is also
+    /// the order they are written in. Small objects are searched linearly;
+    /// once an object reaches `INDEX_THRESHOLD` members an open addressing
+    /// hash index over the keys is maintained alongside, which reuses the
+    /// hash cached within each key.
     class object final : public node {
         private:
-            using value_store = std::map<std::string, std::unique_ptr<node>>;
+            using value_store = std::vector<
+                std::pair<key, std::unique_ptr<node>>
+            >;
 
         public:
-            typedef value_store::iterator       iterator;
+            // the keys are indexed, so they are never exposed mutably; both
+            // iterator types yield a const key. the values remain mutable
+            // through the owning pointer.
+            typedef value_store::const_iterator iterator;
             typedef value_store::const_iterator const_iterator;
 
 
@@ -145,11 +249,13 @@ namespace json::tree {
                 { return rhs == *this; }
 
             virtual void insert (const std::string &key, std::unique_ptr<node>&& value);
+            virtual void insert (key, std::unique_ptr<node>&& value);
             virtual const node& operator[] (const std::string &key) const& override;
             virtual node& operator[] (const std::string &key)& override;
             virtual bool has (const std::string&) const;
 
             virtual const_iterator find (const std::string&) const;
+            virtual const_iterator find (const key&) const;
 
             virtual const_iterator begin (void) const;
             virtual const_iterator end   (void) const;
@@ -163,8 +269,25 @@ namespace json::tree {
 
             virtual std::ostream& write (std::ostream &os) const override;
 
+            static constexpr size_t INDEX_THRESHOLD = 16;
+
         private:
+            struct slot {
+                uint32_t hash;
+                uint32_t index;
+            };
+
+            size_t lookup (std::string_view key, uint32_t hash) const;
+            size_t lookup (const std::string &key) const;
+            size_t lookup (const key&) const;
+            void reindex (void);
+            void index (size_t idx);
+
             value_store m_values;
+            // empty below the threshold. otherwise a power-of-two sized
+            // table where an index of zero marks an empty slot, and all
+            // others are offset by one.
+            std::vector<slot> m_index;
     };
 
 
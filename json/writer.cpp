@@ -0,0 +1,590 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./writer.hpp"
+
+#include "./except.hpp"
+#include "./tree.hpp"
+
+#include "../debug.hpp"
+#include "../io.hpp"
+#include "../posix/fd.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using json::writer;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the buffer is handed to the file descriptor once it exceeds this size
+static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+static constexpr size_t INITIAL_CAPACITY = 4096;
+
+
+//-----------------------------------------------------------------------------
+static constexpr char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+//-----------------------------------------------------------------------------
+/// writes the decimal digits of `val` so that they end at `last`, and
+/// returns the position of the first digit.
+static char*
+format_digits (uintmax_t val, char *last)
+{
+    while (val >= 100) {
+        auto const idx = (val % 100) * 2;
+        val /= 100;
+
+        *--last = DIGIT_PAIRS[idx + 1];
+        *--last = DIGIT_PAIRS[idx + 0];
+    }
+
+    if (val >= 10) {
+        *--last = DIGIT_PAIRS[val * 2 + 1];
+        *--last = DIGIT_PAIRS[val * 2 + 0];
+    } else {
+        *--last = char ('0' + val);
+    }
+
+    return last;
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the number of leading bytes that don't require escaping.
+static size_t
+clean_prefix (const char *first, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8 ('"');
+    const __m128i slash = _mm_set1_epi8 ('\\');
+    // control characters are below 0x20. flipping the sign bit lets us use
+    // a signed comparison to find them without catching bytes above 0x7f.
+    const __m128i bias  = _mm_set1_epi8 (char (0x80));
+    const __m128i limit = _mm_set1_epi8 (char (0x20 ^ 0x80));
+
+    for ( ; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (first + i));
+
+        const __m128i special = _mm_or_si128 (
+            _mm_or_si128 (
+                _mm_cmpeq_epi8 (v, quote),
+                _mm_cmpeq_epi8 (v, slash)
+            ),
+            _mm_cmplt_epi8 (_mm_xor_si128 (v, bias), limit)
+        );
+
+        if (const int mask = _mm_movemask_epi8 (special))
+            return i + __builtin_ctz (mask);
+    }
+#endif
+
+    for ( ; i < size; ++i) {
+        const auto c = static_cast<unsigned char> (first[i]);
+        if (c < 0x20 || c == '"' || c == '\\')
+            return i;
+    }
+
+    return size;
+}
+
+
+//-----------------------------------------------------------------------------
+/// writes the escape sequence for the special character `c` into `dst`,
+/// returning its length.
+static size_t
+escape_sequence (unsigned char c, char dst[6])
+{
+    switch (c) {
+    case '"':  memcpy (dst, "\\\"", 2); return 2;
+    case '\\': memcpy (dst, "\\\\", 2); return 2;
+    case '\b': memcpy (dst, "\\b",  2); return 2;
+    case '\f': memcpy (dst, "\\f",  2); return 2;
+    case '\n': memcpy (dst, "\\n",  2); return 2;
+    case '\r': memcpy (dst, "\\r",  2); return 2;
+    case '\t': memcpy (dst, "\\t",  2); return 2;
+    }
+
+    static constexpr char HEX[] = "0123456789abcdef";
+    const char code[] = {
+        '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xf]
+    };
+    memcpy (dst, code, sizeof (code));
+    return sizeof (code);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+writer::writer (style _style, unsigned indent):
+    m_fd (nullptr),
+    m_style (_style),
+    m_indent (indent),
+    m_data (std::make_unique<char[]> (INITIAL_CAPACITY)),
+    m_size (0),
+    m_capacity (INITIAL_CAPACITY),
+    m_after_key (false)
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+writer::writer (const util::posix::fd &fd, style _style, unsigned indent):
+    writer (_style, indent)
+{
+    m_fd = &fd;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+char*
+writer::reserve (size_t size)
+{
+    if (m_size + size > m_capacity) {
+        auto capacity = std::max (m_capacity * 2, m_size + size);
+        auto data = std::make_unique<char[]> (capacity);
+        std::copy_n (m_data.get (), m_size, data.get ());
+
+        m_data = std::move (data);
+        m_capacity = capacity;
+    }
+
+    return m_data.get () + m_size;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::raw (const char *first, size_t size)
+{
+    memcpy (reserve (size), first, size);
+    m_size += size;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::raw (char c)
+{
+    *reserve (1) = c;
+    ++m_size;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::check_flush (void)
+{
+    if (m_fd && m_size >= FLUSH_THRESHOLD)
+        flush ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::flush (void)
+{
+    if (!m_fd)
+        return;
+
+    util::write (*m_fd, m_data.get (), m_size);
+    m_size = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+std::string_view
+writer::data (void) const noexcept
+{
+    return { m_data.get (), m_size };
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::clear (void) noexcept
+{
+    m_size = 0;
+    m_stack.clear ();
+    m_after_key = false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+writer::newline (void)
+{
+    const auto width = m_stack.size () * m_indent;
+    auto cursor = reserve (width + 1);
+
+    *cursor++ = '\n';
+    std::fill_n (cursor, width, ' ');
+    m_size += width + 1;
+}
+
+
+//-----------------------------------------------------------------------------
+/// emits whatever must precede a new value or key at the current position.
+void
+writer::separate (void)
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+
+    if (m_stack.empty ())
+        return;
+
+    auto &top = m_stack.back ();
+    if (!top.empty)
+        raw (',');
+    top.empty = false;
+
+    if (m_style == style::PRETTY)
+        newline ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::open (char c)
+{
+    separate ();
+    raw (c);
+    m_stack.push_back ({ c == '{' ? '}' : ']', true });
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::close (char c)
+{
+    if (m_stack.empty () || m_stack.back ().close != c || m_after_key)
+        throw json::error ("mismatched container close");
+
+    const bool empty = m_stack.back ().empty;
+    m_stack.pop_back ();
+
+    if (m_style == style::PRETTY && !empty)
+        newline ();
+    raw (c);
+
+    check_flush ();
+}
+
+
+//-----------------------------------------------------------------------------
+writer& writer::begin_object (void) { open ('{'); return *this; }
+writer& writer::end_object   (void) { close ('}'); return *this; }
+writer& writer::begin_array  (void) { open ('['); return *this; }
+writer& writer::end_array    (void) { close (']'); return *this; }
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::key (std::string_view name)
+{
+    member (name, false);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::member (std::string_view name, bool verbatim)
+{
+    if (m_stack.empty () || m_stack.back ().close != '}' || m_after_key)
+        throw json::error ("key outside of object");
+
+    separate ();
+    if (verbatim)
+        quote (name);
+    else
+        escape (name);
+
+    if (m_style == style::PRETTY)
+        raw (": ", 2);
+    else
+        raw (':');
+
+    m_after_key = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+writer::quote (std::string_view str)
+{
+    auto cursor = reserve (str.size () + 2);
+    *cursor++ = '"';
+    memcpy (cursor, str.data (), str.size ());
+    cursor[str.size ()] = '"';
+    m_size += str.size () + 2;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+writer::escape (std::string_view str)
+{
+    // reserve enough for the common case where nothing needs escaping
+    reserve (str.size () + 2);
+    raw ('"');
+
+    auto first = str.data ();
+    auto remain = str.size ();
+
+    while (remain) {
+        const auto clean = clean_prefix (first, remain);
+        raw (first, clean);
+
+        first  += clean;
+        remain -= clean;
+
+        if (!remain)
+            break;
+
+        char code[6];
+        raw (code, escape_sequence (static_cast<unsigned char> (*first), code));
+
+        ++first;
+        --remain;
+    }
+
+    raw ('"');
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+writer&
+writer::value (std::string_view str)
+{
+    separate ();
+    escape (str);
+    check_flush ();
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (const char *str)
+{
+    return value (std::string_view (str));
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (bool val)
+{
+    separate ();
+    if (val)
+        raw ("true", 4);
+    else
+        raw ("false", 5);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (std::nullptr_t)
+{
+    separate ();
+    raw ("null", 4);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (uintmax_t val)
+{
+    separate ();
+
+    char buffer[24];
+    auto last = std::end (buffer);
+    auto first = format_digits (val, last);
+
+    raw (first, last - first);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (intmax_t val)
+{
+    separate ();
+
+    char buffer[24];
+    auto last = std::end (buffer);
+
+    // negate in the unsigned domain so that the minimum value is handled
+    auto first = format_digits (
+        val < 0 ? 0 - uintmax_t (val) : uintmax_t (val),
+        last
+    );
+    if (val < 0)
+        *--first = '-';
+
+    raw (first, last - first);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (double val)
+{
+    // JSON has no representation for infinities or NaN
+    if (!std::isfinite (val))
+        return value (nullptr);
+
+    separate ();
+
+    // std::to_chars without a precision gives the shortest representation
+    // that reads back as the same value.
+    char buffer[32];
+    auto const [last, ec] = std::to_chars (std::begin (buffer), std::end (buffer), val);
+    CHECK (ec == std::errc ());
+
+    raw (buffer, last - buffer);
+
+    // ensure integral values read back as reals
+    if (std::none_of (buffer, last, [] (char c) { return c == '.' || c == 'e'; }))
+        raw (".0", 2);
+
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+writer&
+writer::value (const json::tree::node &node)
+{
+    switch (node.type ()) {
+    case json::tree::OBJECT:
+        begin_object ();
+        for (const auto &kv: node.as_object ()) {
+            member (kv.first, true);
+            value (*kv.second);
+        }
+        return end_object ();
+
+    case json::tree::ARRAY:
+        begin_array ();
+        for (const auto &i: node.as_array ())
+            value (i);
+        return end_array ();
+
+    // the tree retains strings and keys in their escaped source form, so
+    // they are copied through verbatim rather than escaped a second time.
+    case json::tree::STRING: {
+        separate ();
+        quote (node.as_string ().native ());
+        check_flush ();
+        return *this;
+    }
+
+    case json::tree::NUMBER: {
+        const auto &num = node.as_number ();
+        switch (num.repr ()) {
+        case json::tree::number::REAL: return value (double (num.real ()));
+        case json::tree::number::SINT: return value (intmax_t (num.sint ()));
+        case json::tree::number::UINT: return value (uintmax_t (num.uint ()));
+        }
+        unreachable ();
+    }
+
+    case json::tree::BOOLEAN:
+        return value (node.as_bool ());
+
+    case json::tree::NONE:
+        return value (nullptr);
+    }
+
+    unreachable ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+json::escape (std::string_view str, std::string &dst)
+{
+    dst.reserve (dst.size () + str.size ());
+
+    auto first = str.data ();
+    auto remain = str.size ();
+
+    while (remain) {
+        const auto clean = clean_prefix (first, remain);
+        dst.append (first, clean);
+
+        first  += clean;
+        remain -= clean;
+
+        if (!remain)
+            break;
+
+        char code[6];
+        dst.append (code, escape_sequence (static_cast<unsigned char> (*first), code));
+
+        ++first;
+        --remain;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+json::to_string (const json::tree::node &node, style _style)
+{
+    writer w (_style);
+    w.value (node);
+    return w.str ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+json::write (const json::tree::node &node,
+             const util::posix::fd &dst,
+             style _style)
+{
+    writer w (dst, _style);
+    w.value (node);
+    w.flush ();
+}
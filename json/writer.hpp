@@ -0,0 +1,143 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef __UTIL_JSON_WRITER_HPP
+#define __UTIL_JSON_WRITER_HPP
+
+#include "./fwd.hpp"
+
+#include "../posix/fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace json {
+    enum class style {
+        /// no insignificant whitespace at all
+        COMPACT,
+        /// one value per line, indented by nesting depth
+        PRETTY,
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Serialises JSON into a growable byte buffer without iostreams.
+    //
+    // Values are appended either from a json::tree or through the event
+    // style interface (begin_object, key, value, ...). Separators and
+    // indentation are inserted automatically. Strings supplied through the
+    // event interface are raw text and will be escaped; strings within a
+    // tree are already escaped and are copied verbatim.
+    //
+    // Strings are escaped by scanning 16 bytes at a time for characters
+    // that need it; reals are written as the shortest text that reads back
+    // to the same value; integers are converted two digits at a time.
+    //
+    // If constructed with a file descriptor the buffer is written out
+    // whenever it grows beyond a threshold. Any remainder is only written by
+    // an explicit call to flush.
+    class writer {
+    public:
+        explicit writer (style = style::COMPACT, unsigned indent = 4);
+        writer (const util::posix::fd&, style = style::COMPACT, unsigned indent = 4);
+
+        writer (const writer&) = delete;
+        writer& operator= (const writer&) = delete;
+
+        //---------------------------------------------------------------------
+        writer& begin_object (void);
+        writer& end_object (void);
+        writer& begin_array (void);
+        writer& end_array (void);
+
+        writer& key (std::string_view);
+
+        writer& value (std::string_view);
+        writer& value (const char*);
+        writer& value (bool);
+        writer& value (intmax_t);
+        writer& value (uintmax_t);
+        writer& value (int v) { return value (intmax_t (v)); }
+        writer& value (unsigned v) { return value (uintmax_t (v)); }
+        writer& value (double);
+        writer& value (std::nullptr_t);
+        writer& value (const json::tree::node&);
+
+        //---------------------------------------------------------------------
+        /// the bytes written since the last flush or clear
+        std::string_view data (void) const noexcept;
+        std::string str (void) const { return std::string (data ()); }
+
+        /// discards the buffer and any partially written document
+        void clear (void) noexcept;
+
+        /// writes the buffer to the file descriptor, if there is one
+        void flush (void);
+
+    private:
+        void separate (void);
+        void open (char);
+        void close (char);
+        void newline (void);
+
+        void raw (const char *first, size_t size);
+        void raw (char c);
+        char* reserve (size_t size);
+        void check_flush (void);
+
+        void member (std::string_view, bool verbatim);
+
+        void quote (std::string_view);
+        void escape (std::string_view);
+
+        const util::posix::fd *m_fd;
+        style m_style;
+        unsigned m_indent;
+
+        std::unique_ptr<char[]> m_data;
+        size_t m_size;
+        size_t m_capacity;
+
+        // one entry per open container: the closing character, and whether
+        // a value has been written within it yet.
+        struct scope {
+            char close;
+            bool empty;
+        };
+
+        std::vector<scope> m_stack;
+        bool m_after_key;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// appends the escaped form of `str`, without quotes, to `dst`. this is
+    /// the form in which json::tree holds its strings and keys.
+    void escape (std::string_view str, std::string &dst);
+
+
+    //-------------------------------------------------------------------------
+    std::string to_string (const json::tree::node&, style = style::COMPACT);
+    void write (const json::tree::node&, const util::posix::fd&, style = style::COMPACT);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_JSON2_BIND_HPP
+#define CRUFT_UTIL_JSON2_BIND_HPP
+
+#include "./cursor.hpp"
+
+#include "../json/fwd.hpp"
+
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Typed conversion between JSON text and C++ values without building a tree.
+//
+// Decoding walks the text with a json2::cursor, reading each member once and
+// storing it directly into the destination. Encoding writes through a
+// json::writer.
+//
+// Supported types are: bool, arithmetic types, std::string, std::vector,
+// std::array, std::optional, enumerations described by util::enum_traits
+// (as their names), and classes whose members are described by
+// util::type<T>::fields (as objects keyed by field name).
+//
+// Other types may be supported by specialising util::json2::binding<T> with
+// static decode (const cursor&, T&) and encode (json::writer&, const T&)
+// functions.
+//
+// When decoding an object, unrecognised keys are ignored and absent fields
+// retain their existing value. Type mismatches and out of range integers
+// throw util::json2::parse_error.
+namespace util::json2 {
+    template <typename T, typename = void>
+    struct binding;
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    void
+    decode (const cursor &src, T &dst)
+    {
+        binding<T>::decode (src, dst);
+    }
+
+
+    template <typename T>
+    T
+    decode (const cursor &src)
+    {
+        T dst {};
+        decode (src, dst);
+        return dst;
+    }
+
+
+    template <typename T>
+    T
+    decode (const char *first, const char *last)
+    {
+        return decode<T> (cursor (first, last));
+    }
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    void
+    encode (json::writer &dst, const T &src)
+    {
+        binding<T>::encode (dst, src);
+    }
+
+
+    template <typename T>
+    std::string
+    encode (const T&);
+}
+
+#include "./bind.ipp"
+
+#endif
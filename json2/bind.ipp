@@ -0,0 +1,299 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifdef CRUFT_UTIL_JSON2_BIND_IPP
+#error
+#endif
+
+#define CRUFT_UTIL_JSON2_BIND_IPP
+
+#include "./except.hpp"
+#include "./string.hpp"
+
+#include "../introspection.hpp"
+#include "../json/writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace util::json2 {
+    template <>
+    struct binding<bool> {
+        static void decode (const cursor &src, bool &dst) { dst = src.as_boolean (); }
+        static void encode (json::writer &dst, bool src) { dst.value (src); }
+    };
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    struct binding<
+        T,
+        std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T,bool>>
+    > {
+        static void
+        decode (const cursor &src, T &dst)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                const auto val = src.as_sint ();
+                if (val < std::numeric_limits<T>::min () || val > std::numeric_limits<T>::max ())
+                    throw parse_error { src.begin () };
+                dst = T (val);
+            } else {
+                const auto val = src.as_uint ();
+                if (val > std::numeric_limits<T>::max ())
+                    throw parse_error { src.begin () };
+                dst = T (val);
+            }
+        }
+
+        static void
+        encode (json::writer &dst, T src)
+        {
+            if constexpr (std::is_signed_v<T>)
+                dst.value (intmax_t (src));
+            else
+                dst.value (uintmax_t (src));
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    struct binding<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+        static void decode (const cursor &src, T &dst) { dst = T (src.as_double ()); }
+        static void encode (json::writer &dst, T src) { dst.value (double (src)); }
+    };
+
+
+    //-------------------------------------------------------------------------
+    template <>
+    struct binding<std::string> {
+        static void decode (const cursor &src, std::string &dst) { dst = src.as_string (); }
+        static void encode (json::writer &dst, const std::string &src) { dst.value (std::string_view (src)); }
+    };
+
+
+    //-------------------------------------------------------------------------
+    // enumerations are represented by the names listed in their enum_traits
+    template <typename T>
+    struct binding<
+        T,
+        std::enable_if_t<
+            std::is_enum_v<T>,
+            std::void_t<decltype (util::enum_traits<T>::names)>
+        >
+    > {
+        using traits = util::enum_traits<T>;
+
+        static void
+        decode (const cursor &src, T &dst)
+        {
+            const auto name = src.as_string ();
+            const auto pos = std::find (
+                std::cbegin (traits::names),
+                std::cend   (traits::names),
+                name
+            );
+
+            if (pos == std::cend (traits::names))
+                throw parse_error { src.begin () };
+
+            dst = traits::values[std::distance (std::cbegin (traits::names), pos)];
+        }
+
+        static void
+        encode (json::writer &dst, T src)
+        {
+            const auto pos = std::find (
+                std::cbegin (traits::values),
+                std::cend   (traits::values),
+                src
+            );
+
+            if (pos == std::cend (traits::values))
+                throw std::invalid_argument ("unnamed enumeration value");
+
+            dst.value (traits::names[std::distance (std::cbegin (traits::values), pos)]);
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    struct binding<std::vector<T>> {
+        static void
+        decode (const cursor &src, std::vector<T> &dst)
+        {
+            dst.clear ();
+            src.for_each ([&dst] (const cursor &val) {
+                dst.emplace_back ();
+                binding<T>::decode (val, dst.back ());
+            });
+        }
+
+        static void
+        encode (json::writer &dst, const std::vector<T> &src)
+        {
+            dst.begin_array ();
+            for (const auto &i: src)
+                binding<T>::encode (dst, i);
+            dst.end_array ();
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    template <typename T, size_t N>
+    struct binding<std::array<T,N>> {
+        static void
+        decode (const cursor &src, std::array<T,N> &dst)
+        {
+            size_t count = 0;
+            src.for_each ([&] (const cursor &val) {
+                if (count == N)
+                    throw parse_error { val.begin () };
+                binding<T>::decode (val, dst[count++]);
+            });
+
+            if (count != N)
+                throw parse_error { src.begin () };
+        }
+
+        static void
+        encode (json::writer &dst, const std::array<T,N> &src)
+        {
+            dst.begin_array ();
+            for (const auto &i: src)
+                binding<T>::encode (dst, i);
+            dst.end_array ();
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    // null maps to an empty optional
+    template <typename T>
+    struct binding<std::optional<T>> {
+        static void
+        decode (const cursor &src, std::optional<T> &dst)
+        {
+            if (src.is_null ()) {
+                dst.reset ();
+                return;
+            }
+
+            binding<T>::decode (src, dst.emplace ());
+        }
+
+        static void
+        encode (json::writer &dst, const std::optional<T> &src)
+        {
+            if (src)
+                binding<T>::encode (dst, *src);
+            else
+                dst.value (nullptr);
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    // classes described by util::type<T>::fields are objects keyed by the
+    // name of each field.
+    template <typename T>
+    struct binding<T, std::void_t<typename util::type<T>::fields>> {
+        using fields = typename util::type<T>::fields;
+        static constexpr auto COUNT = std::tuple_size_v<fields>;
+
+        /// decodes `val` into the field named `key`, returning false if
+        /// there is no such field.
+        template <size_t ...I>
+        static bool
+        decode_field (std::string_view key,
+                      const cursor &val,
+                      T &dst,
+                      std::index_sequence<I...>)
+        {
+            return (
+                ... || (
+                    std::tuple_element_t<I,fields>::name == key &&
+                    (binding<typename std::tuple_element_t<I,fields>::type>::decode (
+                        val, std::tuple_element_t<I,fields>::get (dst)
+                    ), true)
+                )
+            );
+        }
+
+        static void
+        decode (const cursor &src, T &dst)
+        {
+            std::string storage;
+
+            src.for_each_member ([&] (std::string_view key, const cursor &val) {
+                // keys are supplied raw, so only unescape if we must
+                if (key.find ('\\') != std::string_view::npos) {
+                    storage = unescape (key);
+                    key = storage;
+                }
+
+                decode_field (key, val, dst, std::make_index_sequence<COUNT> {});
+            });
+        }
+
+        template <size_t ...I>
+        static void
+        encode (json::writer &dst, const T &src, std::index_sequence<I...>)
+        {
+            dst.begin_object ();
+            (
+                (
+                    dst.key (std::tuple_element_t<I,fields>::name),
+                    binding<typename std::tuple_element_t<I,fields>::type>::encode (
+                        dst, std::tuple_element_t<I,fields>::get (src)
+                    )
+                ), ...
+            );
+            dst.end_object ();
+        }
+
+        static void
+        encode (json::writer &dst, const T &src)
+        {
+            encode (dst, src, std::make_index_sequence<COUNT> {});
+        }
+    };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+std::string
+util::json2::encode (const T &src)
+{
+    json::writer dst;
+    encode (dst, src);
+    return dst.str ();
+}
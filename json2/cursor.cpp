@@ -0,0 +1,379 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./cursor.hpp"
+
+#include "./except.hpp"
+#include "./string.hpp"
+#include "./personality/rfc7519.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+using util::json2::cursor;
+using util::json2::event::type_t;
+
+
+///////////////////////////////////////////////////////////////////////////////
+static const char*
+consume_whitespace [[nodiscard]] (const char *first, const char *last) noexcept
+{
+    return util::json2::personality::rfc7159::consume_whitespace (first, last);
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the position after the closing quote of the string starting at
+/// 'first'.
+static const char*
+string_end [[nodiscard]] (const char *first, const char *last)
+{
+    for (auto cursor = first + 1; cursor < last; ++cursor) {
+        switch (*cursor) {
+        case '\\': ++cursor;      break;
+        case '"':  return cursor + 1;
+        }
+    }
+
+    throw util::json2::overrun_error { last };
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the position after the number or literal starting at 'first'.
+static const char*
+scalar_end [[nodiscard]] (const char *first, const char *last) noexcept
+{
+    auto cursor = first;
+
+    for ( ; cursor != last; ++cursor) {
+        switch (*cursor) {
+        case ' ': case '\t': case '\n': case '\r':
+        case ',': case ':':
+        case ']': case '}':
+            return cursor;
+        }
+    }
+
+    return cursor;
+}
+
+
+//-----------------------------------------------------------------------------
+/// compares the raw body of a key against an unescaped query.
+static bool
+key_equal (std::string_view raw, std::string_view query)
+{
+    if (raw.find ('\\') == std::string_view::npos)
+        return raw == query;
+    return util::json2::unescape (raw) == query;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+cursor::cursor (const char *first, const char *last):
+    m_first (consume_whitespace (first, last)),
+    m_last  (last)
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+type_t
+cursor::type (void) const
+{
+    if (m_first == m_last)
+        throw util::json2::overrun_error { m_first };
+
+    switch (*m_first) {
+    case '{': return type_t::OBJECT_BEGIN;
+    case '[': return type_t::ARRAY_BEGIN;
+    case '"': return type_t::STRING;
+    case 'n': return type_t::NONE;
+
+    case 't':
+    case 'f':
+        return type_t::BOOLEAN;
+
+    case '-':
+    case '0'...'9':
+        return type_t::NUMBER;
+    }
+
+    throw util::json2::parse_error { m_first };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+const char*
+cursor::end (void) const
+{
+    if (m_first == m_last)
+        throw util::json2::overrun_error { m_first };
+
+    switch (*m_first) {
+    case '"':
+        return string_end (m_first, m_last);
+
+    case '{':
+    case '[': {
+        int depth = 0;
+
+        for (auto pos = m_first; pos < m_last; ++pos) {
+            switch (*pos) {
+            case '"':
+                pos = string_end (pos, m_last) - 1;
+                break;
+
+            case '{':
+            case '[':
+                ++depth;
+                break;
+
+            case '}':
+            case ']':
+                if (--depth == 0)
+                    return pos + 1;
+                break;
+            }
+        }
+
+        throw util::json2::overrun_error { m_last };
+    }
+    }
+
+    auto res = scalar_end (m_first, m_last);
+    if (res == m_first)
+        throw util::json2::parse_error { m_first };
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+std::string_view
+cursor::raw (void) const
+{
+    auto last = end ();
+    return { m_first, size_t (last - m_first) };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+bool
+cursor::as_boolean (void) const
+{
+    auto const text = raw ();
+    if (text == "true")
+        return true;
+    if (text == "false")
+        return false;
+
+    throw util::json2::parse_error { m_first };
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename ValueT>
+static ValueT
+parse_number (std::string_view text)
+{
+    ValueT res;
+    auto const last = text.data () + text.size ();
+    auto const [ptr, ec] = std::from_chars (text.data (), last, res);
+
+    if (ec != std::errc () || ptr != last)
+        throw util::json2::parse_error { ptr };
+
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+double
+cursor::as_double (void) const
+{
+    if (!is_number ())
+        throw util::json2::parse_error { m_first };
+    return parse_number<double> (raw ());
+}
+
+
+//-----------------------------------------------------------------------------
+intmax_t
+cursor::as_sint (void) const
+{
+    if (!is_number ())
+        throw util::json2::parse_error { m_first };
+    return parse_number<intmax_t> (raw ());
+}
+
+
+//-----------------------------------------------------------------------------
+uintmax_t
+cursor::as_uint (void) const
+{
+    if (!is_number ())
+        throw util::json2::parse_error { m_first };
+    return parse_number<uintmax_t> (raw ());
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+cursor::as_string (void) const
+{
+    if (!is_string ())
+        throw util::json2::parse_error { m_first };
+
+    auto const text = raw ();
+    return util::json2::unescape (text.substr (1, text.size () - 2));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+const char*
+cursor::open (char bracket) const
+{
+    if (m_first == m_last)
+        throw util::json2::overrun_error { m_first };
+    if (*m_first != bracket)
+        throw util::json2::parse_error { m_first };
+
+    return m_first + 1;
+}
+
+
+//-----------------------------------------------------------------------------
+bool
+cursor::next (const char *&pos, bool &first, char close) const
+{
+    pos = consume_whitespace (pos, m_last);
+    if (pos == m_last)
+        throw util::json2::overrun_error { pos };
+
+    if (*pos == close) {
+        ++pos;
+        return false;
+    }
+
+    if (!first) {
+        if (*pos != ',')
+            throw util::json2::parse_error { pos };
+
+        pos = consume_whitespace (pos + 1, m_last);
+        if (pos == m_last)
+            throw util::json2::overrun_error { pos };
+        if (*pos == close)
+            throw util::json2::parse_error { pos };
+    }
+
+    first = false;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+const char*
+cursor::member (const char *pos, std::string_view &key) const
+{
+    if (*pos != '"')
+        throw util::json2::parse_error { pos };
+
+    auto const close = string_end (pos, m_last);
+    key = { pos + 1, size_t (close - pos - 2) };
+
+    pos = consume_whitespace (close, m_last);
+    if (pos == m_last)
+        throw util::json2::overrun_error { pos };
+    if (*pos != ':')
+        throw util::json2::parse_error { pos };
+
+    return pos + 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::optional<cursor>
+cursor::find (std::string_view key) const
+{
+    bool first = true;
+
+    for (auto pos = open ('{'); next (pos, first, '}'); ) {
+        std::string_view name;
+        const cursor val (member (pos, name), m_last);
+
+        if (key_equal (name, key))
+            return val;
+
+        pos = val.end ();
+    }
+
+    return std::nullopt;
+}
+
+
+//-----------------------------------------------------------------------------
+cursor
+cursor::operator[] (std::string_view key) const
+{
+    if (auto res = find (key))
+        return *res;
+
+    throw std::out_of_range ("missing key");
+}
+
+
+//-----------------------------------------------------------------------------
+std::optional<cursor>
+cursor::at (size_t idx) const
+{
+    bool first = true;
+
+    for (auto pos = open ('['); next (pos, first, ']'); ) {
+        const cursor val (pos, m_last);
+        if (idx-- == 0)
+            return val;
+
+        pos = val.end ();
+    }
+
+    return std::nullopt;
+}
+
+
+//-----------------------------------------------------------------------------
+cursor
+cursor::operator[] (size_t idx) const
+{
+    if (auto res = at (idx))
+        return *res;
+
+    throw std::out_of_range ("array index out of range");
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+cursor::size (void) const
+{
+    size_t count = 0;
+
+    if (is_object ())
+        for_each_member ([&count] (auto, auto) { ++count; });
+    else
+        for_each ([&count] (auto) { ++count; });
+
+    return count;
+}
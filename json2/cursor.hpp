@@ -0,0 +1,144 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_JSON2_CURSOR_HPP
+#define CRUFT_UTIL_JSON2_CURSOR_HPP
+
+#include "./event.hpp"
+
+#include "../view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+namespace util::json2 {
+    /// A lazily evaluated reference to a value within a JSON buffer.
+    ///
+    /// Nothing is parsed up front. Navigation skips over unwanted members
+    /// and elements by matching brackets and quotes, and scalars are only
+    /// decoded when requested, so the cost of a query is proportional to
+    /// the amount of the document that precedes the data it reads.
+    ///
+    /// Only the parts of the document that are traversed are checked for
+    /// errors; skipped values are assumed to be well formed. The buffer
+    /// must outlive any cursors that refer to it.
+    class cursor {
+    public:
+        cursor (const char *first, const char *last);
+
+        explicit cursor (util::view<const char*> data):
+            cursor (data.begin (), data.end ())
+        { ; }
+
+        event::type_t type (void) const;
+
+        bool is_object  (void) const { return type () == event::type_t::OBJECT_BEGIN; }
+        bool is_array   (void) const { return type () == event::type_t::ARRAY_BEGIN;  }
+        bool is_string  (void) const { return type () == event::type_t::STRING;  }
+        bool is_number  (void) const { return type () == event::type_t::NUMBER;  }
+        bool is_boolean (void) const { return type () == event::type_t::BOOLEAN; }
+        bool is_null    (void) const { return type () == event::type_t::NONE;    }
+
+        //---------------------------------------------------------------------
+        // scalar decoding. these throw parse_error if the value is malformed
+        // or of the wrong type.
+        bool        as_boolean (void) const;
+        double      as_double  (void) const;
+        intmax_t    as_sint    (void) const;
+        uintmax_t   as_uint    (void) const;
+        std::string as_string  (void) const;
+
+        /// the encoded text of this value; strings include their quotes.
+        std::string_view raw (void) const;
+
+        //---------------------------------------------------------------------
+        /// returns the value of the member named 'key', or nothing if it
+        /// isn't present.
+        std::optional<cursor> find (std::string_view key) const;
+
+        /// returns the value of the member named 'key'; throws
+        /// std::out_of_range if it isn't present.
+        cursor operator[] (std::string_view key) const;
+
+        /// returns the element at 'idx', or nothing if it isn't present.
+        std::optional<cursor> at (size_t idx) const;
+
+        /// returns the element at 'idx'; throws std::out_of_range if it
+        /// isn't present.
+        cursor operator[] (size_t idx) const;
+
+        /// returns the number of elements or members.
+        size_t size (void) const;
+
+        //---------------------------------------------------------------------
+        /// invokes func (cursor) for each element of an array.
+        template <typename FunctionT>
+        void
+        for_each (FunctionT &&func) const
+        {
+            bool first = true;
+            for (auto pos = open ('['); next (pos, first, ']'); ) {
+                const cursor val (pos, m_last);
+                func (val);
+                pos = val.end ();
+            }
+        }
+
+
+        /// invokes func (std::string_view, cursor) for each member of an
+        /// object. keys are passed without quotes and without unescaping.
+        template <typename FunctionT>
+        void
+        for_each_member (FunctionT &&func) const
+        {
+            bool first = true;
+            for (auto pos = open ('{'); next (pos, first, '}'); ) {
+                std::string_view key;
+                const cursor val (member (pos, key), m_last);
+                func (key, val);
+                pos = val.end ();
+            }
+        }
+
+        //---------------------------------------------------------------------
+        const char* begin (void) const { return m_first; }
+
+        /// returns a pointer one past the end of this value, skipping over
+        /// any children.
+        const char* end (void) const;
+
+    private:
+        // returns the position after the opening bracket, throwing if the
+        // value is not a container of the requested kind.
+        const char* open (char bracket) const;
+
+        // moves past whitespace and any separator before the next child.
+        // returns false once the closing bracket has been consumed.
+        bool next (const char *&pos, bool &first, char close) const;
+
+        // reads a member's key and colon, returning the start of its value.
+        const char* member (const char *pos, std::string_view &key) const;
+
+        const char *m_first;
+        const char *m_last;
+    };
+}
+
+#endif
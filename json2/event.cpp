@@ -65,14 +65,9 @@ util::json2::event::parse (const std::function<util::json2::callback_t> &cb,
                            const char *first,
                            const char *last)
 {
-    auto cursor = first;
-
-    PersonalityT p {};
-    cursor = p.consume_whitespace (cursor, last);
-    cursor = p.parse_value (cb, cursor, last);
-    cursor = p.consume_whitespace (cursor, last);
-
-    return cursor;
+    // name the callback type explicitly so that we select the template
+    // sink overload rather than recursing into ourselves.
+    return parse<PersonalityT, const std::function<callback_t>&> (cb, first, last);
 }
 
 
@@ -47,9 +47,29 @@ namespace util::json2::event {
         const char *last;
     };
 
+    /// parses a single value, delivering each packet to a callback.
+    ///
+    /// this is the ABI stable entry point; it is instantiated in the
+    /// library for each personality and dispatches through a std::function.
     template <typename PersonalityT = personality::rfc7159>
     const char*
     parse (const std::function<callback_t>&, const char *first, const char *last);
+
+
+    /// parses a single value, delivering each packet to an arbitrary
+    /// callable.
+    ///
+    /// the parser is instantiated for the callback type so the sink can be
+    /// inlined into the grammar. it is selected over the std::function
+    /// overload for anything other than a const std::function.
+    template <
+        typename PersonalityT = personality::rfc7159,
+        typename CallbackT
+    >
+    const char*
+    parse (CallbackT &&cb, const char *first, const char *last);
 };
 
+#include "./event.ipp"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifdef CRUFT_UTIL_JSON2_EVENT_IPP
+#error
+#endif
+
+#define CRUFT_UTIL_JSON2_EVENT_IPP
+
+#include "./personality/rfc7519.hpp"
+#include "./personality/jsonish.hpp"
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PersonalityT, typename CallbackT>
+const char*
+util::json2::event::parse (CallbackT &&cb, const char *first, const char *last)
+{
+    auto cursor = first;
+
+    PersonalityT p {};
+    cursor = p.consume_whitespace (cursor, last);
+    cursor = p.parse_value (cb, cursor, last);
+    cursor = p.consume_whitespace (cursor, last);
+
+    return cursor;
+}
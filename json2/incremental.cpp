@@ -0,0 +1,344 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./incremental.hpp"
+
+#include "./event.hpp"
+#include "./except.hpp"
+#include "./personality/rfc7519.hpp"
+#include "./personality/jsonish.hpp"
+
+#include <algorithm>
+
+using util::json2::event::incremental;
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PersonalityT>
+incremental<PersonalityT>::incremental (size_t max_token, size_t max_depth):
+    m_max_token (max_token),
+    m_max_depth (max_depth)
+{
+    reset ();
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::reset (void)
+{
+    m_state   = state_t::VALUE;
+    m_token   = token_t::NONE;
+    m_escaped = false;
+    m_comment = false;
+
+    m_carry.clear ();
+    m_stack.clear ();
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+bool
+incremental<PersonalityT>::complete (void) const noexcept
+{
+    return m_state == state_t::DONE && m_token == token_t::NONE;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::feed (const std::function<callback_t> &cb,
+                                 const char *first,
+                                 const char *last)
+{
+    auto cursor = first;
+
+    // complete any token left over from the previous chunk
+    if (m_token != token_t::NONE) {
+        auto end = token_end (cursor, last);
+        if (!end) {
+            carry (cursor, last);
+            return;
+        }
+
+        carry (cursor, end);
+        m_token = token_t::NONE;
+        emit (cb, m_carry.data (), m_carry.data () + m_carry.size ());
+        m_carry.clear ();
+
+        cursor = end;
+    }
+
+    while (true) {
+        cursor = consume_whitespace (cursor, last);
+        if (cursor == last)
+            return;
+
+        const char c = *cursor;
+
+        switch (m_state) {
+        case state_t::DONE:
+            throw parse_error { cursor };
+
+        case state_t::COLON:
+            if (c != ':')
+                throw parse_error { cursor };
+            m_state = state_t::VALUE;
+            ++cursor;
+            continue;
+
+        case state_t::ARRAY_NEXT:
+            if (c == ']')
+                close (cb, cursor);
+            else if (c == ',')
+                m_state = state_t::VALUE;
+            else
+                throw parse_error { cursor };
+            ++cursor;
+            continue;
+
+        case state_t::OBJECT_NEXT:
+            if (c == '}')
+                close (cb, cursor);
+            else if (c == ',')
+                m_state = state_t::KEY;
+            else
+                throw parse_error { cursor };
+            ++cursor;
+            continue;
+
+        case state_t::ARRAY_FIRST:
+            if (c == ']') {
+                close (cb, cursor++);
+                continue;
+            }
+            m_state = state_t::VALUE;
+            break;
+
+        case state_t::KEY_FIRST:
+            if (c == '}') {
+                close (cb, cursor++);
+                continue;
+            }
+            m_state = state_t::KEY;
+            break;
+
+        case state_t::VALUE:
+        case state_t::KEY:
+            break;
+        }
+
+        // we're positioned at the start of a value or a key
+        switch (c) {
+        case '{':
+        case '[':
+            if (m_state != state_t::VALUE)
+                throw parse_error { cursor };
+            open (cb, cursor++);
+            continue;
+
+        case ',':
+        case ':':
+        case ']':
+        case '}':
+            throw parse_error { cursor };
+        }
+
+        const auto start = cursor;
+        if (c == '"') {
+            m_token = token_t::STRING;
+            m_escaped = false;
+            ++cursor;
+        } else {
+            m_token = token_t::BARE;
+        }
+
+        auto end = token_end (cursor, last);
+        if (!end) {
+            carry (start, last);
+            return;
+        }
+
+        m_token = token_t::NONE;
+        emit (cb, start, end);
+        cursor = end;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::finish (const std::function<callback_t> &cb)
+{
+    // a bare scalar may only be terminated by the end of the input
+    if (m_token == token_t::BARE) {
+        m_token = token_t::NONE;
+        emit (cb, m_carry.data (), m_carry.data () + m_carry.size ());
+        m_carry.clear ();
+    }
+
+    if (!complete ())
+        throw overrun_error { nullptr };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PersonalityT>
+const char*
+incremental<PersonalityT>::consume_whitespace (const char *first, const char *last)
+{
+    // finish any comment left open by the previous chunk
+    if (m_comment) {
+        first = std::find (first, last, '\n');
+        if (first == last)
+            return last;
+        m_comment = false;
+    }
+
+    auto cursor = PersonalityT::consume_whitespace (first, last);
+    if (cursor != last)
+        return cursor;
+
+    // the personality may have stopped inside a comment because the chunk
+    // ran out. any '#' after the final newline must have opened one.
+    auto tail = std::find (
+        std::make_reverse_iterator (last),
+        std::make_reverse_iterator (first),
+        '\n'
+    ).base ();
+
+    m_comment = std::find (tail, last, '#') != last;
+    return last;
+}
+
+
+//-----------------------------------------------------------------------------
+/// returns the position after the current token, or nullptr if it extends
+/// beyond `last`.
+template <typename PersonalityT>
+const char*
+incremental<PersonalityT>::token_end (const char *first, const char *last)
+{
+    if (m_token == token_t::STRING) {
+        for (auto cursor = first; cursor != last; ++cursor) {
+            if (m_escaped)
+                m_escaped = false;
+            else if (*cursor == '\\')
+                m_escaped = true;
+            else if (*cursor == '"')
+                return cursor + 1;
+        }
+
+        return nullptr;
+    }
+
+    for (auto cursor = first; cursor != last; ++cursor) {
+        switch (*cursor) {
+        case ' ': case '\t': case '\n': case '\r':
+        case ',': case ':':
+        case '[': case ']':
+        case '{': case '}':
+        case '"': case '#':
+            return cursor;
+        }
+    }
+
+    return nullptr;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::emit (const std::function<callback_t> &cb,
+                                 const char *first,
+                                 const char *last)
+{
+    if (first == last)
+        throw parse_error { first };
+
+    if (m_state == state_t::KEY) {
+        if (PersonalityT::parse_key (cb, first, last) != last)
+            throw parse_error { first };
+        m_state = state_t::COLON;
+    } else {
+        if (PersonalityT::parse_value (cb, first, last) != last)
+            throw parse_error { first };
+        advance ();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::open (const std::function<callback_t> &cb,
+                                 const char *pos)
+{
+    if (m_stack.size () >= m_max_depth)
+        throw parse_error { pos };
+
+    cb ({ pos, pos + 1 });
+    m_stack.push_back (*pos);
+    m_state = *pos == '{' ? state_t::KEY_FIRST : state_t::ARRAY_FIRST;
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::close (const std::function<callback_t> &cb,
+                                  const char *pos)
+{
+    cb ({ pos, pos + 1 });
+    m_stack.pop_back ();
+    advance ();
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::carry (const char *first, const char *last)
+{
+    if (m_carry.size () + (last - first) > m_max_token)
+        throw parse_error { first };
+
+    m_carry.append (first, last);
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+incremental<PersonalityT>::advance (void)
+{
+    if (m_stack.empty ())
+        m_state = state_t::DONE;
+    else if (m_stack.back () == '[')
+        m_state = state_t::ARRAY_NEXT;
+    else
+        m_state = state_t::OBJECT_NEXT;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+#define INSTANTIATE(KLASS) template class util::json2::event::incremental<KLASS>;
+MAP_JSON2_PERSONALITY_TYPES (INSTANTIATE)
@@ -0,0 +1,104 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_JSON2_INCREMENTAL_HPP
+#define CRUFT_UTIL_JSON2_INCREMENTAL_HPP
+
+#include "./fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace util::json2::event {
+    /// A push parser that accepts a document in arbitrarily sized chunks.
+    ///
+    /// Packets are emitted as soon as each token is complete. Nesting is
+    /// tracked with an explicit stack rather than recursion, and any token
+    /// that straddles a chunk boundary is carried over in an internal
+    /// buffer; both are bounded by the limits given at construction.
+    ///
+    /// Scalars and keys are validated by the personality's own parsing
+    /// functions so the packets match those of event::parse. Packet
+    /// pointers are only valid for the duration of the callback as they
+    /// may refer to the internal carry buffer.
+    template <typename PersonalityT = personality::rfc7159>
+    class incremental {
+    public:
+        explicit incremental (size_t max_token = 64 * 1024,
+                              size_t max_depth = 1024);
+
+        /// consumes the next chunk of the document.
+        ///
+        /// throws parse_error on malformed input, or if a limit is
+        /// exceeded.
+        void feed (const std::function<callback_t>&, const char *first, const char *last);
+
+        /// signals the end of the input, emitting any trailing scalar.
+        ///
+        /// throws overrun_error if the document is incomplete.
+        void finish (const std::function<callback_t>&);
+
+        /// returns true once a complete top-level value has been seen.
+        bool complete (void) const noexcept;
+
+        /// discards all state so that a new document may be parsed.
+        void reset (void);
+
+    private:
+        enum class state_t : uint8_t {
+            VALUE,
+            ARRAY_FIRST,
+            ARRAY_NEXT,
+            KEY_FIRST,
+            KEY,
+            COLON,
+            OBJECT_NEXT,
+            DONE,
+        };
+
+        enum class token_t : uint8_t {
+            NONE,
+            STRING,
+            BARE,
+        };
+
+        const char* consume_whitespace (const char *first, const char *last);
+        const char* token_end (const char *first, const char *last);
+
+        void emit (const std::function<callback_t>&, const char *first, const char *last);
+        void open (const std::function<callback_t>&, const char *pos);
+        void close (const std::function<callback_t>&, const char *pos);
+        void carry (const char *first, const char *last);
+        void advance (void);
+
+        size_t m_max_token;
+        size_t m_max_depth;
+
+        state_t m_state;
+        token_t m_token;
+        bool m_escaped;
+        bool m_comment;
+
+        std::string m_carry;
+        std::vector<char> m_stack;
+    };
+}
+
+#endif
@@ -19,72 +19,85 @@
 
 #include "../fwd.hpp"
 
-#include <functional>
 
 
 namespace util::json2::personality {
+    /// The grammar shared by all personalities.
+    ///
+    /// Each parsing function accepts any callable as the sink for packets
+    /// so that the callback can be inlined into the parser. Callers that
+    /// need a stable ABI can use the std::function entry point in
+    /// event::parse, which instantiates these with a std::function.
     template <typename T>
     struct base {
         static const char*
         consume_whitespace [[nodiscard]] (const char *first, const char *last) noexcept;
 
 
+        template <typename CallbackT>
         static const char*
         parse_number [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
 
 
-        template <int N>
+        template <typename CallbackT, int N>
         static const char*
         parse_literal [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last,
             const char (&value)[N]
         );
 
 
+        template <typename CallbackT>
         static const char*
         parse_string [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
 
 
+        template <typename CallbackT>
         static const char*
         parse_array [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
 
 
+        template <typename CallbackT>
         static const char*
         parse_object [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
 
 
+        template <typename CallbackT>
         static const char*
         parse_value [[nodiscard]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
 
+        template <typename CallbackT>
         static const char*
         parse_unknown [[noreturn]] (
-            const std::function<callback_t>&,
+            CallbackT&&,
             const char *first,
             const char *last
         );
     };
 };
 
+#include "./base.ipp"
+
 #endif
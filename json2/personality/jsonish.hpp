@@ -21,7 +21,6 @@
 
 #include "./base.hpp"
 
-#include <functional>
 
 
 namespace util::json2::personality {
@@ -33,69 +32,78 @@ namespace util::json2::personality {
         ) noexcept;
 
 
+        template <typename CallbackT>
         static const char*
         parse_value [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first, const char *last
         ) { return base<jsonish>::parse_value (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_number [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         );
 
 
-        template <int N>
+        template <typename CallbackT, int N>
         static const char*
         parse_literal [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last,
             const char (&value)[N]
         ) { return base<jsonish>::parse_literal (cb, first, last, value); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_string [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         );
 
 
+        template <typename CallbackT>
         static const char*
         parse_array [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<jsonish>::parse_array (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_key [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last);
 
 
+        template <typename CallbackT>
         static const char*
         parse_object [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<jsonish>::parse_object (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_unknown [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return parse_string (cb, first, last); }
     };
 };
 
+#include "./jsonish.ipp"
+
 #endif
@@ -21,7 +21,6 @@
 
 #include "../fwd.hpp"
 
-#include <functional>
 
 namespace util::json2::personality {
     struct rfc7159 {
@@ -30,66 +29,73 @@ namespace util::json2::personality {
         { return base<rfc7159>::consume_whitespace (first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_value [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first, const char *last
         ) { return base<rfc7159>::parse_value (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_number [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<rfc7159>::parse_number (cb, first, last); }
 
 
-        template <int N>
+        template <typename CallbackT, int N>
         static const char*
         parse_literal [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last,
             const char (&value)[N]
         ) { return base<rfc7159>::parse_literal (cb, first, last, value); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_string [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<rfc7159>::parse_string (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_array [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<rfc7159>::parse_array (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_key [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last)
         { return parse_string (cb, first, last); }
 
 
+        template <typename CallbackT>
         static const char*
         parse_object [[nodiscard]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last
         ) { return base<rfc7159>::parse_object (cb, first, last); }
 
 
-        static const char *
+        template <typename CallbackT>
+        static const char*
         parse_unknown [[noreturn]] (
-            const std::function<callback_t> &cb,
+            CallbackT &&cb,
             const char *first,
             const char *last)
         { throw base<rfc7159>::parse_unknown (cb, first, last); }
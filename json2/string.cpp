@@ -0,0 +1,121 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./string.hpp"
+#include "./except.hpp"
+
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+    /// appends the UTF-8 encoding of `c` to `dst`.
+    void
+    append_utf8 (std::string &dst, uint32_t c)
+    {
+        if (c < 0x80) {
+            dst += char (c);
+        } else if (c < 0x800) {
+            dst += char (0xc0 | (c >> 6));
+            dst += char (0x80 | (c & 0x3f));
+        } else if (c < 0x10000) {
+            dst += char (0xe0 | (c >> 12));
+            dst += char (0x80 | ((c >> 6) & 0x3f));
+            dst += char (0x80 | (c & 0x3f));
+        } else {
+            dst += char (0xf0 | (c >> 18));
+            dst += char (0x80 | ((c >> 12) & 0x3f));
+            dst += char (0x80 | ((c >> 6) & 0x3f));
+            dst += char (0x80 | (c & 0x3f));
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    uint32_t
+    read_hex4 (const char *src)
+    {
+        uint32_t res = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = src[i];
+            res <<= 4;
+            if      (c >= '0' && c <= '9') res |= uint32_t (c - '0');
+            else if (c >= 'a' && c <= 'f') res |= uint32_t (c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') res |= uint32_t (c - 'A' + 10);
+            else
+                throw util::json2::parse_error { src + i };
+        }
+        return res;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::string
+util::json2::unescape (std::string_view src)
+{
+    std::string res;
+    res.reserve (src.size ());
+
+    for (size_t i = 0; i < src.size (); ++i) {
+        if (src[i] != '\\') {
+            res += src[i];
+            continue;
+        }
+
+        if (++i == src.size ())
+            throw util::json2::overrun_error { src.data () + i };
+
+        switch (src[i]) {
+        case '"':  res += '"';  break;
+        case '\\': res += '\\'; break;
+        case '/':  res += '/';  break;
+        case 'b':  res += '\b'; break;
+        case 'f':  res += '\f'; break;
+        case 'n':  res += '\n'; break;
+        case 'r':  res += '\r'; break;
+        case 't':  res += '\t'; break;
+
+        case 'u': {
+            if (src.size () - i < 5)
+                throw util::json2::overrun_error { src.data () + i };
+
+            uint32_t c = read_hex4 (src.data () + i + 1);
+            i += 4;
+
+            // combine surrogate pairs where they're present; lone
+            // surrogates are passed through as-is.
+            if (c >= 0xd800 && c < 0xdc00 && i + 6 < src.size () &&
+                src[i + 1] == '\\' && src[i + 2] == 'u')
+            {
+                const uint32_t lo = read_hex4 (src.data () + i + 3);
+                if (lo >= 0xdc00 && lo < 0xe000) {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00);
+                    i += 6;
+                }
+            }
+
+            append_utf8 (res, c);
+            break;
+        }
+
+        default:
+            throw util::json2::parse_error { src.data () + i };
+        }
+    }
+
+    return res;
+}
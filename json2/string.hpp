@@ -0,0 +1,34 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_JSON2_STRING_HPP
+#define CRUFT_UTIL_JSON2_STRING_HPP
+
+#include <string>
+#include <string_view>
+
+
+namespace util::json2 {
+    /// returns the UTF-8 text represented by the body of a JSON string,
+    /// without its surrounding quotes.
+    ///
+    /// surrogate pairs are combined; lone surrogates are encoded as-is.
+    ///
+    /// throws parse_error for malformed escapes.
+    std::string unescape (std::string_view body);
+}
+
+#endif
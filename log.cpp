@@ -22,6 +22,7 @@
 #include "time.hpp"
 #include "cast.hpp"
 
+#include <atomic>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
@@ -228,31 +229,144 @@ level_width (void)
 }
 
 
+//-----------------------------------------------------------------------------
+/// returns the current local time formatted for the log, or nullptr on error.
+///
+/// the text is only regenerated when the second changes, rather than for
+/// every message.
+static const char*
+timestamp (void)
+{
+    static thread_local time_t last = -1;
+    static thread_local char text[sizeof ("YYYY-mm-dd HHMMhSS")];
+
+    const time_t now = time (nullptr);
+    if (now != last) {
+        if (0 == strftime (text, sizeof (text), "%Y-%m-%d %H%Mh%S", localtime (&now)))
+            return nullptr;
+        last = now;
+    }
+
+    return text;
+}
+
+
+//-----------------------------------------------------------------------------
+static void
+append_line (std::string &dst,
+             const char *time_string,
+             util::level_t level,
+             std::string_view msg)
+{
+    const auto &name = to_string (level);
+
+    dst += time_string;
+    dst += " [";
+    dst += name;
+    dst.append (level_width () - name.size (), ' ');
+    dst += "] ";
+    dst += msg;
+    dst += '\n';
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+static std::atomic<util::logging::sink*> s_sink;
+
+
+//-----------------------------------------------------------------------------
+util::logging::sink::~sink () = default;
+
+
+//-----------------------------------------------------------------------------
+util::logging::sink*
+util::logging::install (sink *dst)
+{
+    return s_sink.exchange (dst);
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::uninstall (sink *dst)
+{
+    s_sink.compare_exchange_strong (dst, nullptr);
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::flush (void)
+{
+    if (auto dst = s_sink.load ())
+        dst->flush ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::write (level_t level, std::string_view text)
+{
+    if (auto dst = s_sink.load ())
+        dst->write (level, text);
+    else
+        std::clog << text << std::flush;
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+util::logging::line (level_t level, std::string_view msg)
+{
+    const char *time_string = timestamp ();
+
+    std::string res;
+    append_line (res, time_string ? time_string : "", level, msg);
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+util::logging::line (level_t level, std::string_view msg, std::time_t when)
+{
+    char time_string[sizeof ("YYYY-mm-dd HHMMhSS")];
+    if (0 == strftime (time_string, sizeof (time_string), "%Y-%m-%d %H%Mh%S", localtime (&when)))
+        time_string[0] = '\0';
+
+    std::string res;
+    append_line (res, time_string, level, msg);
+    return res;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 void
 util::log (util::level_t level, const std::string &msg)
 {
     if (level <= log_level ()) {
-        static const size_t time_len = strlen("YYYY-mm-dd HHMMhSS") + 1;
-        std::string time_string (time_len - 1, '\0');
-        time_t unix_time = time (nullptr);
-
-        if (0 == strftime (&time_string[0],
-                    time_len,
-                    "%Y-%m-%d %H%Mh%S",
-                    localtime (&unix_time))) {
+        const char *time_string = timestamp ();
+        if (!time_string) {
             warn ("failed to log time");
             return;
         }
 
-        std::clog << time_string << " ["
-            << level_colour (level)
-            << std::setw (util::cast::lossless<int> (level_width ()))
-            << std::left
-            << level
-            << std::setw (0)
-            << util::term::csi::graphics::RESET
-        << "] " << msg << std::endl;
+        if (auto dst = s_sink.load ()) {
+            // reuse the line buffer so steady state logging doesn't allocate
+            static thread_local std::string buffer;
+            buffer.clear ();
+            append_line (buffer, time_string, level, msg);
+            dst->write (level, buffer);
+        } else {
+            std::clog << time_string << " ["
+                << level_colour (level)
+                << std::setw (util::cast::lossless<int> (level_width ()))
+                << std::left
+                << level
+                << std::setw (0)
+                << util::term::csi::graphics::RESET
+            << "] " << msg << std::endl;
+        }
     }
 
     if (needs_break (level))
@@ -22,8 +22,11 @@
 #include "preprocessor.hpp"
 #include "format.hpp"
 
+#include <cstdint>
+#include <ctime>
 #include <ostream>
 #include <string>
+#include <string_view>
 
 // Windows.h or one of its friends defines a macro 'ERROR'. Screw Microsoft.
 #ifdef ERROR
@@ -76,6 +79,70 @@ namespace util {
     level_t log_level (void);
     level_t log_level (level_t);
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Destinations for log output.
+    //
+    // By default messages are written synchronously to std::clog. Installing
+    // a sink redirects all subsequent output, including that of the LOG_*
+    // macros, to the sink instead.
+    namespace logging {
+        class sink {
+        public:
+            virtual ~sink ();
+
+            /// receives a complete line, as produced by logging::line,
+            /// including the trailing newline. may be called concurrently
+            /// from any thread.
+            virtual void write (level_t, std::string_view line) = 0;
+
+            /// receives a line which must never be discarded, even by a sink
+            /// which would otherwise drop lines under load; eg, the site
+            /// definitions that binary records refer to. it must be written
+            /// before any line subsequently passed to `write` by the same
+            /// thread.
+            virtual void preserve (level_t level, std::string_view line)
+            { write (level, line); }
+
+            /// writes out any buffered output before returning.
+            virtual void flush (void) { ; }
+
+            /// formats the notice that `count` lines have been discarded.
+            using notice_t = std::string (*) (uintmax_t count);
+
+            /// sets the form of the notices that the sink writes if it must
+            /// discard lines, so they match the encoding of the lines it
+            /// receives. eg, binary::install supplies a binary record.
+            virtual void notices (notice_t) { ; }
+        };
+
+        /// installs `dst` as the destination for all log output, returning
+        /// the previously installed sink. nullptr restores the default.
+        ///
+        /// the caller retains ownership, and must ensure the sink outlives
+        /// its installation.
+        sink* install (sink *dst);
+
+        /// restores the default destination if `dst` is currently installed.
+        void uninstall (sink *dst);
+
+        /// flushes the installed sink, if any. intended for use before
+        /// aborting, or from other crash paths.
+        void flush (void);
+
+        /// writes text which is already formatted, including any trailing
+        /// newline, to the installed sink or to std::clog. the log level is
+        /// not consulted.
+        void write (level_t, std::string_view text);
+
+        /// formats a message as it would appear in the log; with timestamp,
+        /// level, and trailing newline, but without terminal colours.
+        std::string line (level_t, std::string_view msg);
+
+        /// formats a message as if it were logged at the time `when`.
+        std::string line (level_t, std::string_view msg, std::time_t when);
+    }
+
+
     ///////////////////////////////////////////////////////////////////////////
     void log (level_t, const std::string &msg);
 
@@ -88,6 +155,16 @@ namespace util {
     }
 
 
+    /// logs a message using a format parsed at compile time; see
+    /// FORMAT_PRINTF.
+    template <const auto &FormatV, typename ...Args>
+    void
+    log (level_t l, const Args &...args)
+    {
+        log (l, to_string (format::bind<FormatV> (args...)));
+    }
+
+
     //-------------------------------------------------------------------------
     // Various convenience macros for logging specific strings with a well
     // known severity.
@@ -110,6 +187,18 @@ namespace util {
 #endif
 
 
+    //-------------------------------------------------------------------------
+    // Logs with a format that is parsed at compile time rather than on each
+    // call, and whose arguments are checked against it; see FORMAT_PRINTF.
+    //
+    // The format must be a string literal, eg:
+    //     LOG_LITERAL (util::WARN, "retrying %s after %u ms", host, delay);
+    #define LOG_LITERAL(LEVEL, FMT, ...) do {                                 \
+        static constexpr auto cruft_log_format_ = FORMAT_PRINTF (FMT);       \
+        util::log<cruft_log_format_> (LEVEL, ##__VA_ARGS__);                 \
+    } while (0)
+
+
     ///////////////////////////////////////////////////////////////////////////
     class scoped_logger : public nocopy {
     public:
@@ -0,0 +1,382 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./async.hpp"
+
+#include "../memory/buffer/circular.hpp"
+#include "../posix/except.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <string>
+
+#include <sys/uio.h>
+
+using util::logging::async;
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// a single-producer, single-consumer byte queue.
+///
+/// the storage is mapped twice in succession, so any span of up to the
+/// capacity is contiguous from any offset; appends and writes never need
+/// to be split at the wrap.
+///
+/// head and tail increase monotonically, and are only reduced modulo the
+/// capacity when addressing the storage.
+struct async::ring {
+    explicit ring (size_t capacity):
+        data (capacity)
+    { ; }
+
+    util::memory::buffer::circular<char> data;
+
+    /// written by the producing thread
+    alignas (64) std::atomic<size_t> head = 0;
+    /// written by the consuming thread
+    alignas (64) std::atomic<size_t> tail = 0;
+
+    /// lines discarded since the last report, under overflow::COUNT
+    std::atomic<size_t> dropped = 0;
+
+    /// set once the owning sink has been destroyed, so producing threads
+    /// can discard their cached references.
+    std::atomic<bool> closed = false;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// writes the entirety of the buffers in [first, last), retrying after
+/// partial writes and interruptions.
+static void
+write_all (int fd, iovec *first, iovec *last)
+{
+    while (first != last) {
+        const auto count = std::min<ptrdiff_t> (last - first, IOV_MAX);
+        const auto res = ::writev (fd, first, int (count));
+        if (res < 0) {
+            if (errno == EINTR)
+                continue;
+            util::posix::error::throw_code ();
+        }
+
+        // skip the buffers that were completely written, then trim the
+        // first that wasn't.
+        auto remain = size_t (res);
+        for ( ; first != last && remain >= first->iov_len; ++first)
+            remain -= first->iov_len;
+
+        if (first != last) {
+            first->iov_base = static_cast<char*> (first->iov_base) + remain;
+            first->iov_len -= remain;
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+static std::string
+text_notice (uintmax_t count)
+{
+    return util::logging::line (
+        util::WARNING, std::to_string (count) + " log messages dropped"
+    );
+}
+
+
+//-----------------------------------------------------------------------------
+static uintmax_t
+next_serial (void)
+{
+    static std::atomic<uintmax_t> serial = 0;
+    return ++serial;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+async::async (posix::fd dst,
+              size_t capacity,
+              overflow _overflow,
+              std::chrono::milliseconds interval):
+    async (std::move (dst), nullptr, capacity, _overflow, interval)
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+async::async (posix::fd dst,
+              filter_t filter,
+              size_t capacity,
+              overflow _overflow,
+              std::chrono::milliseconds interval):
+    m_fd (std::move (dst)),
+    m_filter (std::move (filter)),
+    m_capacity (capacity),
+    m_overflow (_overflow),
+    m_interval (interval),
+    m_serial (next_serial ()),
+    m_notice (&text_notice),
+    m_thread ([this] { run (); })
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+async::~async ()
+{
+    uninstall (this);
+
+    {
+        std::lock_guard<std::mutex> lk (m_mutex);
+        m_stopping = true;
+    }
+
+    m_cv.notify_one ();
+    m_thread.join ();
+
+    for (auto &r: m_rings)
+        r->closed = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+async::ring&
+async::local (void)
+{
+    struct entry {
+        uintmax_t serial;
+        std::shared_ptr<ring> value;
+    };
+
+    static thread_local std::vector<entry> cache;
+
+    for (const auto &e: cache)
+        if (e.serial == m_serial)
+            return *e.value;
+
+    // this is the first message from this thread, so take the opportunity
+    // to forget the rings of any sinks that have since been destroyed.
+    cache.erase (
+        std::remove_if (
+            cache.begin (),
+            cache.end (),
+            [] (const entry &e) { return e.value->closed.load (); }
+        ),
+        cache.end ()
+    );
+
+    auto value = std::make_shared<ring> (m_capacity);
+    {
+        std::lock_guard<std::mutex> lk (m_mutex);
+        m_rings.push_back (value);
+    }
+
+    cache.push_back ({ m_serial, value });
+    return *value;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+async::write (level_t, std::string_view line)
+{
+    auto &r = local ();
+    const size_t size = r.data.size ();
+
+    // a line longer than the ring could never be appended
+    const bool truncated = line.size () > size;
+    if (truncated)
+        line = line.substr (0, size);
+
+    const auto head = r.head.load (std::memory_order_relaxed);
+    auto tail = r.tail.load (std::memory_order_acquire);
+
+    while (size - (head - tail) < line.size ()) {
+        switch (m_overflow) {
+        case overflow::COUNT:
+            r.dropped.fetch_add (1, std::memory_order_relaxed);
+            [[fallthrough]];
+
+        case overflow::DROP:
+            m_dropped.fetch_add (1, std::memory_order_relaxed);
+            wake ();
+            return;
+
+        case overflow::BLOCK:
+            // notify unconditionally; a wake from `wake` may have been
+            // missed if it raced with the consumer beginning to wait.
+            m_pending = true;
+            m_cv.notify_one ();
+            std::this_thread::yield ();
+            tail = r.tail.load (std::memory_order_acquire);
+            continue;
+        }
+    }
+
+    auto dst = r.data.begin () + head % size;
+    std::copy_n (line.data (), line.size (), dst);
+    if (truncated)
+        dst[line.size () - 1] = '\n';
+
+    r.head.store (head + line.size (), std::memory_order_release);
+
+    // don't wait for the interval to elapse if we're at risk of overflow
+    if (head + line.size () - tail > size / 2)
+        wake ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+async::preserve (level_t, std::string_view line)
+{
+    {
+        std::lock_guard<std::mutex> lk (m_preserved_mutex);
+        m_preserved.emplace_back (line);
+    }
+
+    wake ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+async::notices (notice_t notice)
+{
+    m_notice = notice ? notice : &text_notice;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+async::flush (void)
+{
+    std::lock_guard<std::mutex> lk (m_mutex);
+    drain ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+async::wake (void)
+{
+    if (!m_pending.exchange (true))
+        m_cv.notify_one ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+async::run (void)
+{
+    std::unique_lock<std::mutex> lk (m_mutex);
+
+    while (!m_stopping) {
+        m_cv.wait_for (lk, m_interval, [this] { return m_pending || m_stopping; });
+        m_pending = false;
+        drain ();
+    }
+
+    drain ();
+}
+
+
+//-----------------------------------------------------------------------------
+// must be called with m_mutex held.
+void
+async::drain (void)
+{
+    // the extent of each ring is fixed before the preserved lines are
+    // taken, so that any line preserved before one of these appends is
+    // certain to be written ahead of it.
+    std::vector<size_t> heads;
+    for (const auto &r: m_rings)
+        heads.push_back (r->head.load (std::memory_order_acquire));
+
+    std::vector<std::string> notes;
+    {
+        std::lock_guard<std::mutex> lk (m_preserved_mutex);
+        notes.swap (m_preserved);
+    }
+
+    // summaries of dropped lines are written before the contents of the
+    // rings, so they must be gathered first to keep their storage stable.
+    const auto notice = m_notice.load ();
+    for (const auto &r: m_rings)
+        if (auto count = r->dropped.exchange (0))
+            notes.push_back (notice (count));
+
+    std::vector<iovec> buffers;
+    std::string filtered;
+
+    // as with write failures, a misbehaving filter has nowhere to report
+    // to, so we just lose its output.
+    const auto filter = [this, &filtered] (std::string_view data) {
+        try {
+            m_filter (data, filtered);
+        } catch (...) {
+            ;
+        }
+    };
+
+    for (const auto &n: notes) {
+        if (m_filter)
+            filter (n);
+        else
+            buffers.push_back ({ const_cast<char*> (n.data ()), n.size () });
+    }
+
+    for (size_t i = 0; i < m_rings.size (); ++i) {
+        const auto &r = m_rings[i];
+        const auto tail = r->tail.load (std::memory_order_relaxed);
+        const auto head = heads[i];
+
+        if (head == tail)
+            continue;
+
+        const auto data = r->data.begin () + tail % r->data.size ();
+
+        if (m_filter)
+            filter ({ data, head - tail });
+        else
+            buffers.push_back ({ data, head - tail });
+    }
+
+    if (!filtered.empty ())
+        buffers.push_back ({ filtered.data (), filtered.size () });
+
+    // there's nowhere to report a failure to write the log, so the output
+    // is discarded rather than leaving producers blocked on a full ring.
+    try {
+        write_all (m_fd, buffers.data (), buffers.data () + buffers.size ());
+    } catch (...) {
+        ;
+    }
+
+    for (size_t i = 0; i < m_rings.size (); ++i)
+        m_rings[i]->tail.store (heads[i], std::memory_order_release);
+
+    // forget the rings of threads which have exited, once they're empty
+    m_rings.erase (
+        std::remove_if (
+            m_rings.begin (),
+            m_rings.end (),
+            [] (const auto &r) {
+                return r.use_count () == 1 && r->head.load () == r->tail.load ();
+            }
+        ),
+        m_rings.end ()
+    );
+}
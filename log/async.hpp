@@ -0,0 +1,143 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_LOG_ASYNC_HPP
+#define CRUFT_UTIL_LOG_ASYNC_HPP
+
+#include "../log.hpp"
+#include "../posix/fd.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+namespace util::logging {
+    ///////////////////////////////////////////////////////////////////////////
+    /// A sink that moves log output off the calling thread.
+    ///
+    /// Each producing thread appends lines to its own single-producer ring
+    /// without taking any locks. A background thread gathers the contents of
+    /// every ring and writes them to the file descriptor with a single
+    /// writev, either every `interval` or sooner if a ring is filling.
+    ///
+    /// Lines from a given thread are written in order, but lines from
+    /// different threads may be interleaved arbitrarily.
+    class async : public sink {
+    public:
+        /// the action taken when a thread's ring is too full for a line.
+        enum class overflow {
+            /// discard the line
+            DROP,
+            /// discard the line, and report the number of lines discarded
+            /// once there is space again
+            COUNT,
+            /// wait for the background thread to make space
+            BLOCK,
+        };
+
+        /// transforms the contents of a ring before it is written, on the
+        /// background thread. it receives whole lines, and appends its
+        /// output to the string.
+        using filter_t = std::function<void (std::string_view, std::string&)>;
+
+        /// `capacity` is the minimum size in bytes of each thread's ring. it
+        /// is rounded up to a multiple of the page size, and bounds the
+        /// length of a line; longer lines are truncated.
+        explicit async (posix::fd dst,
+                        size_t capacity = 64 * 1024,
+                        overflow = overflow::COUNT,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds (10));
+
+        /// passes all output through `filter` before it is written; eg, to
+        /// format binary log records away from the logging threads.
+        async (posix::fd dst,
+               filter_t filter,
+               size_t capacity = 64 * 1024,
+               overflow = overflow::COUNT,
+               std::chrono::milliseconds interval = std::chrono::milliseconds (10));
+
+        /// writes out all remaining output. uninstalls the sink if it is
+        /// still installed.
+        ~async () override;
+
+        async (const async&) = delete;
+        async& operator= (const async&) = delete;
+
+        void write (level_t, std::string_view) override;
+
+        /// preserved lines are held outside the rings, so are never
+        /// discarded, and are written before the contents of the rings.
+        void preserve (level_t, std::string_view) override;
+
+        /// writes out everything appended by any thread before the call
+        /// began. this takes a lock, so is not async-signal-safe.
+        void flush (void) override;
+
+        /// notices are written before the contents of the rings, and pass
+        /// through the filter as though they were part of them.
+        void notices (notice_t) override;
+
+        /// the total number of lines discarded due to full rings.
+        uintmax_t dropped (void) const noexcept { return m_dropped; }
+
+    private:
+        struct ring;
+
+        ring& local (void);
+        void run (void);
+        void drain (void);
+        void wake (void);
+
+        posix::fd m_fd;
+        const filter_t m_filter;
+        const size_t m_capacity;
+        const overflow m_overflow;
+        const std::chrono::milliseconds m_interval;
+
+        /// distinguishes this instance in each thread's ring cache, which
+        /// might otherwise confuse a new instance at a recycled address.
+        const uintmax_t m_serial;
+
+        std::atomic<uintmax_t> m_dropped = 0;
+        std::atomic<notice_t> m_notice;
+
+        /// guards m_rings and serialises draining.
+        std::mutex m_mutex;
+        std::vector<std::shared_ptr<ring>> m_rings;
+
+        /// guards m_preserved. it's distinct from m_mutex as preserving may
+        /// happen under locks which a filter also takes while draining.
+        std::mutex m_preserved_mutex;
+        std::vector<std::string> m_preserved;
+
+        std::condition_variable m_cv;
+        std::atomic<bool> m_pending = false;
+        std::atomic<bool> m_stopping = false;
+        std::thread m_thread;
+    };
+}
+
+#endif
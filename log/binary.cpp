@@ -0,0 +1,408 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./binary.hpp"
+
+#include "../debug.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+using util::logging::binary::decoder;
+using util::logging::binary::kind;
+using util::logging::binary::site;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Record layout, in native byte order:
+//
+//   message:    u32 size, u32 site id, i64 nanoseconds since the epoch,
+//               followed by each argument
+//   definition: u32 size, u32 zero, u32 site id, u8 level, u8 count,
+//               followed by `count` kinds and the format string
+//   dropped:    a message from the reserved site ~0, with a single u64
+//               count of the records that a sink discarded
+//
+// arguments are stored as their raw value, except strings which are a u32
+// length and their bytes, and pointers which are stored as a uintptr_t.
+
+
+//-----------------------------------------------------------------------------
+namespace {
+    struct registration {
+        const site *owner;
+        std::vector<kind> kinds;
+    };
+
+    // sites are registered in order of first use; a site's id is its index
+    // plus one, so that zero may denote a definition.
+    //
+    // the lock also serialises installation of the sink with registration,
+    // so that every site is defined exactly once within each sink.
+    struct registry {
+        std::mutex mutex;
+        std::vector<registration> sites;
+        std::atomic<util::logging::sink*> sink = nullptr;
+    };
+
+
+    //-------------------------------------------------------------------------
+    registry&
+    get_registry (void)
+    {
+        static registry r;
+        return r;
+    }
+
+
+    //-------------------------------------------------------------------------
+    template <typename T>
+    T
+    read_raw (std::string_view &src)
+    {
+        if (src.size () < sizeof (T))
+            throw std::runtime_error ("truncated log record");
+
+        T res;
+        memcpy (&res, src.data (), sizeof (T));
+        src.remove_prefix (sizeof (T));
+        return res;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+static std::string
+definition_record (uint32_t id, const site &s, const std::vector<kind> &kinds)
+{
+    std::string res;
+    util::logging::binary::detail::append_raw (res, uint32_t (0));
+    util::logging::binary::detail::append_raw (res, uint32_t (0));
+    util::logging::binary::detail::append_raw (res, id);
+    res += char (s.level);
+    res += char (kinds.size ());
+    for (auto k: kinds)
+        res += char (k);
+    res += s.fmt;
+
+    const auto size = uint32_t (res.size ());
+    memcpy (&res[0], &size, sizeof (size));
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+util::logging::sink*
+util::logging::binary::install (sink *dst)
+{
+    auto &r = get_registry ();
+    std::lock_guard<std::mutex> lk (r.mutex);
+
+    auto prev = r.sink.exchange (dst);
+    if (dst) {
+        dst->notices (&detail::dropped);
+        for (size_t i = 0; i < r.sites.size (); ++i) {
+            const auto &s = r.sites[i];
+            dst->preserve (s.owner->level, definition_record (uint32_t (i + 1), *s.owner, s.kinds));
+        }
+    }
+
+    return prev;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::binary::uninstall (sink *dst)
+{
+    auto &r = get_registry ();
+    std::lock_guard<std::mutex> lk (r.mutex);
+    r.sink.compare_exchange_strong (dst, nullptr);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+util::logging::sink*
+util::logging::binary::detail::installed (void) noexcept
+{
+    return get_registry ().sink.load (std::memory_order_acquire);
+}
+
+
+//-----------------------------------------------------------------------------
+uint32_t
+util::logging::binary::detail::enrol (site &s, const kind *kinds, size_t count)
+{
+    auto &r = get_registry ();
+    std::lock_guard<std::mutex> lk (r.mutex);
+
+    // another thread may have registered the site while we waited
+    if (auto id = s.id.load ())
+        return id;
+
+    r.sites.push_back ({ &s, { kinds, kinds + count } });
+    const auto id = uint32_t (r.sites.size ());
+
+    if (auto dst = r.sink.load ())
+        dst->preserve (s.level, definition_record (id, s, r.sites.back ().kinds));
+
+    s.id.store (id, std::memory_order_release);
+    return id;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::binary::detail::finish (std::string &record, uint32_t id)
+{
+    const auto size = uint32_t (record.size ());
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds> (
+        std::chrono::system_clock::now ().time_since_epoch ()
+    ).count ();
+
+    memcpy (&record[0], &size, sizeof (size));
+    memcpy (&record[4], &id,   sizeof (id));
+    memcpy (&record[8], &now,  sizeof (now));
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+util::logging::binary::detail::dropped (uintmax_t count)
+{
+    std::string record (HEADER, '\0');
+    append_raw (record, uint64_t (count));
+    finish (record, DROPPED);
+    return record;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+decoder::define (std::string_view src)
+{
+    while (src.size () >= sizeof (uint32_t)) {
+        auto size = read_raw<uint32_t> (src);
+        if (size < sizeof (uint32_t) * 2 || size - sizeof (uint32_t) > src.size ())
+            return;
+
+        auto record = src.substr (0, size - sizeof (uint32_t));
+        src.remove_prefix (record.size ());
+
+        if (read_raw<uint32_t> (record) == 0)
+            define_record (record);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+void
+decoder::define (uint32_t id, level_t level, std::string_view fmt, std::vector<kind> kinds)
+{
+    auto [pos, inserted] = m_definitions.try_emplace (
+        id, definition { level, std::string (fmt), std::move (kinds), {} }
+    );
+
+    if (!inserted)
+        return;
+
+    auto &def = pos->second;
+    try {
+        def.specifiers = format::printf (
+            util::view<const char*> { def.fmt.data (), def.fmt.data () + def.fmt.size () }
+        );
+    } catch (...) {
+        // the message will be reported as malformed when it's decoded
+        def.specifiers = {};
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// `record` begins after the zero that identifies a definition.
+void
+decoder::define_record (std::string_view record)
+{
+    const auto id    = read_raw<uint32_t> (record);
+    const auto level = read_raw<uint8_t>  (record);
+    const auto count = read_raw<uint8_t>  (record);
+
+    if (record.size () < count)
+        throw std::runtime_error ("truncated log definition");
+
+    std::vector<kind> kinds;
+    for (size_t i = 0; i < count; ++i)
+        kinds.push_back (kind (record[i]));
+    record.remove_prefix (count);
+
+    define (id, level_t (level), record, std::move (kinds));
+}
+
+
+//-----------------------------------------------------------------------------
+const decoder::definition*
+decoder::find (uint32_t id)
+{
+    if (auto pos = m_definitions.find (id); pos != m_definitions.end ())
+        return &pos->second;
+
+    // fall back to the sites registered within this process
+    auto &r = get_registry ();
+    std::lock_guard<std::mutex> lk (r.mutex);
+
+    if (id == 0 || id > r.sites.size ())
+        return nullptr;
+
+    const auto &s = r.sites[id - 1];
+    define (id, s.owner->level, s.owner->fmt, s.kinds);
+    return &m_definitions.find (id)->second;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename ValueT>
+static void
+write_value (std::ostream &os, const util::format::specifier &spec, std::string_view &args)
+{
+    util::format::value<ValueT>::write (os, spec, read_raw<ValueT> (args));
+}
+
+
+//-----------------------------------------------------------------------------
+static void
+write_argument (std::ostream &os,
+                const util::format::specifier &spec,
+                kind k,
+                std::string_view &args)
+{
+    switch (k) {
+    case kind::BOOL:    write_value<bool>     (os, spec, args); return;
+    case kind::CHAR:    write_value<char>     (os, spec, args); return;
+    case kind::SINT8:   write_value<int8_t>   (os, spec, args); return;
+    case kind::SINT16:  write_value<int16_t>  (os, spec, args); return;
+    case kind::SINT32:  write_value<int32_t>  (os, spec, args); return;
+    case kind::SINT64:  write_value<int64_t>  (os, spec, args); return;
+    case kind::UINT8:   write_value<uint8_t>  (os, spec, args); return;
+    case kind::UINT16:  write_value<uint16_t> (os, spec, args); return;
+    case kind::UINT32:  write_value<uint32_t> (os, spec, args); return;
+    case kind::UINT64:  write_value<uint64_t> (os, spec, args); return;
+    case kind::REAL32:  write_value<float>    (os, spec, args); return;
+    case kind::REAL64:  write_value<double>   (os, spec, args); return;
+
+    case kind::STRING: {
+        const auto size = read_raw<uint32_t> (args);
+        if (size == ~uint32_t (0)) {
+            util::format::value<const char*>::write (os, spec, nullptr);
+            return;
+        }
+
+        if (size > args.size ())
+            throw std::runtime_error ("truncated log string");
+
+        util::format::value<util::view<const char*>>::write (
+            os, spec, util::view<const char*> { args.data (), args.data () + size }
+        );
+        args.remove_prefix (size);
+        return;
+    }
+
+    case kind::POINTER:
+        util::format::value<const void*>::write (
+            os, spec, reinterpret_cast<const void*> (read_raw<uintptr_t> (args))
+        );
+        return;
+    }
+
+    throw std::runtime_error ("unknown log argument kind");
+}
+
+
+//-----------------------------------------------------------------------------
+std::string
+decoder::render (const definition &def, std::string_view args)
+{
+    std::ostringstream os;
+    size_t index = 0;
+
+    try {
+        if (def.specifiers.m_specifiers.empty () && !def.fmt.empty ())
+            throw std::runtime_error ("invalid format specification");
+
+        for (const auto &spec: def.specifiers) {
+            switch (spec.type) {
+            case format::type_t::LITERAL:
+                os.write (spec.fmt.data (), spec.fmt.size ());
+                break;
+
+            case format::type_t::ESCAPE:
+                os << '%';
+                break;
+
+            default:
+                if (index == def.kinds.size ())
+                    throw std::runtime_error ("insufficient data parameters");
+                write_argument (os, spec, def.kinds[index++], args);
+                break;
+            }
+        }
+    } catch (const std::exception &x) {
+        return def.fmt + " [" + x.what () + "]";
+    }
+
+    return os.str ();
+}
+
+
+//-----------------------------------------------------------------------------
+void
+decoder::decode (std::string_view src, std::string &dst)
+{
+    while (src.size () >= sizeof (uint32_t)) {
+        auto size = read_raw<uint32_t> (src);
+        if (size < sizeof (uint32_t) * 2 || size - sizeof (uint32_t) > src.size ()) {
+            dst += line (ERROR, "truncated binary log record");
+            return;
+        }
+
+        auto record = src.substr (0, size - sizeof (uint32_t));
+        src.remove_prefix (record.size ());
+
+        const auto id = read_raw<uint32_t> (record);
+        if (id == 0) {
+            define_record (record);
+            continue;
+        }
+
+        const auto nanoseconds = read_raw<int64_t> (record);
+        const auto when = std::time_t (nanoseconds / 1'000'000'000);
+
+        if (id == detail::DROPPED) {
+            const auto count = read_raw<uint64_t> (record);
+            dst += line (WARNING, std::to_string (count) + " log messages dropped", when);
+            continue;
+        }
+
+        const auto def = find (id);
+        if (!def) {
+            dst += line (ERROR, "undefined binary log site " + std::to_string (id), when);
+            continue;
+        }
+
+        dst += line (def->level, render (*def, record), when);
+    }
+}
@@ -0,0 +1,304 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_LOG_BINARY_HPP
+#define CRUFT_UTIL_LOG_BINARY_HPP
+
+#include "../log.hpp"
+#include "../view.hpp"
+
+#include "../format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Logging with deferred formatting.
+//
+// A call records the identity of its call site and the raw bytes of its
+// arguments, and nothing else. The text is produced later by a decoder;
+// either on the background thread of an async sink, or offline from a
+// file by the log-decode tool.
+//
+// Each call site is described to the sink by a definition record, written
+// before the first message from that site. Definitions hold the level,
+// format string, and the type of each argument.
+//
+// Records are written in the native byte order, so binary logs should be
+// decoded on a machine of the same architecture.
+//
+// Supported argument types are: bool, char, integers, float, double,
+// strings (which are copied), and pointers (whose values are recorded).
+// Strings are truncated to MAX_STRING bytes, and calls are limited to
+// MAX_ARGS arguments, so a record always fits within a single page; the
+// smallest ring an async sink will allocate.
+//
+// If no binary sink has been installed the message is formatted
+// immediately and passed to util::log.
+namespace util::logging::binary {
+    /// the type of a recorded argument
+    enum class kind : uint8_t {
+        BOOL,
+        CHAR,
+        SINT8, SINT16, SINT32, SINT64,
+        UINT8, UINT16, UINT32, UINT64,
+        REAL32, REAL64,
+        STRING,
+        POINTER,
+    };
+
+
+    constexpr size_t MAX_ARGS = 15;
+    constexpr size_t MAX_STRING = 240;
+
+
+    /// the static description of a logging call site.
+    ///
+    /// sites are intended to be function local statics, and can be
+    /// constant initialised so the hot path never checks a guard.
+    struct site {
+        constexpr site (level_t _level, const char *_fmt) noexcept:
+            level (_level),
+            fmt (_fmt),
+            id (0)
+        { ; }
+
+        const level_t level;
+        const char *const fmt;
+
+        /// assigned when the first message is logged from this site
+        std::atomic<uint32_t> id;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// installs `dst` as the destination for binary records, returning the
+    /// previous destination.
+    ///
+    /// the definitions of all sites seen so far are immediately written to
+    /// `dst`, so it can always be decoded in isolation. `dst` is asked to
+    /// write any notices of discarded records as binary records too; it
+    /// continues to do so after it's uninstalled, so a sink shouldn't be
+    /// shared between binary and text output.
+    sink* install (sink *dst);
+
+    /// restores immediate formatting if `dst` is currently installed.
+    void uninstall (sink *dst);
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// converts a sequence of binary records into log lines.
+    ///
+    /// sites are resolved against the definitions seen by `define` and, for
+    /// logs recorded within this process, against the sites that have been
+    /// registered here.
+    class decoder {
+    public:
+        /// records every definition within `src`.
+        ///
+        /// a definition may follow messages from its site when several
+        /// threads log concurrently, so files should be defined in full
+        /// before being decoded.
+        void define (std::string_view src);
+
+        /// appends the text of each message within `src` to `dst`.
+        ///
+        /// `src` must consist of whole records.
+        void decode (std::string_view src, std::string &dst);
+
+        /// a callable suitable for the filter of an async sink.
+        void operator() (std::string_view src, std::string &dst)
+        { decode (src, dst); }
+
+    private:
+        // definitions are never moved once inserted into the map, so the
+        // specifiers may refer into the format string.
+        struct definition {
+            level_t level;
+            std::string fmt;
+            std::vector<kind> kinds;
+            format::parsed specifiers;
+        };
+
+        void define (uint32_t id, level_t, std::string_view fmt, std::vector<kind>);
+        void define_record (std::string_view record);
+        std::string render (const definition&, std::string_view args);
+
+        const definition* find (uint32_t id);
+
+        std::map<uint32_t, definition> m_definitions;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    namespace detail {
+        template <typename T>
+        constexpr bool is_string_v =
+            std::is_same_v<T, const char*> ||
+            std::is_same_v<T, char*> ||
+            std::is_same_v<T, std::string> ||
+            std::is_same_v<T, std::string_view> ||
+            std::is_same_v<T, util::view<const char*>>;
+
+
+        //---------------------------------------------------------------------
+        template <typename T>
+        constexpr kind
+        kind_of (void)
+        {
+            if constexpr (std::is_same_v<T, bool>) {
+                return kind::BOOL;
+            } else if constexpr (std::is_same_v<T, char>) {
+                return kind::CHAR;
+            } else if constexpr (std::is_integral_v<T>) {
+                constexpr kind SIGNED[]   = { kind::SINT8, kind::SINT16, kind::SINT32, kind::SINT64 };
+                constexpr kind UNSIGNED[] = { kind::UINT8, kind::UINT16, kind::UINT32, kind::UINT64 };
+                constexpr int index = sizeof (T) == 1 ? 0 : sizeof (T) == 2 ? 1 : sizeof (T) == 4 ? 2 : 3;
+                static_assert (sizeof (T) <= 8);
+                return std::is_signed_v<T> ? SIGNED[index] : UNSIGNED[index];
+            } else if constexpr (std::is_same_v<T, float>) {
+                return kind::REAL32;
+            } else if constexpr (std::is_same_v<T, double>) {
+                return kind::REAL64;
+            } else if constexpr (is_string_v<T>) {
+                return kind::STRING;
+            } else {
+                static_assert (std::is_pointer_v<T>, "unsupported deferred log argument");
+                return kind::POINTER;
+            }
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename T>
+        void
+        append_raw (std::string &dst, const T &val)
+        {
+            dst.append (reinterpret_cast<const char*> (&val), sizeof (val));
+        }
+
+
+        //---------------------------------------------------------------------
+        /// strings are stored as a 32 bit length followed by their bytes. a
+        /// null C string is given a length of ~0.
+        inline void
+        append_string (std::string &dst, const char *first, size_t size)
+        {
+            size = std::min (size, MAX_STRING);
+            append_raw (dst, uint32_t (size));
+            dst.append (first, size);
+        }
+
+
+        //---------------------------------------------------------------------
+        template <typename T>
+        void
+        append (std::string &dst, const T &val)
+        {
+            if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+                if (!val)
+                    append_raw (dst, ~uint32_t (0));
+                else
+                    append_string (dst, val, strlen (val));
+            } else if constexpr (is_string_v<T>) {
+                append_string (dst, std::data (val), std::size (val));
+            } else if constexpr (std::is_pointer_v<T>) {
+                append_raw (dst, reinterpret_cast<uintptr_t> (val));
+            } else {
+                append_raw (dst, val);
+            }
+        }
+
+
+        //---------------------------------------------------------------------
+        /// the installed binary sink, or nullptr.
+        sink* installed (void) noexcept;
+
+        /// registers a site on its first use and returns its id.
+        uint32_t enrol (site&, const kind *kinds, size_t count);
+
+        /// formats the message immediately for util::log.
+        template <typename ...Args>
+        void
+        fallback (const site &s, const Args &...args);
+
+        /// the length of the record header, which is filled by `finish`.
+        constexpr size_t HEADER = sizeof (uint32_t) * 2 + sizeof (int64_t);
+
+        void finish (std::string &record, uint32_t id);
+
+        /// the site id reserved for records of discarded messages
+        constexpr uint32_t DROPPED = ~uint32_t (0);
+
+        /// a record noting that `count` records were discarded by a sink.
+        std::string dropped (uintmax_t count);
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    template <typename ...Args>
+    void
+    log (site &s, const Args &...args)
+    {
+        static_assert (sizeof... (Args) <= MAX_ARGS);
+
+        if (s.level > log_level ())
+            return;
+
+        auto dst = detail::installed ();
+        if (!dst) {
+            detail::fallback (s, args...);
+            return;
+        }
+
+        auto id = s.id.load (std::memory_order_acquire);
+        if (!id) {
+            // the trailing value avoids a zero length array, and isn't used
+            static constexpr kind KINDS[] = {
+                detail::kind_of<std::decay_t<const Args>> ()..., kind::BOOL
+            };
+            id = detail::enrol (s, KINDS, sizeof... (Args));
+        }
+
+        static thread_local std::string record;
+        record.resize (detail::HEADER);
+        (detail::append<std::decay_t<const Args>> (record, args), ...);
+        detail::finish (record, id);
+
+        dst->write (s.level, record);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+/// logs a printf style message whose formatting is deferred, eg:
+///     LOG_DEFERRED (util::WARN, "retrying %s after %u ms", host, delay);
+#define LOG_DEFERRED(LEVEL, FMT, ...) do {                                  \
+    static util::logging::binary::site cruft_log_site_ { LEVEL, FMT };     \
+    util::logging::binary::log (cruft_log_site_, ##__VA_ARGS__);           \
+} while (0)
+
+#include "./binary.ipp"
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifdef CRUFT_UTIL_LOG_BINARY_IPP
+#error
+#endif
+
+#define CRUFT_UTIL_LOG_BINARY_IPP
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename ...Args>
+void
+util::logging::binary::detail::fallback (const site &s, const Args &...args)
+{
+    const util::view<const char*> fmt { s.fmt, s.fmt + strlen (s.fmt) };
+    util::log (s.level, format::to_string (format::printf (fmt) (args...)));
+}
@@ -0,0 +1,121 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_LOG_LIMIT_HPP
+#define CRUFT_UTIL_LOG_LIMIT_HPP
+
+#include "../log.hpp"
+#include "../time.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Per call site limits on logging, so a storm of identical messages can't
+// saturate the output.
+//
+// The limits are usually applied through the LOG_LIMITED and LOG_SAMPLED
+// macros, which hold a limit as a static at each call site. They may also
+// be declared directly to guard other kinds of output; eg, structured
+// messages.
+namespace util::logging {
+    /// admits messages at `rate` per second, with bursts of up to `burst`,
+    /// and counts those that are suppressed.
+    class limited {
+    public:
+        limited (double rate, unsigned burst):
+            m_bucket (rate, burst)
+        { ; }
+
+        /// returns nothing if the message should be suppressed, otherwise
+        /// the number of messages suppressed since the last was admitted.
+        std::optional<uintmax_t>
+        admit (uint64_t now = nanoseconds ())
+        {
+            if (!m_bucket.try_acquire (now)) {
+                m_suppressed.fetch_add (1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+
+            return m_suppressed.exchange (0, std::memory_order_relaxed);
+        }
+
+    private:
+        token_bucket m_bucket;
+        std::atomic<uintmax_t> m_suppressed = 0;
+    };
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// admits the first message, and every `period`th message thereafter.
+    class sampled {
+    public:
+        explicit constexpr sampled (unsigned period) noexcept:
+            m_period (period ? period : 1),
+            m_count (0)
+        { ; }
+
+        bool
+        admit (void) noexcept
+        {
+            return m_count.fetch_add (1, std::memory_order_relaxed) % m_period == 0;
+        }
+
+    private:
+        const unsigned m_period;
+        std::atomic<uintmax_t> m_count;
+    };
+}
+
+
+//-----------------------------------------------------------------------------
+/// logs at most RATE messages per second, in bursts of up to BURST, from
+/// this call site. the number of suppressed messages is logged before the
+/// next message that is admitted, eg:
+///     LOG_LIMITED (util::WARN, 1, 5, "short read on %s", path);
+#define LOG_LIMITED(LEVEL, RATE, BURST, FMT, ...) do {                      \
+    static util::logging::limited cruft_log_limit_ { RATE, BURST };         \
+    if ((LEVEL) > util::log_level ())                                       \
+        break;                                                              \
+                                                                            \
+    if (auto cruft_admitted_ = cruft_log_limit_.admit ()) {                 \
+        if (*cruft_admitted_) {                                             \
+            LOG_LITERAL (                                                   \
+                LEVEL, "suppressed %ju messages like '%s'",                 \
+                *cruft_admitted_, FMT                                       \
+            );                                                              \
+        }                                                                   \
+                                                                            \
+        LOG_LITERAL (LEVEL, FMT, ##__VA_ARGS__);                            \
+    }                                                                       \
+} while (0)
+
+
+//-----------------------------------------------------------------------------
+/// logs one in every PERIOD messages from this call site, eg:
+///     LOG_SAMPLED (util::DEBUG, 100, "frame %u", index);
+#define LOG_SAMPLED(LEVEL, PERIOD, FMT, ...) do {                           \
+    static util::logging::sampled cruft_log_sample_ { PERIOD };             \
+    if ((LEVEL) > util::log_level ())                                       \
+        break;                                                              \
+                                                                            \
+    if (cruft_log_sample_.admit ())                                         \
+        LOG_LITERAL (LEVEL, FMT, ##__VA_ARGS__);                            \
+} while (0)
+
+#endif
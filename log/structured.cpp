@@ -0,0 +1,80 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "./structured.hpp"
+
+#include "../json/writer.hpp"
+#include "../platform.hpp"
+
+using util::logging::structured::field;
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// a thread safe gmtime; returns false if `when` can't be converted.
+static bool
+utc (std::time_t when, std::tm &parts)
+{
+#if defined(PLATFORM_WIN32)
+    return gmtime_s (&parts, &when) == 0;
+#else
+    return gmtime_r (&when, &parts) != nullptr;
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+std::string
+util::logging::structured::line (level_t level,
+                                 std::string_view message,
+                                 std::initializer_list<field> fields,
+                                 std::time_t when)
+{
+    char time_string[sizeof ("YYYY-mm-ddTHH:MM:SSZ")];
+    std::tm parts;
+    if (!utc (when, parts) ||
+        0 == strftime (time_string, sizeof (time_string), "%Y-%m-%dT%H:%M:%SZ", &parts))
+        time_string[0] = '\0';
+
+    json::writer out;
+    out.begin_object ();
+    out.key ("time").value (std::string_view (time_string));
+    out.key ("level").value (std::string_view (to_string (level)));
+    out.key ("message").value (message);
+
+    for (const auto &f: fields) {
+        out.key (f.key);
+        std::visit ([&out] (auto v) { out.value (v); }, f.value);
+    }
+
+    out.end_object ();
+
+    auto res = out.str ();
+    res += '\n';
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+void
+util::logging::structured::log (level_t level,
+                                std::string_view message,
+                                std::initializer_list<field> fields)
+{
+    if (level > log_level ())
+        return;
+
+    write (level, line (level, message, fields, std::time (nullptr)));
+}
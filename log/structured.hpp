@@ -0,0 +1,97 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#ifndef CRUFT_UTIL_LOG_STRUCTURED_HPP
+#define CRUFT_UTIL_LOG_STRUCTURED_HPP
+
+#include "../log.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Messages with key/value fields, written as one JSON object per line; eg,
+//
+//     {"time":"2018-01-02T03:04:05Z","level":"WARN","message":"slow query","ms":250}
+//
+// Lines are written to the installed sink, or to std::clog, in the same
+// manner as other log messages.
+namespace util::logging::structured {
+    struct field {
+        template <typename ValueT>
+        field (std::string_view _key, const ValueT &_value):
+            key (_key),
+            value (convert (_value))
+        { ; }
+
+        std::string_view key;
+        std::variant<
+            std::nullptr_t,
+            bool,
+            intmax_t,
+            uintmax_t,
+            double,
+            std::string_view
+        > value;
+
+    private:
+        template <typename ValueT>
+        static decltype(value)
+        convert (const ValueT &val)
+        {
+            using value_t = std::decay_t<ValueT>;
+
+            if constexpr (std::is_same_v<value_t, bool> || std::is_null_pointer_v<value_t>) {
+                return val;
+            } else if constexpr (std::is_integral_v<value_t> && std::is_signed_v<value_t>) {
+                return intmax_t (val);
+            } else if constexpr (std::is_integral_v<value_t>) {
+                return uintmax_t (val);
+            } else if constexpr (std::is_floating_point_v<value_t>) {
+                return double (val);
+            } else {
+                static_assert (
+                    std::is_convertible_v<const ValueT&, std::string_view>,
+                    "unsupported structured log field"
+                );
+                return std::string_view (val);
+            }
+        }
+    };
+
+
+    /// formats a message as a JSON line, as if it were logged at `when`.
+    std::string line (level_t, std::string_view message, std::initializer_list<field>, std::time_t when);
+
+    /// logs a message with the given fields if `level` is enabled.
+    void log (level_t, std::string_view message, std::initializer_list<field>);
+}
+
+
+//-----------------------------------------------------------------------------
+/// logs a message with key/value fields, eg:
+///     LOG_FIELDS (util::WARN, "slow query", {"ms", elapsed}, {"table", name});
+#define LOG_FIELDS(LEVEL, MESSAGE, ...) \
+    util::logging::structured::log (LEVEL, MESSAGE, { __VA_ARGS__ })
+
+#endif
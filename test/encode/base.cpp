@@ -3,6 +3,12 @@
 #include "../../encode/base.hpp"
 #include "../../iterator.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 
 ///////////////////////////////////////////////////////////////////////////////
 static constexpr char input[] = "foobar";
@@ -74,6 +80,190 @@ test_size (util::TAP::logger &tap)
 
         tap.expect_eq (decoded, fragment, "%! character base%! decode, '%!'", i, Size, decoded);
     }
+
+    // symbols outside the alphabet must be rejected rather than decoded as
+    // zero, including bytes with the high bit set and misplaced padding.
+    const std::string valid = output_v<Size>[std::size (input) - 1];
+    for (const char bad: { '~', '\xff', '=' }) {
+        auto corrupt = valid;
+        corrupt[0] = bad;
+
+        tap.expect_throw<std::invalid_argument> (
+            [&] () {
+                std::string decoded;
+                util::encode::base<Size>::decode (std::back_inserter (decoded), util::make_view (corrupt));
+            },
+            "base%! decode rejects symbol %!", Size, int (static_cast<unsigned char> (bad))
+        );
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// contiguous (pointer) views may be handled by vectorised kernels whereas
+// container iterators always use the scalar code. check that both paths
+// produce identical output across a range of lengths, including inputs
+// with invalid symbols that force the kernels to bail out early.
+template <int Size>
+void
+test_kernels (util::TAP::logger &tap)
+{
+    std::vector<uint8_t> data (1031);
+    uint32_t state = 0x1234567;
+    for (auto &i: data) {
+        state = state * 1103515245 + 12345;
+        i = state >> 24;
+    }
+
+    bool encode_success = true;
+    bool decode_success = true;
+    bool direct_success = true;
+    bool invalid_success = true;
+
+    for (size_t len = 0; len <= data.size (); len += len < 128 ? 1 : 61) {
+        std::string scalar, simd;
+
+        util::encode::base<Size>::encode (
+            std::back_inserter (scalar),
+            util::view { data.cbegin (), data.cbegin () + len }
+        );
+        util::encode::base<Size>::encode (
+            std::back_inserter (simd),
+            util::view { data.data (), data.data () + len }
+        );
+
+        encode_success = encode_success && scalar == simd;
+
+        std::vector<uint8_t> decoded_scalar, decoded_simd;
+        util::encode::base<Size>::decode (
+            std::back_inserter (decoded_scalar),
+            util::view { scalar.cbegin (), scalar.cend () }
+        );
+        util::encode::base<Size>::decode (
+            std::back_inserter (decoded_simd),
+            util::view { scalar.data (), scalar.data () + scalar.size () }
+        );
+
+        decode_success = decode_success &&
+            decoded_scalar == decoded_simd &&
+            std::equal (data.begin (), data.begin () + len, decoded_simd.begin (), decoded_simd.end ());
+
+        // write directly into a pointer rather than an iterator
+        std::vector<uint8_t> direct (len);
+        auto last = util::encode::base<Size>::decode (
+            direct.data (),
+            util::view { scalar.data (), scalar.data () + scalar.size () }
+        );
+        direct_success = direct_success &&
+            last == direct.data () + len &&
+            std::equal (data.begin (), data.begin () + len, direct.begin ());
+
+        // corrupt a symbol part way through the input
+        if (scalar.size () > 8) {
+            scalar[scalar.size () / 2] = '~';
+
+            const auto rejects = [] (auto &&fn) {
+                try {
+                    fn ();
+                    return false;
+                } catch (const std::invalid_argument&) {
+                    return true;
+                }
+            };
+
+            invalid_success = invalid_success && rejects ([&] {
+                util::encode::base<Size>::decode (
+                    std::back_inserter (decoded_scalar),
+                    util::view { scalar.cbegin (), scalar.cend () }
+                );
+            });
+
+            invalid_success = invalid_success && rejects ([&] {
+                util::encode::base<Size>::decode (
+                    std::back_inserter (decoded_simd),
+                    util::view { scalar.data (), scalar.data () + scalar.size () }
+                );
+            });
+        }
+    }
+
+    tap.expect (encode_success, "base%! contiguous encode matches scalar", Size);
+    tap.expect (decode_success, "base%! contiguous decode matches scalar", Size);
+    tap.expect (direct_success, "base%! decode to pointer", Size);
+    tap.expect (invalid_success, "base%! invalid symbols rejected", Size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// feed the streaming coders a variety of chunk sizes and check they match
+// the one-shot coders over the same data.
+template <int Size>
+void
+test_stream (util::TAP::logger &tap)
+{
+    std::vector<uint8_t> data (517);
+    for (size_t i = 0; i < data.size (); ++i)
+        data[i] = i * 7 + (i >> 3);
+
+    std::string expected;
+    util::encode::base<Size>::encode (
+        std::back_inserter (expected),
+        util::view { data.cbegin (), data.cend () }
+    );
+
+    for (const size_t chunk: { 1, 2, 3, 7, 64, 1000 }) {
+        // encode
+        util::encode::encoder<Size> enc;
+        std::string encoded (expected.size (), '\0');
+        char *cursor = encoded.data ();
+        bool exact = true;
+
+        for (size_t i = 0; i < data.size (); i += chunk) {
+            const auto len = std::min (chunk, data.size () - i);
+            const auto size = enc.update_size (len);
+            const auto next = enc.update (cursor, { data.data () + i, data.data () + i + len });
+            exact = exact && next - cursor == static_cast<ptrdiff_t> (size);
+            cursor = next;
+        }
+
+        const auto size = enc.finish_size ();
+        const auto next = enc.finish (cursor);
+        exact = exact && next - cursor == static_cast<ptrdiff_t> (size);
+        cursor = next;
+
+        tap.expect (exact, "base%! encoder sizes, %! byte chunks", Size, chunk);
+        tap.expect_eq (
+            std::string (encoded.data (), cursor), expected,
+            "base%! encoder, %! byte chunks", Size, chunk
+        );
+
+        // decode
+        util::encode::decoder<Size> dec;
+        std::vector<uint8_t> decoded (data.size ());
+        uint8_t *out = decoded.data ();
+
+        for (size_t i = 0; i < expected.size (); i += chunk) {
+            const auto len = std::min (chunk, expected.size () - i);
+            out = dec.update (out, { expected.data () + i, expected.data () + i + len });
+        }
+        dec.finish ();
+
+        tap.expect (
+            out == decoded.data () + decoded.size () && decoded == data,
+            "base%! decoder, %! byte chunks", Size, chunk
+        );
+    }
+
+    // a truncated stream should be rejected at finish time
+    if (util::encode::base<Size>::group_symbols > 1) {
+        util::encode::decoder<Size> dec;
+        std::vector<uint8_t> decoded (data.size ());
+        dec.update (decoded.data (), { expected.data (), expected.data () + 1 });
+        tap.expect_throw<std::invalid_argument> (
+            [&] () { dec.finish (); },
+            "base%! decoder rejects partial group", Size
+        );
+    }
 }
 
 
@@ -87,5 +277,13 @@ main ()
     test_size<32> (tap);
     test_size<64> (tap);
 
+    test_kernels<16> (tap);
+    test_kernels<32> (tap);
+    test_kernels<64> (tap);
+
+    test_stream<16> (tap);
+    test_stream<32> (tap);
+    test_stream<64> (tap);
+
     return tap.status ();
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "tap.hpp"
 
 #include <iostream>
+#include <sstream>
+#include <string_view>
 
 ///////////////////////////////////////////////////////////////////////////////
 struct userobj { };
@@ -20,6 +22,9 @@ main (void)
 {
     util::TAP::logger tap;
 
+    // each format is rendered with both the runtime and compile time
+    // parsers, and with both the buffer and stream renderers, which should
+    // always agree.
     #define CHECK_RENDER(fmt,res,...) do {                              \
         auto val = to_string (util::format::printf (fmt)(__VA_ARGS__)); \
         if (val != res) {                                               \
@@ -27,6 +32,16 @@ main (void)
             std::clog << "expected: '" << res << "'\n";                 \
         }                                                               \
         tap.expect_eq (val, res, "render '%s'", fmt);                   \
+                                                                        \
+        std::ostringstream os;                                          \
+        os << util::format::printf (fmt)(__VA_ARGS__);                  \
+        tap.expect_eq (os.str (), res, "stream render '%s'", fmt);      \
+                                                                        \
+        static constexpr auto compiled = FORMAT_PRINTF (fmt);           \
+        auto fixed = to_string (                                        \
+            util::format::bind<compiled> (__VA_ARGS__)                  \
+        );                                                              \
+        tap.expect_eq (fixed, res, "compiled render '%s'", fmt);        \
     } while (0)
 
     CHECK_RENDER ("foo", "foo");
@@ -151,7 +166,11 @@ main (void)
     CHECK_RENDER ("%p", "0x1234567", (int*)0x01234567);
     CHECK_RENDER ("%p", "0x1234567", (char*)0x01234567);
     CHECK_RENDER ("%p", "(nil)", nullptr);
-    CHECK_RENDER ("%p", "(nil)", NULL);
+    CHECK_RENDER ("%p", "(nil)", (void*)NULL);
+
+    // NULL may be an integer, and binding it as the compiled arm's argument
+    // raises -Wconversion-null, so it's only checked at runtime.
+    tap.expect_eq (to_string (util::format::printf ("%p") (NULL)), "(nil)", "render '%%p' with NULL");
     CHECK_RENDER ("%!", "0x1234567", (void*)0x01234567);
 
     CHECK_RENDER ("%%", "%");
@@ -177,6 +196,35 @@ main (void)
 
     tap.expect_eq (to_string (util::format::printf ("%u\n")(1u)), "1\n", "newline");
 
+    CHECK_RENDER ("%5s|%-5s", "  foo|foo  ", "foo", "foo");
+    CHECK_RENDER ("%.2f %f", "1.50 1.500000", 1.5, 1.5);
+    CHECK_RENDER ("%05i %5i", "00001     1", 1, 1);
+    CHECK_RENDER ("%.100f", std::string ("1.") + std::string (100, '0'), 1.);
+
+    // rendering to fixed buffers truncates, but reports the complete size
+    {
+        char buffer[8];
+        auto fmt = util::format::printf ("%s=%u");
+        const auto res = util::format::format_to_n (
+            buffer, sizeof (buffer), fmt ("length", 1234u)
+        );
+
+        tap.expect (
+            res.size == 11 &&
+            res.out == buffer + sizeof (buffer) &&
+            std::string_view (buffer, sizeof (buffer)) == "length=1",
+            "format_to_n truncates"
+        );
+    }
+
+    // rendering to strings appends
+    {
+        std::string dst = "prefix ";
+        auto fmt = util::format::printf ("%i %!");
+        util::format::format_to (dst, fmt (-7, userobj {}));
+        tap.expect_eq (dst, "prefix -7 userobj", "format_to appends");
+    }
+
     #define CHECK_THROW(fmt,except,...) do {                        \
         tap.expect_throw<std::exception> ([&] {                     \
             to_string (util::format::printf (fmt)(__VA_ARGS__));    \
@@ -217,5 +265,51 @@ main (void)
     CHECK_THROW("%c", conversion_error, 1u);
     CHECK_THROW("%c", conversion_error, "foo");
 
+    // mismatched arguments are detected while compiling. the conversions
+    // that throw above are rejected when parsed at compile time.
+    #define CHECK_REJECT(fmt,...) do {                                  \
+        static constexpr auto compiled = FORMAT_PRINTF (fmt);           \
+        static_assert (!compiled.accepts<__VA_ARGS__> ());              \
+        tap.noop ();                                                    \
+    } while (0)
+
+    {
+        static constexpr auto compiled = FORMAT_PRINTF ("%u: %-8s %.2f%%");
+        static_assert (compiled.arguments () == 3);
+        static_assert (compiled.accepts<unsigned, std::string, double> ());
+        static_assert (compiled.accepts<unsigned, char[4], double> ());
+        static_assert (!compiled.accepts<unsigned, std::string> ());
+        static_assert (!compiled.accepts<int, std::string, double> ());
+        static_assert (!compiled.accepts<unsigned, std::string, double, int> ());
+        tap.noop ();
+    }
+
+    CHECK_REJECT("%u");
+    CHECK_REJECT("%!");
+
+    CHECK_REJECT("%d", unsigned);
+    CHECK_REJECT("%i", std::nullptr_t);
+
+    CHECK_REJECT("%hhi", long long);
+    CHECK_REJECT("%lli", signed char);
+
+    CHECK_REJECT("%u", double);
+    CHECK_REJECT("%u", const char*);
+    CHECK_REJECT("%u", void*);
+    CHECK_REJECT("%u", int);
+
+    CHECK_REJECT("%hhu", unsigned long long);
+    CHECK_REJECT("%llu", unsigned char);
+
+    CHECK_REJECT("%f", unsigned);
+    CHECK_REJECT("%f", const char*);
+
+    CHECK_REJECT("%s", unsigned);
+    CHECK_REJECT("%s", char);
+    CHECK_REJECT("%s", std::nullptr_t);
+
+    CHECK_REJECT("%c", unsigned);
+    CHECK_REJECT("%c", const char*);
+
     return tap.status ();
 }
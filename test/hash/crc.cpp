@@ -43,6 +43,32 @@ main (int, char**)
         TEST(crc32c);
         TEST(crc32d);
         TEST(crc64);
+        #undef TEST
+    }
+
+
+    // split each test string at every offset and check the combined digest
+    // of the two halves matches the serial digest.
+    for (const auto &t: TESTS) {
+        const auto data = util::view {t.dat}.template cast<const uint8_t> ();
+
+        #define TEST(KLASS) do { \
+            bool success = true; \
+            util::hash::KLASS h; \
+            for (std::size_t i = 0; i <= data.size (); ++i) { \
+                const auto a = h ({ data.begin (), data.begin () + i }); \
+                const auto b = h ({ data.begin () + i, data.end () }); \
+                success = success && t.result.KLASS == util::hash::crc_combine<util::hash::KLASS> (a, b, data.size () - i); \
+            } \
+            tap.expect (success, "%s combine: %s", #KLASS, t.msg); \
+        } while (0)
+
+        TEST(crc32);
+        TEST(crc32b);
+        TEST(crc32c);
+        TEST(crc32d);
+        TEST(crc64);
+        #undef TEST
     }
 
     return tap.status ();
@@ -26,6 +26,31 @@ main (void)
     for (const auto &t: TESTS) {
         tap.expect_eq (h32 (util::view{t.data}.cast <const uint8_t> ()), t.h32, "fnv1a32: '%s'", t.data);
         tap.expect_eq (h64 (util::view{t.data}.cast <const uint8_t> ()), t.h64, "fnv1a64: '%s'", t.data);
+
+        tap.expect_eq (h32 (std::string_view {t.data}), t.h32, "fnv1a32 string_view: '%s'", t.data);
+        tap.expect_eq (h64 (std::string_view {t.data}), t.h64, "fnv1a64 string_view: '%s'", t.data);
+    }
+
+    {
+        using namespace util::hash::literals;
+
+        static_assert (""_fnv1a32 == 0x811c9dc5);
+        static_assert ("foobar"_fnv1a32 == 0xbf9cf968);
+        static_assert ("foobar"_fnv1a64 == 0x85944171f73967e8);
+        static_assert (util::hash::fnv1a64 {} ("a") == 0xaf63dc4c8601ec8c);
+
+        // literals must be usable as case labels
+        bool success = false;
+
+        switch (h32 (util::view {"foobar"}.cast<const uint8_t> ())) {
+        case "foo"_fnv1a32:
+            break;
+        case "foobar"_fnv1a32:
+            success = true;
+            break;
+        }
+
+        tap.expect (success, "fnv1a32 literal matches runtime");
     }
 
     return tap.status ();
@@ -131,7 +131,35 @@ test (util::TAP::logger &tap)
         tap.expect_eq (h3 (t.data), t.m3_32.hash, "murmur3_32, '%s'", t.msg);
         tap.expect_eq (h3_x86 (t.data), t.m3_128_x86.hash, "murmur3_128_x86, '%s'", t.msg);
         tap.expect_eq (h3_x64 (t.data), t.m3_128_x64.hash, "murmur3_128_x64, '%s'", t.msg);
+
+        const std::string_view str (
+            reinterpret_cast<const char*> (t.data.data ()),
+            t.data.size ()
+        );
+        tap.expect_eq (h3 (str), t.m3_32.hash, "murmur3_32 string_view, '%s'", t.msg);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+void
+test_constexpr (util::TAP::logger &tap)
+{
+    using namespace util::hash::literals;
+
+    static_assert (util::hash::murmur3_32 (0x80d3460d) ("abc") == 0x622f3384);
+    static_assert (util::hash::murmur3_32 (0x622f3384) ("message digest") == 0x6884feac);
+
+    // literals must be usable as case labels
+    bool success = false;
+
+    switch (util::hash::murmur3_32 (0) (util::view {"message digest"}.cast<const uint8_t> ())) {
+    case "message digest"_murmur3_32:
+        success = true;
+        break;
     }
+
+    tap.expect (success, "murmur3_32 literal matches runtime");
 }
 
 
@@ -143,6 +171,7 @@ main (void)
     util::TAP::logger tap;
 
     test (tap);
+    test_constexpr (tap);
 
     return tap.status ();
 }
@@ -0,0 +1,57 @@
+#include "tap.hpp"
+
+#include "hash/crc.hpp"
+#include "hash/tree.hpp"
+#include "hash/xxhash.hpp"
+#include "job/queue.hpp"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (int, char**)
+{
+    util::TAP::logger tap;
+    util::job::queue jobs (4);
+
+    // fill a buffer with a non-trivial pattern that isn't a multiple of any
+    // of the leaf sizes we test with.
+    std::vector<uint8_t> data (64 * 1024 + 37);
+    std::iota (data.begin (), data.end (), 0);
+    const util::view<const uint8_t*> all { data.data (), data.data () + data.size () };
+
+    // CRCs should be merged exactly regardless of the leaf size.
+    for (const std::size_t leaf: { 1u, 7u, 512u, 4096u, 1u << 20 }) {
+        #define TEST(KLASS) do { \
+            const auto serial = util::hash::KLASS {} (all); \
+            util::hash::tree<util::hash::KLASS> tree (jobs, leaf); \
+            tap.expect_eq (serial, tree (all), "%s tree, %zu byte leaves", #KLASS, leaf); \
+        } while (0)
+
+        TEST(crc32);
+        TEST(crc32b);
+        TEST(crc32c);
+        TEST(crc64);
+        #undef TEST
+    }
+
+
+    // Other hashes won't match the serial digest, but they must be stable
+    // across invocations and must fall back to the serial digest when the
+    // data fits in a single leaf.
+    {
+        util::hash::tree<util::hash::xxhash64> tree (jobs, 4096);
+
+        const auto a = tree (all);
+        const auto b = tree (all);
+        tap.expect_eq (a, b, "xxhash64 tree is deterministic");
+
+        const util::view<const uint8_t*> small { data.data (), data.data () + 4096 };
+        tap.expect_eq (tree (small), util::hash::xxhash64 {} (small), "xxhash64 tree single leaf");
+    }
+
+    return tap.status ();
+}
@@ -0,0 +1,231 @@
+#include "json/cbor.hpp"
+#include "json/except.hpp"
+#include "json/tree.hpp"
+#include "json/writer.hpp"
+#include "json2/event.hpp"
+#include "tap.hpp"
+
+#include <cstring>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+static std::unique_ptr<json::tree::node>
+parse (const char *str)
+{
+    return json::tree::parse (util::view<const char*> (str, str + strlen (str)));
+}
+
+
+//-----------------------------------------------------------------------------
+static util::view<const uint8_t*>
+view (const std::vector<uint8_t> &data)
+{
+    return { data.data (), data.data () + data.size () };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // encodings from the examples in appendix A of RFC 7049
+    {
+        static const struct {
+            const char *json;
+            std::vector<uint8_t> cbor;
+        } TESTS[] = {
+            { "0",      { 0x00 } },
+            { "23",     { 0x17 } },
+            { "24",     { 0x18, 0x18 } },
+            { "1000",   { 0x19, 0x03, 0xe8 } },
+            { "-1",     { 0x20 } },
+            { "-1000",  { 0x39, 0x03, 0xe7 } },
+            { "1.5",    { 0xfa, 0x3f, 0xc0, 0x00, 0x00 } },
+            { "1.1",    { 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a } },
+            { "true",   { 0xf5 } },
+            { "null",   { 0xf6 } },
+            { "\"IETF\"", { 0x64, 0x49, 0x45, 0x54, 0x46 } },
+            { "[1,[2,3]]", { 0x82, 0x01, 0x82, 0x02, 0x03 } },
+            { "{\"a\":1,\"b\":[2,3]}", { 0xa2, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03 } },
+        };
+
+        for (const auto &t: TESTS) {
+            auto tree = parse (t.json);
+            tap.expect (json::cbor::encode (*tree) == t.cbor, "encode %s", t.json);
+
+            json::cbor::reader src (view (t.cbor));
+            json::writer text;
+            json::cbor::transcode (src, text);
+            tap.expect (text.str () == t.json && src.done (), "transcode %s", t.json);
+        }
+    }
+
+    // a document survives a round trip through the tree interface
+    {
+        auto tree = parse (R"_({
+            "name": "cruft",
+            "tags": [ "a", "b", "c" ],
+            "nested": { "x": -12345678901, "y": 18446744073709551615, "z": 0.1 },
+            "empty": {},
+            "flags": [ true, false, null ]
+        })_");
+
+        auto encoded = json::cbor::encode (*tree);
+        auto decoded = json::cbor::decode (view (encoded));
+        tap.expect (*decoded == *tree, "tree round trip");
+    }
+
+    // escaped strings are decoded before encoding, and re-escaped for the tree
+    {
+        auto tree = parse (R"_([ "tab\thereA" ])_");
+        auto encoded = json::cbor::encode (*tree);
+
+        json::cbor::reader src (view (encoded));
+        auto arr = src.next ();
+        auto str = src.next ();
+        tap.expect (
+            arr.type == json::cbor::kind::ARRAY && arr.length == 1 &&
+            str.type == json::cbor::kind::STRING && str.text () == "tab\thereA",
+            "strings are unescaped"
+        );
+
+        // the string must be a view into the encoded buffer
+        tap.expect (
+            str.data.begin () >= encoded.data () &&
+            str.data.end () <= encoded.data () + encoded.size (),
+            "strings are zero-copy"
+        );
+
+        auto decoded = json::cbor::decode (view (encoded));
+        tap.expect_eq (json::to_string (*decoded), R"_(["tab\thereA"])_", "strings are re-escaped");
+    }
+
+    // the encoder is a json2 event sink, using indefinite length containers
+    {
+        static const char TEXT[] = R"_({"a":[1,-2,3.5,"x\n"],"b":{"c":true,"d":null}})_";
+
+        json::cbor::encoder enc;
+        util::json2::event::parse (enc, std::begin (TEXT), std::end (TEXT) - 1);
+
+        tap.expect (!enc.data ().empty () && enc.data ()[0] == 0xbf, "events produce indefinite objects");
+
+        auto decoded = json::cbor::decode (view (enc.data ()));
+        tap.expect (*decoded == *parse (TEXT), "events round trip");
+
+        json::cbor::reader src (view (enc.data ()));
+        auto root = src.next ();
+        src.skip (root);
+        tap.expect (src.done (), "skip consumes indefinite containers");
+    }
+
+    // byte strings are read as views but have no tree equivalent
+    {
+        const std::vector<uint8_t> blob { 0x01, 0x02, 0xff };
+
+        json::cbor::encoder enc;
+        enc.begin_array (1).bytes (view (blob));
+
+        json::cbor::reader src (view (enc.data ()));
+        src.next ();
+        auto bytes = src.next ();
+        tap.expect (
+            bytes.type == json::cbor::kind::BYTES &&
+            std::equal (bytes.data.begin (), bytes.data.end (), blob.begin (), blob.end ()),
+            "byte strings"
+        );
+
+        tap.expect_throw<json::type_error> (
+            [&] { json::cbor::decode (view (enc.data ())); },
+            "byte strings rejected by tree"
+        );
+    }
+
+    // reading foreign encodings: tags, half precision, and truncation
+    {
+        const std::vector<uint8_t> tagged { 0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0 };
+        json::cbor::reader tag_src (view (tagged));
+        tap.expect_eq (tag_src.next ().uint, 1363896240u, "tags are skipped");
+
+        const std::vector<uint8_t> half { 0xf9, 0x3e, 0x00 };
+        json::cbor::reader half_src (view (half));
+        tap.expect_eq (half_src.next ().real, 1.5, "half precision");
+
+        const std::vector<uint8_t> truncated { 0x64, 0x49, 0x45 };
+        tap.expect_throw<json::error> (
+            [&] { json::cbor::decode (view (truncated)); },
+            "truncated input"
+        );
+    }
+
+    // nesting is bounded, as for the incremental text parser, so hostile
+    // input can't exhaust the stack.
+    {
+        const auto nested = [] (size_t depth) {
+            std::vector<uint8_t> res (depth, 0x81);
+            res.push_back (0x80);
+            return res;
+        };
+
+        const auto deepest = nested (json::cbor::MAX_DEPTH - 1);
+        tap.expect (json::cbor::decode (view (deepest)) != nullptr, "decode at the depth limit");
+
+        const auto deep = nested (json::cbor::MAX_DEPTH);
+        tap.expect_throw<json::parse_error> (
+            [&] { json::cbor::decode (view (deep)); },
+            "decode beyond the depth limit"
+        );
+
+        tap.expect_throw<json::parse_error> (
+            [&] {
+                json::cbor::reader src (view (deep));
+                json::writer text;
+                json::cbor::transcode (src, text);
+            },
+            "transcode beyond the depth limit"
+        );
+    }
+
+    // skipping doesn't recurse, so deep nesting is limited only by the size
+    // of the buffer; malformed containers are still rejected.
+    {
+        const size_t depth = 1'000'000;
+        std::vector<uint8_t> deep (depth, 0x9f);
+        deep.resize (depth * 2, 0xff);
+
+        json::cbor::reader src (view (deep));
+        src.skip (src.next ());
+        tap.expect (src.done (), "skip deeply nested indefinite containers");
+
+        const std::vector<uint8_t> unterminated (depth, 0x9f);
+        tap.expect_throw<json::error> (
+            [&] {
+                json::cbor::reader unterminated_src (view (unterminated));
+                unterminated_src.skip (unterminated_src.next ());
+            },
+            "skip rejects unterminated nesting"
+        );
+
+        const std::vector<uint8_t> early_break { 0x82, 0x01, 0xff };
+        tap.expect_throw<json::error> (
+            [&] {
+                json::cbor::reader break_src (view (early_break));
+                break_src.skip (break_src.next ());
+            },
+            "skip rejects a break within a definite container"
+        );
+
+        const std::vector<uint8_t> huge { 0xbb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 };
+        tap.expect_throw<json::error> (
+            [&] {
+                json::cbor::reader huge_src (view (huge));
+                huge_src.skip (huge_src.next ());
+            },
+            "skip rejects oversized container lengths"
+        );
+    }
+
+    return tap.status ();
+}
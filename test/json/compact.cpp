@@ -0,0 +1,124 @@
+#include "tap.hpp"
+
+#include "json/compact.hpp"
+#include "json/except.hpp"
+
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    static const std::string TEST_STRING = R"_(
+        {
+           "string":"brad",
+           "escaped":"a\"b\\c\u00e9\ud83d\ude00",
+           "integer":-12,
+           "null":null,
+           "false":false,
+           "true":true,
+           "double":3.25,
+           "object":{
+               "test": "test"
+           },
+           "array":[
+               1, 2, 3, 4
+           ]
+        })_";
+
+    const util::view<const char*> src { TEST_STRING.data (), TEST_STRING.data () + TEST_STRING.size () };
+    const json::compact::document doc (src);
+    const auto &root = doc.root ();
+
+    tap.expect (root.is_object (), "root is_object");
+    tap.expect_eq (root.size (), 9u, "root member count");
+    tap.expect_eq (doc.bytes (), json::compact::required (src), "arena is exactly sized");
+
+    // a caller sizing its own arena can reuse the scan that measured it
+    {
+        const json::compact::layout layout (src);
+        tap.expect_eq (layout.bytes (), json::compact::required (src), "layout matches required");
+
+        std::vector<std::max_align_t> memory (layout.bytes () / sizeof (std::max_align_t) + 1);
+        util::alloc::raw::linear store (memory.data (), memory.data () + memory.size ());
+
+        const auto &v = json::compact::parse (layout, store);
+        tap.expect (v["array"].size () == 4 && v["object"]["test"].as_string () == "test", "parse from layout");
+    }
+
+    tap.expect_eq (root["string"].as_string (), "brad", "string value");
+    tap.expect (!root["string"].escaped (), "plain string is not escaped");
+    tap.expect_eq (root["string"].raw ().data (), TEST_STRING.data () + TEST_STRING.find ("brad"), "string refers into source");
+
+    tap.expect (root["escaped"].escaped (), "escaped string is flagged");
+    tap.expect_eq (root["escaped"].as_string (), "a\"b\\c\xc3\xa9\xf0\x9f\x98\x80", "escaped string value");
+
+    tap.expect_eq (root["integer"].as_integer (), -12, "integer value");
+    tap.expect_eq (root["double"].as_real (), 3.25, "real value");
+    tap.expect_eq (root["integer"].as_real (), -12.0, "integer as real");
+    tap.expect (root["null"].is_null (), "null value");
+    tap.expect (!root["false"].as_boolean (), "false value");
+    tap.expect ( root["true"].as_boolean (), "true value");
+
+    // integers written with an exponent are read in full, as reals
+    {
+        const std::string exp = "[1e5, -2E3]";
+        const json::compact::document doc (util::view<const char*> { exp.data (), exp.data () + exp.size () });
+
+        tap.expect_eq (doc.root ()[0].as_real (), 1e5, "exponent integer value");
+        tap.expect_eq (doc.root ()[1].as_real (), -2e3, "negative exponent integer value");
+    }
+
+    tap.expect_eq (root["object"]["test"].as_string (), "test", "nested object value");
+    tap.expect_eq (root["array"].size (), 4u, "array size");
+    tap.expect_eq (root["array"][3].as_integer (), 4, "array element");
+
+    {
+        intmax_t sum = 0;
+        for (const auto &v: root["array"].elements ())
+            sum += v.as_integer ();
+        tap.expect_eq (sum, 10, "array iteration");
+    }
+
+    {
+        // members should be visited in document order
+        std::string keys;
+        for (const auto &m: root.members ())
+            keys += m.key.as_string ().substr (0, 1);
+        tap.expect_eq (keys, "seinftdoa", "member order");
+    }
+
+    tap.expect (!root.has ("missing"), "missing key");
+    tap.expect_throw<json::key_error> ([&] { root["missing"]; }, "missing key throws");
+    tap.expect_throw<json::type_error> ([&] { root["string"].as_integer (); }, "type mismatch throws");
+
+    // the arena can be reused across documents by resetting it
+    {
+        alignas (std::max_align_t) char memory[1024];
+        util::alloc::raw::linear store (std::begin (memory), std::end (memory));
+
+        bool success = true;
+        for (int i = 0; i < 100; ++i) {
+            const std::string msg = "[" + std::to_string (i) + ", {\"k\": true}]";
+            const auto &v = json::compact::parse ({ msg.data (), msg.data () + msg.size () }, store);
+            success = success && v[0].as_integer () == i && v[1]["k"].as_boolean ();
+            store.reset ();
+        }
+
+        tap.expect (success, "arena reuse across documents");
+
+        tap.expect_throw<std::bad_alloc> (
+            [&] {
+                const std::string big (R"([0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0])");
+                json::compact::parse ({ big.data (), big.data () + big.size () }, store);
+            },
+            "exhausted arena throws"
+        );
+    }
+
+    return tap.status ();
+}
@@ -0,0 +1,134 @@
+#include "json/ndjson.hpp"
+#include "json/tree.hpp"
+#include "job/queue.hpp"
+#include "tap.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+    util::job::queue queue;
+
+    // a few hundred small documents with blank lines scattered throughout.
+    // line `i` (counting from 1) holds the value `i`, where present.
+    std::string data;
+    std::vector<size_t> expected;
+
+    for (size_t i = 1; i <= 500; ++i) {
+        if (i % 7 == 0) {
+            data += i % 2 ? "\n" : "  \r\n";
+            continue;
+        }
+
+        data += "{ \"line\": " + std::to_string (i) + ", \"tags\": [\"a\", \"b\"] }\n";
+        expected.push_back (i);
+    }
+
+    const util::view<const char*> view { data.data (), data.data () + data.size () };
+
+    // chunks must tile the input and each must end on a line boundary
+    {
+        const auto chunks = json::ndjson::split (view, 100);
+
+        bool success = !chunks.empty ()
+            && chunks.front ().data.begin () == view.begin ()
+            && chunks.back ().data.end () == view.end ();
+
+        size_t line = 1;
+        for (size_t i = 0; i < chunks.size (); ++i) {
+            const auto &c = chunks[i];
+
+            success = success
+                && c.line == line
+                && c.data.end ()[-1] == '\n'
+                && (i == 0 || chunks[i - 1].data.end () == c.data.begin ());
+
+            line += std::count (c.data.begin (), c.data.end (), '\n');
+        }
+
+        tap.expect (success, "split produces contiguous chunks on line boundaries");
+    }
+
+    // every line must be delivered, in line order when requested
+    {
+        std::vector<size_t> lines;
+        bool success = true;
+
+        json::ndjson::parse (queue, view, json::ndjson::order::SEQUENTIAL,
+            [&] (size_t line, json::ndjson::parsed &&res) {
+                success = success && res.value && res.error.empty ()
+                    && res.value->as_object ()["line"].as_uint () == line;
+                lines.push_back (line);
+            },
+            128
+        );
+
+        tap.expect (success, "sequential values match their lines");
+        tap.expect (lines == expected, "sequential delivery is in line order");
+    }
+
+    {
+        std::vector<size_t> lines;
+
+        json::ndjson::parse (queue, view, json::ndjson::order::UNORDERED,
+            [&] (size_t line, json::ndjson::parsed&&) { lines.push_back (line); },
+            128
+        );
+
+        std::sort (lines.begin (), lines.end ());
+        tap.expect (lines == expected, "unordered delivery covers every line");
+    }
+
+    // malformed lines are reported by line number without halting the parse
+    {
+        const std::string bad = "[1]\n{\"a\":}\n\ntrue\n[1,\n\"x\"\n";
+        const util::view<const char*> bad_view { bad.data (), bad.data () + bad.size () };
+
+        const auto failures = json::ndjson::validate (queue, bad_view, 4);
+        tap.expect (
+            failures.size () == 2 && failures[0].line == 2 && failures[1].line == 5,
+            "validate reports malformed lines"
+        );
+
+        size_t values = 0, errors = 0;
+        json::ndjson::parse (queue, bad_view, json::ndjson::order::SEQUENTIAL,
+            [&] (size_t, json::ndjson::parsed &&res) {
+                ++(res.value ? values : errors);
+            },
+            4
+        );
+        tap.expect (values == 3 && errors == 2, "parse reports malformed lines");
+
+        tap.expect (json::ndjson::validate (queue, view, 64).empty (), "validate accepts good input");
+    }
+
+    // exceptions from the callbacks must propagate to the caller
+    tap.expect_throw<std::runtime_error> ([&] {
+        json::ndjson::map<int> (queue, view, json::ndjson::order::SEQUENTIAL,
+            [] (size_t line, util::view<const char*>) -> int {
+                if (line == 100)
+                    throw std::runtime_error ("work");
+                return 0;
+            },
+            [] (size_t, int&&) { ; },
+            64
+        );
+    }, "exceptions from work propagate");
+
+    tap.expect_throw<std::runtime_error> ([&] {
+        json::ndjson::map<int> (queue, view, json::ndjson::order::UNORDERED,
+            [] (size_t, util::view<const char*>) { return 0; },
+            [] (size_t, int&&) { throw std::runtime_error ("deliver"); },
+            64
+        );
+    }, "exceptions from deliver propagate");
+
+    return tap.status ();
+}
@@ -0,0 +1,112 @@
+#include "json/pointer.hpp"
+#include "json/compact.hpp"
+#include "json/except.hpp"
+#include "json/tree.hpp"
+#include "json2/cursor.hpp"
+#include "tap.hpp"
+
+#include <cstring>
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // the example document from section 5 of RFC 6901, with an additional
+    // nested member.
+    static const char DOC[] = R"_({
+        "foo": ["bar", "baz"],
+        "": 0,
+        "a/b": 1,
+        "c%d": 2,
+        "e^f": 3,
+        "g|h": 4,
+        "i\\j": 5,
+        "k\"l": 6,
+        " ": 7,
+        "m~n": 8,
+        "deep": { "list": [ { "x": 9 }, { "x": 10 } ] }
+    })_";
+
+    const util::view<const char*> src { DOC, DOC + strlen (DOC) };
+
+    const auto tree = json::tree::parse (src);
+    const json::compact::document compact (src);
+    const util::json2::cursor cursor (src);
+
+    static const struct {
+        const char *path;
+        const char *expected;
+    } TESTS[] = {
+        { "/foo/0",  "\"bar\"" },
+        { "/",       "0" },
+        { "/a~1b",   "1" },
+        { "/c%d",    "2" },
+        { "/e^f",    "3" },
+        { "/g|h",    "4" },
+        { "/i\\j",   "5" },
+        { "/k\"l",   "6" },
+        { "/ ",      "7" },
+        { "/m~0n",   "8" },
+        { "/deep/list/1/x", "10" },
+    };
+
+    for (const auto &t: TESTS) {
+        const json::pointer ptr (t.path);
+
+        auto a = ptr.find (*tree);
+        auto b = ptr.find (compact.root ());
+        auto c = ptr.find (cursor);
+
+        std::string expected (t.expected);
+        const bool string = expected[0] == '"';
+
+        tap.expect (a && (string ? a->is_string () : a->as_uint () == std::stoul (expected)), "tree %s", t.path);
+        tap.expect (b && (string ? b->is_string () : uintmax_t (b->as_integer ()) == std::stoul (expected)), "compact %s", t.path);
+        tap.expect (c && c->raw () == expected, "cursor %s", t.path);
+    }
+
+    // the empty pointer refers to the whole document
+    {
+        const json::pointer root ("");
+        tap.expect (root.size () == 0 && root.find (*tree) == tree.get (), "empty pointer");
+    }
+
+    // misses are reported without throwing
+    static const char *MISSING[] = {
+        "/missing",
+        "/foo/2",
+        "/foo/-",
+        "/foo/01",
+        "/foo/bar",
+        "/foo/0/x",
+        "/deep/list/0/x/y",
+    };
+
+    for (auto m: MISSING) {
+        const json::pointer ptr (m);
+        tap.expect (
+            !ptr.find (*tree) && !ptr.find (compact.root ()) && !ptr.find (cursor),
+            "missing %s", m
+        );
+    }
+
+    // a plan is reusable across documents, and may be used for modification
+    {
+        const json::pointer ptr ("/deep/list/0/x");
+
+        auto copy = tree->clone ();
+        auto found = ptr.find (*copy);
+        tap.expect (found && found->as_uint () == 9, "reused on a copy");
+        tap.expect (found && found != ptr.find (*tree), "resolves within each document");
+    }
+
+    // malformed pointers are rejected when compiled
+    static const char *BAD[] = { "foo", "/~", "/~2", "/a~" };
+    for (auto b: BAD)
+        tap.expect_throw<json::error> ([&] { json::pointer p (b); }, "malformed %s", b);
+
+    return tap.status ();
+}
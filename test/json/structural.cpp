@@ -0,0 +1,302 @@
+#include "tap.hpp"
+
+#include "json/except.hpp"
+#include "json/flat.hpp"
+#include "json/structural.hpp"
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// a byte-at-a-time version of the stage one index, used as the reference for
+// the vectorised implementations.
+static std::vector<uint32_t>
+reference_index (const std::string &src)
+{
+    std::vector<uint32_t> res;
+
+    bool inside  = false;
+    bool escaped = false;
+    bool pred    = true;
+
+    for (size_t i = 0; i < src.size (); ++i) {
+        const char c = src[i];
+        const bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+
+        // backslashes escape the following quote even outside of strings;
+        // it's malformed regardless, and stage two will reject it.
+        const bool quote = c == '"' && !escaped;
+        escaped = !escaped && c == '\\';
+
+        if (inside) {
+            if (quote)
+                inside = false;
+
+            pred = !inside || space;
+            continue;
+        }
+
+        switch (c) {
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            res.push_back (uint32_t (i));
+            pred = true;
+            continue;
+        }
+
+        if (quote) {
+            res.push_back (uint32_t (i));
+            inside = true;
+            pred = false;
+            continue;
+        }
+
+        if (!space && pred)
+            res.push_back (uint32_t (i));
+        pred = space;
+    }
+
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+static std::vector<json::flat::type>
+tags (const std::string &src)
+{
+    std::vector<json::flat::type> res;
+    for (const auto &i: json::structural::parse (util::view<const char*> { src.data (), src.data () + src.size () }))
+        res.push_back (i.tag);
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+// the outcome of parsing a document: whether it was accepted, and if so the
+// tag and byte offsets of each of its items.
+struct outcome {
+    bool accepted;
+    std::vector<std::tuple<json::flat::type, size_t, size_t>> items;
+
+    bool operator== (const outcome &rhs) const
+    { return accepted == rhs.accepted && items == rhs.items; }
+};
+
+
+//-----------------------------------------------------------------------------
+template <typename IteratorT>
+static outcome
+run (std::vector<json::flat::item<IteratorT>> (*parser) (util::view<IteratorT>),
+     IteratorT first,
+     IteratorT last)
+{
+    try {
+        outcome res { true, {} };
+        for (const auto &i: parser (util::view<IteratorT> { first, last }))
+            res.items.emplace_back (i.tag, size_t (i.first - first), size_t (i.last - first));
+        return res;
+    } catch (const json::parse_error&) {
+        return { false, {} };
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    using T = json::flat::type;
+
+    // check the item stream for some simple documents
+    {
+        static const struct {
+            const char *data;
+            std::vector<T> tags;
+            const char *message;
+        } TESTS[] = {
+            { "null",        { T::NUL }, "null" },
+            { " true ",      { T::BOOLEAN }, "padded true" },
+            { "-0.5e+3",     { T::REAL }, "real" },
+            { "1e3",         { T::INTEGER }, "exponent without fraction" },
+            { "[]",          { T::ARRAY_BEGIN, T::ARRAY_END }, "empty array" },
+            { "{ }",         { T::OBJECT_BEGIN, T::OBJECT_END }, "empty object" },
+            {
+                R"({"a":[1,"b\"",false],"c":{}})",
+                {
+                    T::OBJECT_BEGIN,
+                    T::STRING, T::ARRAY_BEGIN, T::INTEGER, T::STRING, T::BOOLEAN, T::ARRAY_END,
+                    T::STRING, T::OBJECT_BEGIN, T::OBJECT_END,
+                    T::OBJECT_END
+                },
+                "nested containers"
+            },
+        };
+
+        for (const auto &t: TESTS)
+            tap.expect_eq (tags (t.data), t.tags, "tags, %s", t.message);
+    }
+
+    // strings should include their quotes, and scalars exclude any trailing
+    // whitespace.
+    {
+        const std::string src = R"([ "a b" , 12 ])";
+        const auto items = json::structural::parse (util::view<const char*> { src.data (), src.data () + src.size () });
+
+        tap.expect_eq (std::string (items[1].first, items[1].last), "\"a b\"", "string extent");
+        tap.expect_eq (std::string (items[2].first, items[2].last), "12", "integer extent");
+    }
+
+    // malformed documents must be rejected
+    {
+        static const char* BAD[] = {
+            "",
+            "   ",
+            "True",
+            "01",
+            "1.",
+            "-",
+            "[1,]",
+            "[1 2]",
+            "{\"a\" 1}",
+            "{1:2}",
+            "{\"a\":}",
+            "[1}",
+            "[[]",
+            "1 2",
+            "\"abc",
+            "\"\\x\"",
+            "\"\\u12g4\"",
+            "\"\xc0\x80\"",
+            "\"a\"b",
+            "nulls",
+        };
+
+        for (const auto &b: BAD) {
+            const std::string src = b;
+            tap.expect_throw<json::parse_error> (
+                [&] { tags (src); },
+                "rejects '%s'", src
+            );
+        }
+    }
+
+    // the structural parser must agree with the flat parser's state machine,
+    // both in what it accepts and the items it produces. flat::parse sends
+    // char pointers to the structural parser, so the machine is exercised
+    // through string iterators instead. the expected outcomes follow the
+    // flat grammar (RFC 3629 for UTF-8) so a disagreement points at the
+    // culprit.
+    {
+        static const struct {
+            const char *data;
+            bool accepted;
+            const char *message;
+        } TESTS[] = {
+            { "\"\xc2\x80\"",             true,  "utf8, lowest two byte" },
+            { "\"\xdf\xbf\"",             true,  "utf8, highest two byte" },
+            { "\"\xe0\xa0\x80\"",         true,  "utf8, lowest three byte" },
+            { "\"\xed\x9f\xbf\"",         true,  "utf8, below surrogates" },
+            { "\"\xef\xbf\xbf\"",         true,  "utf8, U+FFFF" },
+            { "\"\xef\xbf\xbe\"",         true,  "utf8, U+FFFE" },
+            { "\"\xf0\x90\x80\x80\"",     true,  "utf8, lowest four byte" },
+            { "\"\xf4\x8f\xbf\xbf\"",     true,  "utf8, U+10FFFF" },
+            { "\"a\xc3\xa9" "b\"",         true,  "utf8, mixed with ascii" },
+
+            { "\"\x80\"",                 false, "utf8, lone continuation" },
+            { "\"\xc0\x80\"",             false, "utf8, overlong C0" },
+            { "\"\xc1\xbf\"",             false, "utf8, overlong C1" },
+            { "\"\xe0\x80\x80\"",         false, "utf8, overlong three byte" },
+            { "\"\xed\xa0\x80\"",         false, "utf8, surrogate" },
+            { "\"\xf0\x80\x80\x80\"",     false, "utf8, overlong four byte" },
+            { "\"\xf4\x90\x80\x80\"",     false, "utf8, beyond U+10FFFF" },
+            { "\"\xf5\x80\x80\x80\"",     false, "utf8, lead F5" },
+            { "\"\xff\"",                 false, "utf8, lead FF" },
+            { "\"\xe1\x80\"",             false, "utf8, truncated three byte" },
+            { "\"\xe1\x80x\"",            false, "utf8, bad continuation" },
+
+            { "1e5",                       true,  "exponent only" },
+            { "-1E+5",                     true,  "signed exponent only" },
+            { "1.5e5",                     true,  "fraction and exponent" },
+            { "0.5",                       true,  "fraction only" },
+            { "1e",                        false, "empty exponent" },
+        };
+
+        for (const auto &t: TESTS) {
+            const std::string src = t.data;
+
+            const auto flat = run (
+                json::flat::parse<std::string::const_iterator>,
+                src.cbegin (), src.cend ()
+            );
+            const auto structural = run (
+                json::structural::parse<const char*>,
+                src.data (), src.data () + src.size ()
+            );
+
+            tap.expect_eq (flat.accepted, t.accepted, "flat, %s", t.message);
+            tap.expect (structural == flat, "structural matches flat, %s", t.message);
+        }
+    }
+
+    // buffers beyond the reach of 32 bit offsets fall back to the state
+    // machine rather than failing to index.
+    tap.expect (
+        json::structural::indexable (json::structural::MAX_SIZE) &&
+        !json::structural::indexable (json::structural::MAX_SIZE + 1),
+        "flat::parse dispatch limit"
+    );
+
+    // the vectorised index must agree with the reference, particularly for
+    // strings and backslash runs that straddle the 64 byte blocks.
+    {
+        std::mt19937 gen (0x5eed);
+        static const char ALPHABET[] = "{}[]:, \t\n\"\\\\\\\"\"ab01";
+
+        bool success = true;
+
+        for (int i = 0; i < 2000; ++i) {
+            std::string src (std::uniform_int_distribution<size_t> (0, 300) (gen), '\0');
+            for (auto &c: src)
+                c = ALPHABET[std::uniform_int_distribution<size_t> (0, sizeof (ALPHABET) - 2) (gen)];
+
+            const auto expected = reference_index (src);
+
+            try {
+                const auto found = json::structural::index ({ src.data (), src.data () + src.size () });
+                success = success && found == expected;
+            } catch (const json::parse_error&) {
+                // only unterminated strings may throw; the reference
+                // doesn't report them so just require that we're inside one.
+                bool inside = false, escaped = false;
+                for (auto c: src) {
+                    if (c == '"' && !escaped)
+                        inside = !inside;
+                    escaped = !escaped && c == '\\';
+                }
+                success = success && inside;
+            }
+        }
+
+        tap.expect (success, "index matches reference for random input");
+    }
+
+    // a large document exercises many blocks of the parser proper
+    {
+        std::string src = "[";
+        for (int i = 0; i < 1000; ++i) {
+            if (i)
+                src += ",\n";
+            src += R"({"key \"quoted\" \\":)" + std::to_string (i) + R"(, "x": [true, null, 1.5]})";
+        }
+        src += "]";
+
+        const auto items = json::structural::parse (util::view<const char*> { src.data (), src.data () + src.size () });
+        tap.expect_eq (items.size (), 2u + 1000u * 10u, "item count for large document");
+    }
+
+    return tap.status ();
+}
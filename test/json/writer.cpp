@@ -0,0 +1,158 @@
+#include "json/writer.hpp"
+#include "json/except.hpp"
+#include "json/tree.hpp"
+#include "tap.hpp"
+
+#include <cstring>
+#include <limits>
+
+
+///////////////////////////////////////////////////////////////////////////////
+static std::unique_ptr<json::tree::node>
+parse (const char *str)
+{
+    return json::tree::parse (util::view<const char*> (str, str + strlen (str)));
+}
+
+
+//-----------------------------------------------------------------------------
+static std::unique_ptr<json::tree::node>
+parse (const std::string &str)
+{
+    return parse (str.c_str ());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // documents written compactly must match exactly, and must read back to
+    // an equal tree in either style
+    {
+        static const struct {
+            const char *data;
+            const char *compact;
+        } TESTS[] = {
+            { "null", "null" },
+            { "[]", "[]" },
+            { "{}", "{}" },
+            { "[ 1, -2, 3.5, true, false, null ]", "[1,-2,3.5,true,false,null]" },
+            { R"_({ "a": { "b": [ {}, [] ] } })_", R"_({"a":{"b":[{},[]]}})_" },
+            { R"_([ "tab\there", "quote\"slash\\" ])_", R"_(["tab\there","quote\"slash\\"])_" },
+        };
+
+        for (const auto &t: TESTS) {
+            auto tree = parse (t.data);
+
+            auto compact = json::to_string (*tree);
+            tap.expect_eq (compact, t.compact, "compact %s", t.compact);
+
+            auto pretty = json::to_string (*tree, json::style::PRETTY);
+            tap.expect (*parse (pretty) == *tree, "pretty round-trip %s", t.compact);
+        }
+    }
+
+    // every control character must be escaped, and the long run must cross
+    // the vectorised scan boundaries.
+    {
+        std::string raw (40, 'x');
+        for (char c = 0; c < 0x20; ++c)
+            raw.push_back (c);
+        raw += "\"\\/";
+        raw += std::string (40, 'y');
+
+        json::writer w;
+        w.value (raw);
+
+        auto text = w.str ();
+        bool clean = true;
+        for (auto c: text)
+            clean = clean && static_cast<unsigned char> (c) >= 0x20;
+
+        tap.expect (clean, "control characters escaped");
+        tap.expect (text.find ("\\u001f") != std::string::npos, "unicode escape");
+        tap.expect (
+            text.find (R"_(\b\t\n\u000b\f\r)_") != std::string::npos &&
+            text.find (R"_(\"\\/)_") != std::string::npos,
+            "short escapes"
+        );
+
+        // the free function produces the same escapes, without the quotes
+        std::string body;
+        json::escape (raw, body);
+        tap.expect_eq ('"' + body + '"', text, "escape matches writer");
+    }
+
+    // reals are written in shortest form and read back exactly
+    {
+        static const struct {
+            double value;
+            const char *expected;
+        } TESTS[] = {
+            { 0.1, "0.1" },
+            { 1.0, "1.0" },
+            { -2.5, "-2.5" },
+            { 1e300, "1e+300" },
+            { 5e-324, "5e-324" },
+            { std::numeric_limits<double>::infinity (), "null" },
+        };
+
+        for (const auto &t: TESTS) {
+            json::writer w;
+            w.value (t.value);
+            tap.expect_eq (w.str (), t.expected, "real %s", t.expected);
+        }
+
+        json::writer w;
+        w.value (1.0 / 3.0);
+        tap.expect_eq (parse (w.str ())->as_number ().real (), 1.0 / 3.0, "real round-trip");
+    }
+
+    // integer extremes
+    {
+        json::writer w;
+        w.begin_array ()
+            .value (std::numeric_limits<intmax_t>::min ())
+            .value (std::numeric_limits<uintmax_t>::max ())
+            .value (0)
+            .value (9)
+            .value (10)
+         .end_array ();
+
+        tap.expect_eq (
+            w.str (),
+            "[-9223372036854775808,18446744073709551615,0,9,10]",
+            "integer extremes"
+        );
+    }
+
+    // the event interface in pretty mode
+    {
+        json::writer w (json::style::PRETTY, 2);
+        w.begin_object ()
+            .key ("a").value (1)
+            .key ("b").begin_array ().value ("c").end_array ()
+            .key ("d").begin_object ().end_object ()
+        .end_object ();
+
+        tap.expect_eq (
+            w.str (),
+            "{\n  \"a\": 1,\n  \"b\": [\n    \"c\"\n  ],\n  \"d\": {}\n}",
+            "pretty events"
+        );
+    }
+
+    // misuse of the event interface is reported
+    {
+        json::writer w;
+        tap.expect_throw<json::error> ([&] { w.key ("a"); }, "key outside object");
+
+        w.clear ();
+        tap.expect_throw<json::error> ([&] { w.begin_array ().end_object (); }, "mismatched close");
+    }
+
+    return tap.status ();
+}
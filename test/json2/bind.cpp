@@ -0,0 +1,162 @@
+#include "json2/bind.hpp"
+#include "json2/except.hpp"
+#include "introspection.hpp"
+#include "tap.hpp"
+
+#include <cstring>
+
+
+///////////////////////////////////////////////////////////////////////////////
+INTROSPECTION_ENUM_CLASS (colour, RED, GREEN, BLUE)
+
+
+//-----------------------------------------------------------------------------
+struct point {
+    int x = 0;
+    int y = 0;
+};
+
+
+struct shape {
+    std::string name;
+    colour fill = colour::RED;
+    std::vector<point> vertices;
+    std::array<float,2> scale { 1, 1 };
+    std::optional<uint8_t> layer;
+    double weight = 0;
+    bool visible = false;
+};
+
+
+//-----------------------------------------------------------------------------
+namespace util {
+    template <>
+    struct type<point> {
+        typedef std::tuple<
+            field<point,int,&point::x>,
+            field<point,int,&point::y>
+        > fields;
+    };
+
+    template <> const std::string field<point,int,&point::x>::name = "x";
+    template <> const std::string field<point,int,&point::y>::name = "y";
+
+
+    template <>
+    struct type<shape> {
+        typedef std::tuple<
+            field<shape,std::string,&shape::name>,
+            field<shape,colour,&shape::fill>,
+            field<shape,std::vector<point>,&shape::vertices>,
+            field<shape,std::array<float,2>,&shape::scale>,
+            field<shape,std::optional<uint8_t>,&shape::layer>,
+            field<shape,double,&shape::weight>,
+            field<shape,bool,&shape::visible>
+        > fields;
+    };
+
+    template <> const std::string field<shape,std::string,&shape::name>::name = "name";
+    template <> const std::string field<shape,colour,&shape::fill>::name = "fill";
+    template <> const std::string field<shape,std::vector<point>,&shape::vertices>::name = "vertices";
+    template <> const std::string field<shape,std::array<float,2>,&shape::scale>::name = "scale";
+    template <> const std::string field<shape,std::optional<uint8_t>,&shape::layer>::name = "layer";
+    template <> const std::string field<shape,double,&shape::weight>::name = "weight";
+    template <> const std::string field<shape,bool,&shape::visible>::name = "visible";
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+static T
+decode (const char *str)
+{
+    return util::json2::decode<T> (str, str + strlen (str));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // decode a nested structure, with an unknown key and an escaped key
+    {
+        const auto s = decode<shape> (R"_({
+            "name": "tri\nangle",
+            "unknown": { "ignored": [ 1, 2, 3 ] },
+            "fill": "BLUE",
+            "vertices": [ { "x": 0, "y": 0 }, { "x": 4, "y": 0 }, { "y": 3, "x": 0 } ],
+            "scale": [ 2, 0.5 ],
+            "layer": 7,
+            "weight": 1.25,
+            "visible": true
+        })_");
+
+        tap.expect_eq (s.name, "tri\nangle", "string field");
+        tap.expect (s.fill == colour::BLUE, "enum field");
+        tap.expect (
+            s.vertices.size () == 3 &&
+            s.vertices[1].x == 4 && s.vertices[1].y == 0 &&
+            s.vertices[2].x == 0 && s.vertices[2].y == 3,
+            "vector of structs"
+        );
+        tap.expect (s.scale[0] == 2 && s.scale[1] == 0.5f, "array field");
+        tap.expect (s.layer && *s.layer == 7, "optional field");
+        tap.expect_eq (s.weight, 1.25, "escaped key");
+        tap.expect (s.visible, "boolean field");
+    }
+
+    // absent fields keep their defaults, and null empties an optional
+    {
+        const auto s = decode<shape> (R"_({ "name": "x", "layer": null })_");
+        tap.expect (
+            s.fill == colour::RED && s.vertices.empty () && s.scale[0] == 1 && !s.layer,
+            "absent fields keep defaults"
+        );
+    }
+
+    // encoding produces text that decodes to the same value
+    {
+        shape s;
+        s.name = "quote\"d";
+        s.fill = colour::GREEN;
+        s.vertices = { { 1, 2 }, { -3, 4 } };
+        s.layer = 3;
+        s.weight = 0.1;
+
+        const auto text = util::json2::encode (s);
+        tap.expect_eq (
+            text,
+            R"_({"name":"quote\"d","fill":"GREEN","vertices":[{"x":1,"y":2},{"x":-3,"y":4}],"scale":[1.0,1.0],"layer":3,"weight":0.1,"visible":false})_",
+            "encode"
+        );
+
+        const auto copy = decode<shape> (text.c_str ());
+        tap.expect (
+            copy.name == s.name && copy.fill == s.fill &&
+            copy.vertices.size () == 2 && copy.vertices[1].x == -3 &&
+            copy.layer == s.layer && copy.weight == s.weight,
+            "round trip"
+        );
+    }
+
+    // type mismatches and range errors are reported
+    {
+        static const char *BAD[] = {
+            R"_({ "layer": 256 })_",
+            R"_({ "layer": -1 })_",
+            R"_({ "fill": "PURPLE" })_",
+            R"_({ "scale": [ 1, 2, 3 ] })_",
+            R"_({ "scale": [ 1 ] })_",
+            R"_({ "visible": "yes" })_",
+            R"_({ "vertices": {} })_",
+            R"_([])_",
+        };
+
+        for (auto b: BAD)
+            tap.expect_throw<util::json2::parse_error> ([&] { decode<shape> (b); }, "rejects %s", b);
+    }
+
+    return tap.status ();
+}
@@ -0,0 +1,91 @@
+#include "json2/cursor.hpp"
+#include "json2/except.hpp"
+#include "tap.hpp"
+
+#include <cstring>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    static const char TEST_STRING[] = R"_(
+        {
+            "skipped": { "deep": [ { "a": "}]" }, [ "\"{[" ] ], "more": [1,2,3] },
+            "string": "brad",
+            "esc\"aped": "a\\bé",
+            "integer": -12,
+            "unsigned": 18446744073709551615,
+            "real": 3.25,
+            "null": null,
+            "false": false,
+            "true": true,
+            "array": [ 1, [ 2, 3 ], { "x": 4 }, "five" ]
+        })_";
+
+    const util::json2::cursor root (TEST_STRING, TEST_STRING + strlen (TEST_STRING));
+
+    tap.expect (root.is_object (), "root is_object");
+    tap.expect_eq (root.size (), 10u, "member count");
+
+    tap.expect_eq (root["string"].as_string (), "brad", "string value after skipped subtree");
+    tap.expect_eq (root["esc\"aped"].as_string (), "a\\b\xc3\xa9", "escaped key and value");
+    tap.expect_eq (root["integer"].as_sint (), -12, "signed value");
+    tap.expect_eq (root["unsigned"].as_uint (), UINTMAX_MAX, "unsigned value");
+    tap.expect_eq (root["real"].as_double (), 3.25, "real value");
+    tap.expect (root["null"].is_null (), "null value");
+    tap.expect (!root["false"].as_boolean (), "false value");
+    tap.expect ( root["true"].as_boolean (), "true value");
+
+    tap.expect_eq (root["array"].size (), 4u, "array size");
+    tap.expect_eq (root["array"][1][1].as_sint (), 3, "nested array index");
+    tap.expect_eq (root["array"][2]["x"].as_sint (), 4, "object within array");
+    tap.expect_eq (root["array"][3].as_string (), "five", "last array element");
+
+    tap.expect_eq (
+        root["skipped"]["deep"].raw (),
+        R"_([ { "a": "}]" }, [ "\"{[" ] ])_",
+        "raw extent of subtree with brackets in strings"
+    );
+
+    {
+        intmax_t sum = 0;
+        root["skipped"]["more"].for_each ([&] (auto v) { sum += v.as_sint (); });
+        tap.expect_eq (sum, 6, "array iteration");
+    }
+
+    {
+        std::string keys;
+        root.for_each_member ([&] (auto key, auto) { keys += key.substr (0, 1); });
+        tap.expect_eq (keys, "sseiurnfta", "member iteration order");
+    }
+
+    tap.expect (!root.find ("missing"), "missing key");
+    tap.expect_throw<std::out_of_range> ([&] { root["missing"]; }, "missing key throws");
+    tap.expect_throw<std::out_of_range> ([&] { root["array"][4]; }, "array overrun throws");
+    tap.expect_throw<util::json2::parse_error> ([&] { root["string"].as_sint (); }, "type mismatch throws");
+
+    // errors on the path to a value must be detected
+    {
+        static const struct {
+            const char *data;
+            const char *message;
+        } BAD[] = {
+            { R"({"a" 1})",  "missing colon" },
+            { R"({"a":1 "b":2})", "missing comma" },
+            { R"({"a":1,})", "trailing comma" },
+            { R"({"a":[1,2)", "unterminated array" },
+            { R"({"a":"b)", "unterminated string" },
+        };
+
+        for (const auto &t: BAD) {
+            const util::json2::cursor c (t.data, t.data + strlen (t.data));
+            tap.expect_throw<util::json2::parse_error> ([&] { c["b"]; }, "%s", t.message);
+        }
+    }
+
+    return tap.status ();
+}
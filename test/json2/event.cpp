@@ -5,6 +5,8 @@
 #include <vector>
 #include <cstring>
 #include <functional>
+#include <iterator>
+#include <string>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -17,6 +19,9 @@ test_numbers (util::TAP::logger &tap)
         const char *message;
     } TESTS[] = {
         { "1", true, "single digit" },
+        { "0", true, "zero" },
+        { "0.5", true, "zero fraction" },
+        { "0e1", true, "zero exponential" },
         { "01", false, "leading zero" },
         { "-1", true, "leading minus" },
         { "+1", false, "leading plus" },
@@ -122,6 +127,7 @@ test_strings (util::TAP::logger &tap)
         { "\"\\a\"", true, "valid unnecessary escape" },
         { "\"\\uABCD\"", true, "upper unicode hex escape" },
         { "\"\\uabcd\"", true, "lower unicode hex escape" },
+        { "\"\\u0062\"", true, "numeric unicode hex escape" },
         { "\"\\uab\"", false, "truncated unicode hex escape" },
         { "\"\\uabxy\"", false, "invalid unicode hex escape" },
     };
@@ -198,6 +204,17 @@ test_arrays (util::TAP::logger &tap)
             },
             "two numbers"
         },
+        {
+            "[ 1 , 2 ]",
+            true,
+            {
+                type_t::ARRAY_BEGIN,
+                type_t::NUMBER,
+                type_t::NUMBER,
+                type_t::ARRAY_END
+            },
+            "whitespace around values"
+        },
         {
             "[1,]",
             false,
@@ -445,6 +462,31 @@ test_jsonish (util::TAP::logger &tap)
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// the std::function entry point and the template sink overload must deliver
+// identical packets.
+void
+test_sinks (util::TAP::logger &tap)
+{
+    static const char DATA[] = R"_({ "a": [1, true, null, "b"], "c": { "d": -1.5e3 } })_";
+
+    std::vector<std::string> dynamic, inlined;
+
+    const std::function<util::json2::callback_t> cb = [&] (const auto &p) {
+        dynamic.emplace_back (p.first, p.last);
+    };
+    util::json2::event::parse (cb, std::begin (DATA), std::end (DATA) - 1);
+
+    util::json2::event::parse (
+        [&] (const auto &p) { inlined.emplace_back (p.first, p.last); },
+        std::begin (DATA),
+        std::end (DATA) - 1
+    );
+
+    tap.expect (!dynamic.empty () && dynamic == inlined, "std::function and template sinks agree");
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 int
 main (void)
@@ -458,6 +500,7 @@ main (void)
     test_objects (tap);
 
     test_jsonish (tap);
+    test_sinks (tap);
 
     return tap.status ();
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "json2/incremental.hpp"
+#include "json2/event.hpp"
+#include "json2/except.hpp"
+#include "json2/personality/jsonish.hpp"
+#include "json2/personality/rfc7519.hpp"
+#include "tap.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// we record the text of each packet rather than its type because jsonish
+// bare strings don't have a type that packet::type can report.
+using token_t = std::string;
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+std::vector<token_t>
+parse_whole (const std::string &data)
+{
+    std::vector<token_t> res;
+    util::json2::event::parse<PersonalityT> (
+        [&] (auto p) { res.emplace_back (p.first, p.last); },
+        data.data (),
+        data.data () + data.size ()
+    );
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+/// parses `data` in chunks of at most `stride` bytes.
+template <typename PersonalityT>
+std::vector<token_t>
+parse_chunked (const std::string &data, size_t stride)
+{
+    std::vector<token_t> res;
+    auto const cb = [&] (auto p) { res.emplace_back (p.first, p.last); };
+
+    util::json2::event::incremental<PersonalityT> parser;
+    for (size_t i = 0; i < data.size (); i += stride) {
+        auto first = data.data () + i;
+        auto last  = data.data () + std::min (data.size (), i + stride);
+        parser.feed (cb, first, last);
+    }
+    parser.finish (cb);
+
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+template <typename PersonalityT>
+void
+test_equivalence (util::TAP::logger &tap,
+                  const char *name,
+                  const std::vector<std::string> &documents)
+{
+    for (const auto &doc: documents) {
+        const auto expected = parse_whole<PersonalityT> (doc);
+
+        bool success = true;
+        for (size_t stride = 1; stride <= doc.size (); ++stride)
+            success = success && parse_chunked<PersonalityT> (doc, stride) == expected;
+
+        // keep the TAP output on one line
+        auto label = doc;
+        std::replace (label.begin (), label.end (), '\n', ' ');
+
+        tap.expect (success, "%s, chunked matches whole, %s", name, label);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    test_equivalence<util::json2::personality::rfc7159> (tap, "rfc7159", {
+        "1",
+        "-12.5e+3",
+        "true",
+        "null",
+        R"("a \"quoted\" \\ string")",
+        "[]",
+        "{}",
+        R"([1,"two",[true,false],{"a":null}])",
+        R"({ "a" : [ 1, 2], "b": { "c": "\\" } })",
+        R"(  {"key":"value"}  )",
+    });
+
+    test_equivalence<util::json2::personality::jsonish> (tap, "jsonish", {
+        "0x1f",
+        "+12",
+        "bare",
+        "# comment\n[1,2]",
+        "{ a: 1, # trailing comment\n b: [0b101, 017] }",
+        R"([ident, "string", 1.5])",
+    });
+
+    // malformed input must be rejected whichever way it is chunked
+    {
+        static const char* BAD[] = {
+            "[1,]",
+            "[1 2]",
+            "{\"a\" 1}",
+            "{\"a\":1,}",
+            "{1:1}",
+            "[",
+            "\"abc",
+            "tru",
+            "[1true]",
+            "1 2",
+            "]",
+        };
+
+        for (const auto &b: BAD) {
+            const std::string doc = b;
+
+            bool success = true;
+            for (size_t stride = 1; stride <= doc.size (); ++stride) {
+                try {
+                    parse_chunked<util::json2::personality::rfc7159> (doc, stride);
+                    success = false;
+                } catch (const util::json2::parse_error&) {
+                    ;
+                }
+            }
+
+            tap.expect (success, "rejects '%s'", doc);
+        }
+    }
+
+    // limits on nesting and token length must be enforced
+    {
+        util::json2::event::incremental<> parser (8, 4);
+        const std::string deep = "[[[[[";
+        tap.expect_throw<util::json2::parse_error> (
+            [&] { parser.feed ([] (auto) {}, deep.data (), deep.data () + deep.size ()); },
+            "depth limit"
+        );
+
+        parser.reset ();
+        const std::string a = "\"abcd", b = "efghij\"";
+        tap.expect_throw<util::json2::parse_error> (
+            [&] {
+                parser.feed ([] (auto) {}, a.data (), a.data () + a.size ());
+                parser.feed ([] (auto) {}, b.data (), b.data () + b.size ());
+            },
+            "token length limit"
+        );
+    }
+
+    // packets should be delivered before the document is complete
+    {
+        util::json2::event::incremental<> parser;
+        size_t count = 0;
+        const std::string part = R"([1, "a", [)";
+        parser.feed ([&] (auto) { ++count; }, part.data (), part.data () + part.size ());
+        tap.expect (count == 4 && !parser.complete (), "packets emitted as tokens complete");
+    }
+
+    return tap.status ();
+}
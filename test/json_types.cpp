@@ -1,4 +1,5 @@
 #include "json/tree.hpp"
+#include "json2/except.hpp"
 
 #include "debug.hpp"
 #include "maths.hpp"
@@ -6,6 +7,10 @@
 
 #include <memory>
 #include <cstdlib>
+#include <fstream>
+#include <type_traits>
+
+#include <unistd.h>
 
 int
 main (void)
@@ -127,5 +132,118 @@ main (void)
         tap.expect (!ref["array"].is_string (),     "array not is_string");
     }
 
+    // objects retain insertion order, and stay consistent as they cross the
+    // threshold for hashed lookups.
+    {
+        json::tree::object obj;
+        const size_t count = json::tree::object::INDEX_THRESHOLD * 4 + 3;
+
+        for (size_t i = 0; i < count; ++i)
+            obj.insert (std::to_string (count - i), std::make_unique<json::tree::number> (intmax_t (i)));
+
+        bool ordered = true;
+        size_t i = 0;
+        for (const auto &kv: obj)
+            ordered = ordered && kv.first == std::to_string (count - i++);
+        tap.expect (ordered, "object iterates in insertion order");
+
+        // keys feed the hash index so neither iterator may modify them
+        static_assert (std::is_same_v<decltype ((obj.begin ()->first)), const json::tree::key&>);
+        static_assert (std::is_same_v<decltype ((json::tree::object::iterator {}->first)), const json::tree::key&>);
+
+        bool found = true;
+        for (size_t j = 0; j < count; ++j)
+            found = found && obj[std::to_string (count - j)].as_sint () == intmax_t (j);
+        tap.expect (found, "indexed object lookup");
+        tap.expect (!obj.has ("0"), "indexed object missing key");
+        tap.expect (obj.find ("0") == obj.end (), "indexed object find missing key");
+
+        obj.insert ("1", std::make_unique<json::tree::boolean> (true));
+        tap.expect_eq (obj.size (), count, "replacing a value keeps the size");
+        tap.expect ((obj.end () - 1)->second->is_boolean (), "replacing a value keeps its position");
+
+        obj.erase (std::to_string (count));
+        tap.expect (!obj.has (std::to_string (count)), "erased key is missing");
+        tap.expect (obj.has (std::to_string (count - 1)), "keys remain after erase");
+
+        auto copy = obj.clone ();
+        tap.expect (*copy == obj, "cloned object is equal");
+
+        json::tree::object a, b;
+        a.insert ("x", std::make_unique<json::tree::null> ());
+        a.insert ("y", std::make_unique<json::tree::null> ());
+        b.insert ("y", std::make_unique<json::tree::null> ());
+        b.insert ("x", std::make_unique<json::tree::null> ());
+        tap.expect (a == b, "object equality ignores member order");
+
+        b.insert ("z", std::make_unique<json::tree::null> ());
+        tap.expect (!(a == b), "object equality requires equal sizes");
+    }
+
+    // keys are shared between the members of every document parsed with the
+    // same interner
+    {
+        static const std::string DOC = R"_([
+            { "id": 1, "name": "a" },
+            { "id": 2, "name": "b" }
+        ])_";
+
+        json::tree::interner keys;
+        auto first  = json::tree::parse (util::view<const char*> (DOC.data (), DOC.data () + DOC.size ()), keys);
+        auto second = json::tree::parse (util::view<const char*> (DOC.data (), DOC.data () + DOC.size ()), keys);
+
+        tap.expect_eq (keys.size (), 2u, "interner holds distinct keys");
+
+        const auto &x = (*first )[0].as_object ().begin ()->first;
+        const auto &y = (*first )[1].as_object ().begin ()->first;
+        const auto &z = (*second)[0].as_object ().begin ()->first;
+        tap.expect (&x.str () == &y.str () && &y.str () == &z.str (), "interned keys share storage");
+
+        keys.clear ();
+        tap.expect_eq ((*second)[1]["name"].as_string ().native (), "b", "keys outlive their interner");
+        tap.expect (*first == *second, "equal documents with shared keys");
+    }
+
+    // mapped and streamed file parsing agree with parsing from memory, even
+    // when tokens straddle the chunks read from the file.
+    {
+        char path[] = "/tmp/json_types.XXXXXX";
+        const int fd = mkstemp (path);
+        CHECK_GE (fd, 0);
+        close (fd);
+
+        std::ofstream (path) << TEST_STRING << '\n';
+
+        const auto expected = json::tree::parse (util::make_view (TEST_STRING));
+        const auto mapped   = json::tree::parse (path);
+        const auto small    = json::tree::parse_stream (path, 3);
+        const auto large    = json::tree::parse_stream (path);
+
+        tap.expect (*expected == *mapped, "mapped file parse");
+        tap.expect (*expected == *small,  "streamed file parse, small chunks");
+        tap.expect (*expected == *large,  "streamed file parse, default chunks");
+
+        std::ofstream (path) << R"_({ "a": [ 1, -2, 3.5e1, "\"x\"" )_";
+        tap.expect_throw<util::json2::parse_error> (
+            [&] { json::tree::parse_stream (path, 4); },
+            "streamed file parse, truncated"
+        );
+
+        // tokens larger than the incremental parser's default carry limit
+        // are still parsed, unless the caller asks for a bound.
+        const std::string big (100000, 'x');
+        std::ofstream (path) << '"' << big << '"';
+
+        const auto str = json::tree::parse_stream (path, 4096);
+        tap.expect_eq (str->as_string ().native (), big, "streamed file parse, long string");
+
+        tap.expect_throw<util::json2::parse_error> (
+            [&] { json::tree::parse_stream (path, 4096, 1024); },
+            "streamed file parse, token exceeds max_token"
+        );
+
+        unlink (path);
+    }
+
     return tap.status ();
 }
@@ -0,0 +1,183 @@
+#include "log/async.hpp"
+
+#include "io.hpp"
+#include "tap.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// returns the lines written to the file at `path`
+static std::vector<std::string>
+read_lines (const char *path)
+{
+    const auto data = util::slurp<char> (path);
+
+    std::vector<std::string> lines;
+    std::istringstream is (std::string (data.begin (), data.end ()));
+    for (std::string l; std::getline (is, l); )
+        lines.push_back (l);
+    return lines;
+}
+
+
+//-----------------------------------------------------------------------------
+static util::posix::fd
+open_temporary (char *path)
+{
+    return util::posix::fd (mkstemp (path));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // lines from many threads all arrive, and each thread's lines remain in
+    // order, when producers block rather than drop.
+    {
+        static constexpr int THREADS = 4;
+        static constexpr int LINES = 2000;
+
+        char path[] = "/tmp/log_async.XXXXXX";
+        {
+            util::logging::async sink (
+                open_temporary (path), 4096, util::logging::async::overflow::BLOCK
+            );
+
+            std::vector<std::thread> workers;
+            for (int t = 0; t < THREADS; ++t) {
+                workers.emplace_back ([&sink, t] {
+                    for (int i = 0; i < LINES; ++i) {
+                        auto l = std::to_string (t) + ' ' + std::to_string (i) + '\n';
+                        sink.write (util::NOTICE, l);
+                    }
+                });
+            }
+
+            for (auto &w: workers)
+                w.join ();
+
+            sink.flush ();
+            tap.expect_eq (sink.dropped (), 0u, "blocking sink drops nothing");
+        }
+
+        const auto lines = read_lines (path);
+        tap.expect_eq (lines.size (), size_t (THREADS * LINES), "blocking sink writes every line");
+
+        std::vector<int> next (THREADS, 0);
+        bool ordered = true;
+        for (const auto &l: lines) {
+            int t, i;
+            std::istringstream (l) >> t >> i;
+            ordered = ordered && t >= 0 && t < THREADS && next[t] == i;
+            if (t >= 0 && t < THREADS)
+                next[t] = i + 1;
+        }
+        tap.expect (ordered, "per thread ordering is retained");
+
+        unlink (path);
+    }
+
+    // an overflowing ring reports how many lines it dropped, and together
+    // with the lines that were written these account for every line.
+    {
+        static constexpr int LINES = 20000;
+
+        char path[] = "/tmp/log_async.XXXXXX";
+        uintmax_t dropped;
+        {
+            util::logging::async sink (
+                open_temporary (path), 1, util::logging::async::overflow::COUNT
+            );
+
+            const std::string l (100, 'x');
+            for (int i = 0; i < LINES; ++i)
+                sink.write (util::NOTICE, l + '\n');
+
+            dropped = sink.dropped ();
+        }
+
+        size_t written = 0, reported = 0;
+        for (const auto &l: read_lines (path)) {
+            if (l[0] == 'x') {
+                ++written;
+            } else {
+                const auto pos = l.find ("] ");
+                if (pos != std::string::npos)
+                    reported += std::stoul (l.substr (pos + 2));
+            }
+        }
+
+        tap.expect_eq (reported, dropped, "dropped lines are reported");
+        tap.expect_eq (written + reported, size_t (LINES), "all lines are accounted for");
+
+        unlink (path);
+    }
+
+    // lines that can never fit are truncated rather than lost
+    {
+        char path[] = "/tmp/log_async.XXXXXX";
+        {
+            util::logging::async sink (open_temporary (path), 1);
+            const std::string l (1 << 20, 'y');
+            sink.write (util::NOTICE, l);
+        }
+
+        const auto lines = read_lines (path);
+        tap.expect (
+            lines.size () == 1 && !lines[0].empty () && lines[0].size () < (1 << 20),
+            "long lines are truncated"
+        );
+
+        unlink (path);
+    }
+
+    // the existing logging calls are redirected once a sink is installed
+    {
+        char path[] = "/tmp/log_async.XXXXXX";
+        {
+            util::logging::async sink (open_temporary (path));
+            auto previous = util::logging::install (&sink);
+
+            const std::string runtime = "runtime message";
+
+            LOG_WARN ("redirected %s", "message");
+            LOG_WARN (runtime);
+            LOG_LITERAL (util::WARN, "literal %s", "message");
+            util::logging::flush ();
+
+            const auto lines = read_lines (path);
+            tap.expect (
+                lines.size () == 3 &&
+                lines[0].find ("[WARN") != std::string::npos &&
+                lines[0].find ("redirected message") != std::string::npos,
+                "macros write to the installed sink"
+            );
+
+            tap.expect (
+                lines.size () == 3 && lines[1].find (runtime) != std::string::npos,
+                "macros accept runtime messages"
+            );
+
+            tap.expect (
+                lines.size () == 3 && lines[2].find ("literal message") != std::string::npos,
+                "compiled formats write to the installed sink"
+            );
+
+            util::logging::install (previous);
+        }
+
+        unlink (path);
+    }
+
+    return tap.status ();
+}
@@ -0,0 +1,199 @@
+#include "log/binary.hpp"
+#include "log/async.hpp"
+
+#include "io.hpp"
+#include "tap.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// accumulates everything written to it, for later inspection
+struct capture : public util::logging::sink {
+    void write (util::level_t, std::string_view data) override
+    { value.append (data); }
+
+    std::string value;
+};
+
+
+//-----------------------------------------------------------------------------
+static bool
+contains (const std::string &haystack, const char *needle)
+{
+    return haystack.find (needle) != std::string::npos;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    // without a binary sink messages are formatted immediately
+    {
+        capture text;
+        auto previous = util::logging::install (&text);
+
+        LOG_DEFERRED (util::WARN, "immediate %s %d", "message", 42);
+
+        util::logging::install (previous);
+        tap.expect (
+            contains (text.value, "[WARN") && contains (text.value, "immediate message 42"),
+            "messages are formatted immediately without a binary sink"
+        );
+    }
+
+    // records can be decoded after the fact, and are much smaller than the
+    // formatted text.
+    {
+        capture raw;
+        util::logging::binary::install (&raw);
+
+        for (int i = 0; i < 3; ++i)
+            LOG_DEFERRED (util::ERROR, "%s %i %u %.2f %c", "deferred", -i, 7u, 0.5, 'x');
+
+        const std::string long_string (1024, 'z');
+        LOG_DEFERRED (util::NOTICE, "%s", long_string);
+
+        util::logging::binary::uninstall (&raw);
+
+        util::logging::binary::decoder decoder;
+        decoder.define (raw.value);
+
+        std::string text;
+        decoder.decode (raw.value, text);
+
+        tap.expect (
+            contains (text, "[ERROR") &&
+            contains (text, "deferred 0 7 0.50 x") &&
+            contains (text, "deferred -2 7 0.50 x"),
+            "decoded messages match their format"
+        );
+
+        tap.expect (
+            contains (text, std::string (util::logging::binary::MAX_STRING, 'z').c_str ()) &&
+            !contains (text, std::string (util::logging::binary::MAX_STRING + 1, 'z').c_str ()),
+            "long strings are truncated"
+        );
+
+        // a second sink receives the definitions of every site seen so far
+        capture again;
+        util::logging::binary::install (&again);
+        util::logging::binary::uninstall (&again);
+        tap.expect (!again.value.empty (), "installation writes existing definitions");
+    }
+
+    // an async sink can format records on its background thread
+    {
+        char path[] = "/tmp/log_binary.XXXXXX";
+        {
+            util::logging::async sink (
+                util::posix::fd (mkstemp (path)),
+                util::logging::binary::decoder {}
+            );
+
+            util::logging::binary::install (&sink);
+            LOG_DEFERRED (util::WARN, "filtered %s %u", std::string ("record"), 3u);
+            util::logging::binary::uninstall (&sink);
+        }
+
+        const auto data = util::slurp<char> (path);
+        const std::string text (data.begin (), data.end ());
+        tap.expect (
+            contains (text, "[WARN") && contains (text, "filtered record 3"),
+            "async sinks decode records with a filter"
+        );
+
+        unlink (path);
+    }
+
+    // records discarded by an overflowing sink are noted in the binary
+    // stream, which remains decodable.
+    {
+        static constexpr int COUNT = 5000;
+
+        char path[] = "/tmp/log_binary.XXXXXX";
+        uintmax_t dropped;
+        {
+            util::logging::async sink (util::posix::fd (mkstemp (path)), 1);
+
+            util::logging::binary::install (&sink);
+            for (int i = 0; i < COUNT; ++i)
+                LOG_DEFERRED (util::WARN, "overflow %d", i);
+            util::logging::binary::uninstall (&sink);
+
+            dropped = sink.dropped ();
+        }
+
+        const util::mapped_file data (path);
+        const std::string_view src (reinterpret_cast<const char*> (data.data ()), data.size ());
+
+        util::logging::binary::decoder decoder;
+        decoder.define (src);
+
+        std::string text;
+        decoder.decode (src, text);
+
+        size_t written = 0, reported = 0;
+        bool valid = true;
+        for (size_t first = 0, last; first < text.size (); first = last + 1) {
+            last = text.find ('\n', first);
+            const auto l = text.substr (first, last - first);
+
+            if (l.find ("] overflow ") != std::string::npos) {
+                ++written;
+            } else if (auto pos = l.find (" log messages dropped"); pos != std::string::npos) {
+                reported += std::stoul (l.substr (l.find ("] ") + 2, pos));
+            } else {
+                valid = false;
+            }
+        }
+
+        tap.expect (dropped > 0 && valid, "overflowing binary sinks remain decodable");
+        tap.expect_eq (written + reported, size_t (COUNT), "binary drop records account for every message");
+
+        unlink (path);
+    }
+
+    // a site's definition survives even when its first use overflows the
+    // ring, so the file remains decodable on its own.
+    {
+        char path[] = "/tmp/log_binary.XXXXXX";
+        {
+            util::logging::async sink (
+                util::posix::fd (mkstemp (path)),
+                1,
+                util::logging::async::overflow::DROP
+            );
+
+            util::logging::binary::install (&sink);
+            for (int i = 0; i < 100'000 && !sink.dropped (); ++i)
+                LOG_DEFERRED (util::WARN, "filling %d", i);
+            LOG_DEFERRED (util::WARN, "first use %d", 1);
+            util::logging::binary::uninstall (&sink);
+        }
+
+        const auto data = util::slurp<char> (path);
+        const std::string raw (data.begin (), data.end ());
+
+        util::logging::binary::decoder decoder;
+        decoder.define (raw);
+
+        std::string text;
+        decoder.decode (raw, text);
+
+        tap.expect (
+            contains (raw, "first use %d") && !contains (text, "undefined binary log site"),
+            "site definitions are never dropped"
+        );
+
+        unlink (path);
+    }
+
+    return tap.status ();
+}
@@ -0,0 +1,111 @@
+#include "log/limit.hpp"
+
+#include "tap.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// accumulates every line written to it
+struct capture : public util::logging::sink {
+    void write (util::level_t, std::string_view data) override
+    { lines.emplace_back (data); }
+
+    std::vector<std::string> lines;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    static constexpr uint64_t SECOND = 1'000'000'000;
+
+    // a bucket admits its burst at once, then refills at its rate
+    {
+        util::token_bucket bucket (2, 3);
+        const uint64_t start = 100 * SECOND;
+
+        int admitted = 0;
+        for (int i = 0; i < 10; ++i)
+            admitted += bucket.try_acquire (start) ? 1 : 0;
+        tap.expect_eq (admitted, 3, "token bucket admits a burst");
+
+        tap.expect (!bucket.try_acquire (start + SECOND / 4), "token bucket is empty after a burst");
+        tap.expect (bucket.try_acquire (start + SECOND / 2), "token bucket refills at its rate");
+
+        // a long idle period doesn't earn more than a burst
+        admitted = 0;
+        for (int i = 0; i < 10; ++i)
+            admitted += bucket.try_acquire (start + 100 * SECOND) ? 1 : 0;
+        tap.expect_eq (admitted, 3, "token bucket is bounded by its burst");
+    }
+
+    // rates that can't produce an interval are rejected up front
+    for (const double rate: { 0., -1., std::nan (""), 1e-300 }) {
+        tap.expect_throw<std::invalid_argument> (
+            [&] { util::token_bucket (rate, 1); },
+            "token bucket rejects rate %!", rate
+        );
+    }
+
+    // suppressed messages are counted, and reported with the next admitted
+    {
+        util::logging::limited limit (1, 1);
+        const uint64_t start = 100 * SECOND;
+
+        tap.expect (limit.admit (start) == uintmax_t (0), "first message is admitted");
+        for (int i = 0; i < 5; ++i)
+            limit.admit (start);
+        tap.expect (limit.admit (start + 2 * SECOND) == uintmax_t (5), "suppressed messages are counted");
+    }
+
+    // the macros limit a storm from a single call site
+    {
+        capture out;
+        auto previous = util::logging::install (&out);
+
+        for (int i = 0; i < 1000; ++i)
+            LOG_LIMITED (util::WARN, 0.001, 2, "storm %d", i);
+
+        tap.expect_eq (out.lines.size (), 2u, "limited site logs its burst");
+
+        // messages suppressed at a site are reported before the next one it
+        // admits. the single token refills well within the sleep.
+        out.lines.clear ();
+        const auto burst = [] (int i) { LOG_LIMITED (util::WARN, 10, 1, "burst %d", i); };
+        for (int i = 0; i < 3; ++i)
+            burst (i);
+        std::this_thread::sleep_for (std::chrono::milliseconds (250));
+        burst (3);
+
+        tap.expect (
+            out.lines.size () == 3 &&
+            out.lines[0].find ("burst 0") != std::string::npos &&
+            out.lines[1].find ("suppressed 2 messages like 'burst %d'") != std::string::npos &&
+            out.lines[2].find ("burst 3") != std::string::npos,
+            "limited site reports suppressed messages"
+        );
+
+        out.lines.clear ();
+        for (int i = 0; i < 100; ++i)
+            LOG_SAMPLED (util::WARN, 10, "sample %d", i);
+
+        tap.expect (
+            out.lines.size () == 10 &&
+            out.lines[0].find ("sample 0") != std::string::npos &&
+            out.lines[1].find ("sample 10") != std::string::npos,
+            "sampled site logs one in N"
+        );
+
+        util::logging::install (previous);
+    }
+
+    return tap.status ();
+}
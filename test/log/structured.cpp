@@ -0,0 +1,54 @@
+#include "log/structured.hpp"
+
+#include "tap.hpp"
+
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////
+struct capture : public util::logging::sink {
+    void write (util::level_t, std::string_view data) override
+    { value.append (data); }
+
+    std::string value;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (void)
+{
+    util::TAP::logger tap;
+
+    tap.expect_eq (
+        util::logging::structured::line (
+            util::WARN,
+            "slow \"query\"",
+            { { "ms", 250 }, { "rows", 3u }, { "ratio", 0.5 }, { "cached", false },
+              { "table", "users" }, { "owner", nullptr } },
+            0
+        ),
+        "{\"time\":\"1970-01-01T00:00:00Z\",\"level\":\"WARN\","
+        "\"message\":\"slow \\\"query\\\"\",\"ms\":250,\"rows\":3,"
+        "\"ratio\":0.5,\"cached\":false,\"table\":\"users\",\"owner\":null}\n",
+        "structured line is a JSON object"
+    );
+
+    {
+        capture out;
+        auto previous = util::logging::install (&out);
+
+        LOG_FIELDS (util::WARN, "disk full", { "free", 0u });
+        LOG_FIELDS (util::DEBUG, "hidden", { "value", 1 });
+
+        util::logging::install (previous);
+
+        tap.expect (
+            out.value.find ("\"message\":\"disk full\",\"free\":0}\n") != std::string::npos &&
+            out.value.find ("hidden") == std::string::npos,
+            "structured messages are written to the sink, respecting the level"
+        );
+    }
+
+    return tap.status ();
+}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <array>
+#include <string>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -312,6 +313,140 @@ illegal (util::TAP::logger &tap)
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// generate random sequences biased towards interesting bytes, and check
+// the validator, counters, and transcoders agree with the scalar decoder.
+void
+differential (util::TAP::logger &tap)
+{
+    static constexpr uint8_t INTERESTING[] = {
+        0x00, 0x20, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbe, 0xbf,
+        0xc0, 0xc1, 0xc2, 0xdf, 0xe0, 0xed, 0xee, 0xef, 0xf0, 0xf4,
+        0xf5, 0xf7, 0xf8, 0xfe, 0xff,
+    };
+
+    uint32_t state = 0xdeadbeef;
+    auto next = [&] () {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state <<  5;
+        return state;
+    };
+
+    bool validate_success = true;
+    bool count_success = true;
+    bool utf32_success = true;
+    bool utf16_success = true;
+    int valid_count = 0;
+
+    for (int i = 0; i < 20000; ++i) {
+        std::vector<uint8_t> data (next () % 72);
+        for (auto &c: data) {
+            switch (next () % 16) {
+            case 0: c = next (); break;
+            case 1:
+            case 2: c = INTERESTING[next () % std::size (INTERESTING)]; break;
+            case 3:
+            case 4: c = 0x80 | next () % 0x40; break;
+            default: c = next () % 0x80; break;
+            }
+        }
+
+        const util::view<const std::byte*> src {
+            reinterpret_cast<const std::byte*> (data.data ()),
+            reinterpret_cast<const std::byte*> (data.data ()) + data.size ()
+        };
+
+        std::vector<util::utf8::codepoint_t> expected;
+        bool valid = true;
+        try {
+            expected = util::utf8::decode (src);
+        } catch (const util::utf8::error&) {
+            valid = false;
+        }
+
+        validate_success = validate_success && valid == util::utf8::validate (src);
+        if (!valid)
+            continue;
+
+        ++valid_count;
+
+        // count the surrogate pairs we'd need for UTF-16
+        size_t pairs = 0;
+        bool representable = true;
+        for (auto c: expected) {
+            pairs += c >= 0x10000;
+            representable = representable && c <= 0x10FFFF;
+        }
+
+        count_success = count_success &&
+            util::utf8::count (src) == expected.size () &&
+            util::utf8::count_utf16 (src) == expected.size () + pairs;
+
+        std::vector<util::utf8::codepoint_t> utf32 (util::utf8::count (src));
+        utf32_success = utf32_success &&
+            util::utf8::decode (src, utf32.data ()) == utf32.data () + utf32.size () &&
+            utf32 == expected;
+
+        if (!representable)
+            continue;
+
+        std::vector<char16_t> utf16 (util::utf8::count_utf16 (src));
+        auto last = util::utf8::decode (src, utf16.data ());
+
+        std::vector<util::utf8::codepoint_t> roundtrip;
+        for (auto cursor = utf16.data (); cursor < last; ++cursor) {
+            if (*cursor >= 0xD800 && *cursor < 0xDC00) {
+                roundtrip.push_back (0x10000 + ((cursor[0] - 0xD800) << 10) + (cursor[1] - 0xDC00));
+                ++cursor;
+            } else {
+                roundtrip.push_back (*cursor);
+            }
+        }
+
+        utf16_success = utf16_success &&
+            last == utf16.data () + utf16.size () &&
+            roundtrip == expected;
+    }
+
+    tap.expect (validate_success, "validate agrees with decode");
+    tap.expect (count_success, "count agrees with decode");
+    tap.expect (utf32_success, "decode to buffer agrees with decode");
+    tap.expect (utf16_success, "decode to utf16 agrees with decode");
+    tap.expect_gt (valid_count, 500, "differential testing saw enough valid strings");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+static void
+long_strings (util::TAP::logger &tap)
+{
+    // exercise the vectorised paths with long runs of ASCII interspersed
+    // with multibyte sequences, and errors at each offset.
+    std::string ascii (200, 'a');
+    tap.expect (
+        util::utf8::validate (util::view<const char*> { ascii.data (), ascii.data () + ascii.size () }),
+        "long ASCII string validates"
+    );
+
+    std::string mixed;
+    for (int i = 0; i < 20; ++i)
+        mixed += u8"abcdefghijklmnopqrstuvwxyzκόσμε\U0001F600";
+
+    const util::view<const char*> mixed_view { mixed.data (), mixed.data () + mixed.size () };
+    tap.expect (util::utf8::validate (mixed_view), "long mixed string validates");
+    tap.expect_eq (util::utf8::decode (mixed_view).size (), 20u * 32, "long mixed string decodes");
+
+    bool success = true;
+    for (size_t i = 0; i < mixed.size (); ++i) {
+        auto broken = mixed;
+        broken[i] = '\xff';
+        success = success && !util::utf8::validate (util::view<const char*> { broken.data (), broken.data () + broken.size () });
+    }
+    tap.expect (success, "invalid byte detected at every offset");
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 int
 main()
@@ -323,6 +458,8 @@ main()
     malformed (tap);
     overlong (tap);
     illegal (tap);
+    differential (tap);
+    long_strings (tap);
 
     return tap.status ();
 };
\ No newline at end of file
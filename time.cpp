@@ -18,7 +18,10 @@
 
 #include "log.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <stdexcept>
 
 using util::delta_clock;
 
@@ -99,6 +102,51 @@ util::rate_limiter::poll (void)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// returns the nanoseconds between tokens for a bucket admitting `rate`
+// tokens per second, so that `burst` of those intervals remain representable.
+static uint64_t
+token_interval (double rate, unsigned burst)
+{
+    // written to reject NaN as well
+    if (!(rate > 0))
+        throw std::invalid_argument ("token_bucket rate must be positive");
+
+    const double interval = SECOND / rate;
+    if (interval * std::max (burst, 1u) >= double (std::numeric_limits<uint64_t>::max ()))
+        throw std::invalid_argument ("token_bucket rate is too low");
+
+    return static_cast<uint64_t> (interval);
+}
+
+
+//-----------------------------------------------------------------------------
+util::token_bucket::token_bucket (double rate, unsigned burst):
+    m_interval (token_interval (rate, burst)),
+    m_tolerance (m_interval * std::max (burst, 1u)),
+    m_full (0)
+{ ; }
+
+
+//-----------------------------------------------------------------------------
+bool
+util::token_bucket::try_acquire (uint64_t now)
+{
+    auto full = m_full.load (std::memory_order_relaxed);
+
+    do {
+        // the bucket can't be fuller than full, so time spent idle beyond
+        // that point doesn't earn further tokens.
+        const auto next = std::max (full, now) + m_interval;
+        if (next - now > m_tolerance)
+            return false;
+
+        if (m_full.compare_exchange_weak (full, next, std::memory_order_relaxed))
+            return true;
+    } while (true);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 util::polled_duration::polled_duration (std::string name, uint64_t interval):
     m_name     (name),
@@ -123,7 +171,7 @@ util::polled_duration::stop (void) {
     m_series.add (dt / MILLISECOND);
 
     if (m_next < now) {
-        LOG_DEBUG ("timing: '%s'. %s", m_name, m_series);
+        LOG_DEBUG ("timing: '%s'. %!", m_name, m_series);
         m_series.reset ();
         m_next = now + m_interval;
     }
@@ -19,6 +19,7 @@
 
 #include "stats.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -84,6 +85,32 @@ namespace util {
     };
 
 
+    ///////////////////////////////////////////////////////////////////////////
+    /// a non-blocking counterpart to rate_limiter; events are admitted at
+    /// `rate` per second on average, with up to `burst` admitted at once.
+    ///
+    /// the bucket is tracked as the time at which it would next be full
+    /// (the generic cell rate algorithm), so its state is a single atomic
+    /// and it may be shared between threads.
+    ///
+    /// throws std::invalid_argument if `rate` isn't positive, or is too low
+    /// for the interval between tokens to be represented.
+    class token_bucket {
+        public:
+            token_bucket (double rate, unsigned burst);
+
+            /// consumes a token if one is available at time `now`, in
+            /// nanoseconds, and returns whether it was.
+            bool try_acquire (uint64_t now);
+            bool try_acquire (void) { return try_acquire (nanoseconds ()); }
+
+        protected:
+            const uint64_t m_interval;
+            const uint64_t m_tolerance;
+            std::atomic<uint64_t> m_full;
+    };
+
+
     ///////////////////////////////////////////////////////////////////////////
     class polled_duration {
         public:
@@ -0,0 +1,545 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "io.hpp"
+#include "json/compact.hpp"
+#include "json/except.hpp"
+#include "json/flat.hpp"
+#include "json/structural.hpp"
+#include "json/tree.hpp"
+#include "json2/event.hpp"
+#include "json2/except.hpp"
+#include "view.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <experimental/filesystem>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compares the throughput, allocation behaviour, and memory use of each of
+// the JSON parsers over a set of corpora.
+//
+// usage: json-bench [--min-ms <n>] [--size <MiB>] [path...]
+//
+// four corpora are always generated: twitter-like records, numeric arrays,
+// deeply nested containers, and escape heavy strings. they are produced
+// from a fixed seed so results are comparable between runs and releases.
+// each path names a JSON file, or a directory whose *.json files are
+// parsed in turn as a single corpus (eg, test/json/good).
+//
+// every parser is measured against every corpus in a fresh child process,
+// so the reported peak RSS isn't inflated by earlier measurements. the
+// reported throughput is the median of several timed batches.
+//
+// output is one row per corpus and parser, in a fixed order, with columns:
+//  * MB/s: median throughput
+//  * allocs: heap allocations for a single parse of the corpus
+//  * alloc KiB: bytes requested by those allocations
+//  * peak RSS KiB: the high water mark of the measuring process
+static constexpr int BATCHES = 9;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// global allocation counters, updated by the replacement operator new.
+static size_t s_allocations;
+static size_t s_allocated;
+
+
+//-----------------------------------------------------------------------------
+void*
+operator new (size_t size)
+{
+    if (auto ptr = malloc (size ? size : 1)) {
+        ++s_allocations;
+        s_allocated += size;
+        return ptr;
+    }
+
+    throw std::bad_alloc ();
+}
+
+
+//-----------------------------------------------------------------------------
+void* operator new[] (size_t size) { return operator new (size); }
+void operator delete (void *ptr) noexcept { free (ptr); }
+void operator delete[] (void *ptr) noexcept { free (ptr); }
+void operator delete (void *ptr, size_t) noexcept { free (ptr); }
+void operator delete[] (void *ptr, size_t) noexcept { free (ptr); }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// a minimal deterministic generator. the standard distributions aren't
+// specified exactly, so we only rely on the raw output of the engine.
+class generator {
+public:
+    explicit generator (size_t target):
+        m_target (target)
+    { m_text.reserve (target + 4096); }
+
+    bool done (void) const { return m_text.size () >= m_target; }
+    std::string take (void) { return std::move (m_text); }
+
+    uint32_t next (uint32_t bound) { return m_engine () % bound; }
+
+    generator& raw (const char *str) { m_text += str; return *this; }
+    generator& raw (char c) { m_text += c; return *this; }
+
+    generator&
+    uint (uintmax_t val)
+    {
+        m_text += std::to_string (val);
+        return *this;
+    }
+
+    generator&
+    real (void)
+    {
+        char buffer[32];
+        snprintf (buffer, sizeof (buffer), "%.*g",
+                  int (next (15) + 2),
+                  (double (next (2000000)) - 1000000) / (1 << next (20)));
+        m_text += buffer;
+        return *this;
+    }
+
+    generator&
+    word (size_t length)
+    {
+        for (size_t i = 0; i < length; ++i)
+            m_text += char ('a' + next (26));
+        return *this;
+    }
+
+    generator&
+    string (size_t length)
+    {
+        m_text += '"';
+        word (length);
+        m_text += '"';
+        return *this;
+    }
+
+    generator&
+    escaped (size_t length)
+    {
+        static const char *PIECES[] = {
+            "\\\"", "\\\\", "\\/", "\\n", "\\t", "\\u00e9", "\\ud83d\\ude00",
+            "\xc3\xa9", "\xe2\x82\xac", " ",
+        };
+
+        m_text += '"';
+        for (size_t i = 0; i < length; ++i) {
+            if (next (4))
+                word (next (8) + 1);
+            else
+                m_text += PIECES[next (std::size (PIECES))];
+        }
+        m_text += '"';
+        return *this;
+    }
+
+private:
+    size_t m_target;
+    std::string m_text;
+    std::mt19937 m_engine { 0x5eed };
+};
+
+
+//-----------------------------------------------------------------------------
+static std::string
+generate_twitter (size_t target)
+{
+    generator g (target);
+    g.raw ("{\"statuses\":[");
+
+    for (uintmax_t id = 0; !g.done (); ++id) {
+        if (id)
+            g.raw (',');
+
+        const auto tweet = 500000000000000000u + id * 7919;
+        g.raw ("{\"created_at\":").string (24);
+        g.raw (",\"id\":").uint (tweet);
+        g.raw (",\"id_str\":\"").uint (tweet).raw ('"');
+        g.raw (",\"text\":").escaped (g.next (24) + 4);
+        g.raw (",\"truncated\":false");
+        g.raw (",\"in_reply_to_status_id\":null");
+        g.raw (",\"user\":{\"id\":").uint (g.next (1u << 30));
+        g.raw (",\"name\":").string (g.next (12) + 3);
+        g.raw (",\"screen_name\":").string (g.next (12) + 3);
+        g.raw (",\"description\":").escaped (g.next (12));
+        g.raw (",\"followers_count\":").uint (g.next (100000));
+        g.raw (",\"verified\":").raw (g.next (2) ? "true" : "false");
+        g.raw ("},\"entities\":{\"hashtags\":[");
+        for (uint32_t i = 0, count = g.next (3); i < count; ++i) {
+            if (i)
+                g.raw (',');
+            g.raw ("{\"text\":").string (g.next (10) + 2);
+            g.raw (",\"indices\":[").uint (g.next (100)).raw (',').uint (g.next (140)).raw ("]}");
+        }
+        g.raw ("],\"urls\":[]}");
+        g.raw (",\"retweet_count\":").uint (g.next (1000));
+        g.raw (",\"favorited\":false,\"coordinates\":null,\"lang\":\"en\"}");
+    }
+
+    g.raw ("]}");
+    return g.take ();
+}
+
+
+//-----------------------------------------------------------------------------
+static std::string
+generate_numeric (size_t target)
+{
+    generator g (target);
+    g.raw ('[');
+
+    for (size_t i = 0; !g.done (); ++i) {
+        if (i)
+            g.raw (',');
+
+        g.raw ('[').real ().raw (',').real ().raw (',').real ();
+        g.raw (',').uint (g.next (1u << 31)).raw (']');
+    }
+
+    g.raw (']');
+    return g.take ();
+}
+
+
+//-----------------------------------------------------------------------------
+static std::string
+generate_nested (size_t target)
+{
+    static constexpr int DEPTH = 256;
+
+    generator g (target);
+    g.raw ('[');
+
+    for (size_t i = 0; !g.done (); ++i) {
+        if (i)
+            g.raw (',');
+
+        for (int d = 0; d < DEPTH; ++d)
+            g.raw (d % 2 ? "{\"k\":" : "[");
+        g.uint (i);
+        for (int d = DEPTH - 1; d >= 0; --d)
+            g.raw (d % 2 ? '}' : ']');
+    }
+
+    g.raw (']');
+    return g.take ();
+}
+
+
+//-----------------------------------------------------------------------------
+static std::string
+generate_strings (size_t target)
+{
+    generator g (target);
+    g.raw ('{');
+
+    for (size_t i = 0; !g.done (); ++i) {
+        if (i)
+            g.raw (',');
+        g.escaped (g.next (4) + 1).raw (':').escaped (g.next (64) + 8);
+    }
+
+    g.raw ('}');
+    return g.take ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// a corpus is a list of documents that are parsed in turn. the text is only
+// materialised inside the measuring process.
+struct corpus {
+    std::string name;
+
+    // either a generator and target size, or a list of paths
+    std::string (*generate) (size_t) = nullptr;
+    size_t size = 0;
+    std::vector<std::experimental::filesystem::path> paths;
+
+    std::vector<std::string>
+    load (void) const
+    {
+        if (generate)
+            return { generate (size) };
+
+        std::vector<std::string> res;
+        for (const auto &p: paths) {
+            const util::mapped_file data (p);
+            const auto text = util::view{data}.cast<const char> ();
+            res.emplace_back (text.begin (), text.end ());
+        }
+        return res;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+static util::view<const char*>
+make_view (const std::string &str)
+{
+    return { str.data (), str.data () + str.size () };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// each parser returns a value derived from its output, which is accumulated
+// into a volatile, so the work can't be elided.
+static const struct {
+    const char *name;
+    size_t (*parse) (const std::string&);
+} PARSERS[] = {
+    { "json::flat", [] (const std::string &src) -> size_t {
+        return json::flat::parse (make_view (src)).size ();
+    } },
+    { "json::structural", [] (const std::string &src) -> size_t {
+        return json::structural::parse (make_view (src)).size ();
+    } },
+    { "json::tree", [] (const std::string &src) -> size_t {
+        return size_t (json::tree::parse (make_view (src))->type ());
+    } },
+    { "json::compact", [] (const std::string &src) -> size_t {
+        return json::compact::document (make_view (src)).bytes ();
+    } },
+    { "json2::event", [] (const std::string &src) -> size_t {
+        size_t packets = 0;
+        util::json2::event::parse (
+            [&packets] (const auto&) { ++packets; },
+            src.data (),
+            src.data () + src.size ()
+        );
+        return packets;
+    } },
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+struct result {
+    bool ok;
+    double megabytes_per_second;
+    size_t allocations;
+    size_t allocated;
+    long peak_rss;
+};
+
+
+//-----------------------------------------------------------------------------
+static result
+measure (const corpus &src, size_t (*parse) (const std::string&), std::chrono::milliseconds duration)
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto documents = src.load ();
+
+    size_t bytes = 0;
+    for (const auto &d: documents)
+        bytes += d.size ();
+
+    volatile size_t sink = 0;
+
+    // a single untimed pass warms the caches and counts the allocations
+    const auto allocations = s_allocations;
+    const auto allocated = s_allocated;
+    for (const auto &d: documents)
+        sink += parse (d);
+
+    result res {};
+    res.allocations = s_allocations - allocations;
+    res.allocated   = s_allocated   - allocated;
+
+    // each batch runs for at least its share of the duration; the median
+    // batch is reported to reject scheduling noise.
+    std::vector<double> rates;
+    for (int b = 0; b < BATCHES; ++b) {
+        size_t iterations = 0;
+        const auto start = clock::now ();
+        auto elapsed = clock::duration::zero ();
+
+        do {
+            for (const auto &d: documents)
+                sink += parse (d);
+            ++iterations;
+            elapsed = clock::now () - start;
+        } while (elapsed < duration / BATCHES);
+
+        const auto seconds = std::chrono::duration<double> (elapsed).count ();
+        rates.push_back (double (bytes) * iterations / seconds / 1024 / 1024);
+    }
+
+    std::nth_element (rates.begin (), rates.begin () + BATCHES / 2, rates.end ());
+    res.megabytes_per_second = rates[BATCHES / 2];
+
+    rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    res.peak_rss = usage.ru_maxrss;
+
+    res.ok = true;
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+// runs the measurement in a child process, returning the result through a
+// pipe. the child's address space starts out small, so its peak RSS
+// reflects only the corpus and the parser under test.
+static result
+measure_isolated (const corpus &src, size_t (*parse) (const std::string&), std::chrono::milliseconds duration)
+{
+    int fds[2];
+    if (pipe (fds))
+        throw std::runtime_error ("unable to create pipe");
+
+    const pid_t child = fork ();
+    if (child < 0)
+        throw std::runtime_error ("unable to fork");
+
+    if (child == 0) {
+        close (fds[0]);
+
+        result res {};
+        try {
+            res = measure (src, parse, duration);
+        } catch (...) {
+            res.ok = false;
+        }
+
+        const bool written = write (fds[1], &res, sizeof (res)) == sizeof (res);
+        _exit (written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close (fds[1]);
+
+    result res {};
+    const bool complete = read (fds[0], &res, sizeof (res)) == sizeof (res);
+    close (fds[0]);
+
+    int status;
+    waitpid (child, &status, 0);
+
+    if (!complete || !WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+        res.ok = false;
+
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+static corpus
+make_corpus (const std::experimental::filesystem::path &path)
+{
+    namespace fs = std::experimental::filesystem;
+
+    corpus res;
+    res.name = path.filename ().string ();
+
+    if (!fs::is_directory (path)) {
+        res.paths.push_back (path);
+        return res;
+    }
+
+    // directory iteration order is unspecified, so sort for stable output
+    for (const auto &entry: fs::directory_iterator (path))
+        if (entry.path ().extension () == ".json")
+            res.paths.push_back (entry.path ());
+    std::sort (res.paths.begin (), res.paths.end ());
+
+    if (res.name.empty ())
+        res.name = path.parent_path ().filename ().string ();
+    res.name += '/';
+    return res;
+}
+
+
+//-----------------------------------------------------------------------------
+int
+main (int argc, char **argv)
+{
+    std::chrono::milliseconds duration { 1000 };
+    size_t size = 8;
+    std::vector<corpus> corpora;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp (argv[i], "--min-ms") && i + 1 < argc) {
+            duration = std::chrono::milliseconds (std::atoi (argv[++i]));
+        } else if (!strcmp (argv[i], "--size") && i + 1 < argc) {
+            size = std::strtoul (argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            std::cerr << "usage: " << argv[0] << " [--min-ms <n>] [--size <MiB>] [path...]\n";
+            return EXIT_FAILURE;
+        } else {
+            corpora.push_back (make_corpus (argv[i]));
+        }
+    }
+
+    const corpus GENERATED[] = {
+        { "twitter",  generate_twitter,  size * 1024 * 1024, {} },
+        { "numeric",  generate_numeric,  size * 1024 * 1024, {} },
+        { "nested",   generate_nested,   size * 1024 * 1024, {} },
+        { "strings",  generate_strings,  size * 1024 * 1024, {} },
+    };
+    corpora.insert (corpora.begin (), std::cbegin (GENERATED), std::cend (GENERATED));
+
+    std::cout << std::setw (16) << std::left  << "corpus"
+              << std::setw (18) << std::left  << "parser"
+              << std::setw (10) << std::right << "MB/s"
+              << std::setw (12) << std::right << "allocs"
+              << std::setw (12) << std::right << "alloc KiB"
+              << std::setw (14) << std::right << "peak RSS KiB"
+              << '\n';
+
+    int status = EXIT_SUCCESS;
+
+    for (const auto &c: corpora) {
+        for (const auto &p: PARSERS) {
+            std::cout << std::setw (16) << std::left << c.name
+                      << std::setw (18) << std::left << p.name
+                      << std::flush;
+
+            const auto res = measure_isolated (c, p.parse, duration);
+            if (!res.ok) {
+                std::cout << "  error: parse failed\n";
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            std::cout << std::fixed << std::setprecision (1)
+                      << std::setw (10) << std::right << res.megabytes_per_second
+                      << std::setw (12) << std::right << res.allocations
+                      << std::setw (12) << std::right << (res.allocated + 1023) / 1024
+                      << std::setw (14) << std::right << res.peak_rss
+                      << '\n';
+        }
+    }
+
+    return status;
+}
@@ -15,11 +15,16 @@
  */
 
 #include "io.hpp"
+#include "job/queue.hpp"
 #include "json/except.hpp"
+#include "json/flat.hpp"
+#include "json/ndjson.hpp"
 #include "json/tree.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,7 +41,85 @@ void
 print_usage (int argc, char **argv)
 {
     (void)argc;
-    std::cerr << "usage: " << argv[0] << " <input>\n";
+    std::cerr << "usage: " << argv[0] << " [--ndjson] <input>\n";
+}
+
+
+//-----------------------------------------------------------------------------
+// the tree writer spans multiple lines so each document is instead validated
+// and then stripped of insignificant whitespace, keeping one per line.
+struct cleaned {
+    std::string text;
+    std::string error;
+};
+
+
+//-----------------------------------------------------------------------------
+static cleaned
+compact (size_t, util::view<const char*> src)
+{
+    try {
+        json::flat::parse (src);
+    } catch (const json::error &x) {
+        return { {}, x.what () };
+    }
+
+    std::string res;
+    res.reserve (src.size ());
+
+    bool string = false;
+    bool escaped = false;
+
+    for (const char c: src) {
+        if (string) {
+            if (escaped)
+                escaped = false;
+            else if (c == '\\')
+                escaped = true;
+            else if (c == '"')
+                string = false;
+        } else {
+            switch (c) {
+            case ' ': case '\t': case '\n': case '\r':
+                continue;
+            case '"':
+                string = true;
+                break;
+            }
+        }
+
+        res.push_back (c);
+    }
+
+    return { std::move (res), {} };
+}
+
+
+//-----------------------------------------------------------------------------
+static int
+clean_ndjson (const char *path)
+{
+    util::job::queue queue;
+    const util::mapped_file src (path);
+
+    int status = EXIT_SUCCESS;
+
+    json::ndjson::map<cleaned> (
+        queue,
+        util::view{src}.cast<const char> (),
+        json::ndjson::order::SEQUENTIAL,
+        compact,
+        [&] (size_t line, cleaned &&res) {
+            if (res.error.empty ()) {
+                std::cout << res.text << '\n';
+            } else {
+                std::cerr << path << ':' << line << ": " << res.error << '\n';
+                status = EXIT_FAILURE;
+            }
+        }
+    );
+
+    return status;
 }
 
 
@@ -44,6 +127,9 @@ print_usage (int argc, char **argv)
 int
 main (int argc, char **argv)
 {
+    if (argc == NUM_ARGS + 1 && !strcmp (argv[1], "--ndjson"))
+        return clean_ndjson (argv[ARG_INPUT + 1]);
+
     if (argc != NUM_ARGS) {
         print_usage (argc, argv);
         return EXIT_FAILURE;
@@ -17,10 +17,13 @@
 
 #include "json/flat.hpp"
 #include "json/except.hpp"
+#include "json/ndjson.hpp"
 #include "io.hpp"
+#include "job/queue.hpp"
 
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 
 
 enum {
@@ -31,11 +34,30 @@ enum {
 };
 
 
+// validates each line of the file as an independent document, reporting
+// every malformed line rather than stopping at the first.
+static int
+validate_ndjson (const char *path)
+{
+    util::job::queue queue;
+    const util::mapped_file data (path);
+
+    const auto failures = json::ndjson::validate (queue, data);
+    for (const auto &f: failures)
+        std::cerr << path << ':' << f.line << ": error: " << f.message << '\n';
+
+    return failures.empty () ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
 int
 main (int argc, char ** argv) {
+    if (argc == NUM_ARGS + 1 && !strcmp (argv[1], "--ndjson"))
+        return validate_ndjson (argv[ARG_PATH + 1]);
+
     if (argc != NUM_ARGS) {
         std::cerr << "Invalid arguments. "
-                  << argv[ARG_CMD] << " <path> "
+                  << argv[ARG_CMD] << " [--ndjson] <path> "
                   << std::endl;
         return EXIT_FAILURE;
     }
@@ -0,0 +1,152 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2017 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "io.hpp"
+#include "json2/event.hpp"
+#include "json2/except.hpp"
+#include "view.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compares the throughput of json2::event::parse when packets are delivered
+// through the std::function entry point against a template sink.
+//
+// usage: json2-bench <path>...
+//
+// each file is parsed repeatedly for at least MIN_DURATION with each sink,
+// and the throughput of each is printed in MB/s.
+static constexpr std::chrono::milliseconds MIN_DURATION { 250 };
+
+
+//-----------------------------------------------------------------------------
+struct result {
+    double megabytes_per_second;
+    size_t packets;
+};
+
+
+//-----------------------------------------------------------------------------
+template <typename FunctionT>
+static result
+measure (const char *first, const char *last, FunctionT &&parse)
+{
+    using clock = std::chrono::steady_clock;
+
+    size_t packets = 0;
+    size_t iterations = 0;
+
+    const auto start = clock::now ();
+    auto elapsed = clock::duration::zero ();
+
+    // small inputs are run in batches so the clock doesn't dominate
+    do {
+        for (int i = 0; i < 64; ++i) {
+            packets = 0;
+            parse (packets, first, last);
+        }
+
+        iterations += 64;
+        elapsed = clock::now () - start;
+    } while (elapsed < MIN_DURATION);
+
+    const auto seconds = std::chrono::duration<double> (elapsed).count ();
+    const auto bytes = double (last - first) * iterations;
+
+    return { bytes / seconds / 1024 / 1024, packets };
+}
+
+
+//-----------------------------------------------------------------------------
+static void
+dynamic_sink (size_t &packets, const char *first, const char *last)
+{
+    const std::function<util::json2::callback_t> cb = [&packets] (const auto&) {
+        ++packets;
+    };
+
+    util::json2::event::parse (cb, first, last);
+}
+
+
+//-----------------------------------------------------------------------------
+static void
+template_sink (size_t &packets, const char *first, const char *last)
+{
+    util::json2::event::parse (
+        [&packets] (const auto&) { ++packets; },
+        first,
+        last
+    );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+int
+main (int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <path>...\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::setw (40) << std::left << "file"
+              << std::setw (14) << std::right << "function MB/s"
+              << std::setw (14) << std::right << "template MB/s"
+              << std::setw (10) << std::right << "ratio"
+              << '\n';
+
+    int status = EXIT_SUCCESS;
+
+    for (int i = 1; i < argc; ++i) {
+        const util::mapped_file data (argv[i]);
+        const auto text = util::view{data}.cast<const char> ();
+        const char *first = text.begin ();
+        const char *last  = text.end ();
+
+        std::cout << std::setw (40) << std::left << argv[i];
+
+        try {
+            const auto dynamic = measure (first, last, dynamic_sink);
+            const auto inlined = measure (first, last, template_sink);
+
+            if (dynamic.packets != inlined.packets)
+                throw std::runtime_error ("packet counts differ");
+
+            std::cout << std::fixed << std::setprecision (1)
+                      << std::setw (14) << std::right << dynamic.megabytes_per_second
+                      << std::setw (14) << std::right << inlined.megabytes_per_second
+                      << std::setprecision (2)
+                      << std::setw (10) << std::right
+                      << inlined.megabytes_per_second / dynamic.megabytes_per_second
+                      << '\n';
+        } catch (const util::json2::error&) {
+            std::cout << "  error: parse failed\n";
+            status = EXIT_FAILURE;
+        } catch (const std::exception &x) {
+            std::cout << "  error: " << x.what () << '\n';
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,67 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2018 Danny Robson <danny@nerdcruft.net>
+ */
+
+#include "log/binary.hpp"
+#include "io.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+
+enum {
+    ARG_CMD,
+    ARG_PATH,
+
+    NUM_ARGS
+};
+
+
+// writes the text of a binary log to stdout.
+//
+// the file is read twice; definitions are gathered first because a site's
+// definition may follow its first messages when several threads logged
+// concurrently.
+int
+main (int argc, char **argv)
+{
+    if (argc != NUM_ARGS) {
+        std::cerr << "Invalid arguments. "
+                  << argv[ARG_CMD] << " <path> "
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const util::mapped_file data (argv[ARG_PATH]);
+        const std::string_view src (
+            reinterpret_cast<const char*> (data.data ()), data.size ()
+        );
+
+        util::logging::binary::decoder decoder;
+        decoder.define (src);
+
+        std::string text;
+        decoder.decode (src, text);
+        std::cout << text;
+    } catch (const std::exception &x) {
+        std::cerr << "error: " << x.what () << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -16,6 +16,14 @@
 
 #include "./utf8.hpp"
 
+#include "./iterator.hpp"
+
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 
 ///////////////////////////////////////////////////////////////////////////////
 template <typename T>
@@ -73,6 +81,80 @@ operator"" _test (const char *str, size_t len)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// writes a codepoint to the output, splitting it into a surrogate pair if
+// the output is UTF-16.
+template <typename OutputT>
+static void
+emit (OutputT &dst, util::utf8::codepoint_t c)
+{
+    *dst++ = c;
+}
+
+
+//-----------------------------------------------------------------------------
+static void
+emit (char16_t *&dst, util::utf8::codepoint_t c)
+{
+    if (c < 0x10000) {
+        *dst++ = static_cast<char16_t> (c);
+        return;
+    }
+
+    if (c > 0x10FFFF)
+        throw util::utf8::illegal_codepoint {};
+
+    c -= 0x10000;
+    *dst++ = static_cast<char16_t> (0xD800 + (c >> 10));
+    *dst++ = static_cast<char16_t> (0xDC00 + (c & 0x3FF));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copies the longest run of whole 16 byte ASCII blocks from the front of the
+// input, widening each byte to the output's code unit. returns the number of
+// bytes consumed.
+#if defined(__SSE2__)
+template <typename OutputT>
+static size_t
+widen_ascii (const std::byte *src, size_t len, OutputT *dst)
+{
+    static_assert (sizeof (OutputT) == 2 || sizeof (OutputT) == 4);
+
+    const __m128i zero = _mm_setzero_si128 ();
+    size_t done = 0;
+
+    for (; len - done >= 16; done += 16, dst += 16) {
+        const __m128i in = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+        if (_mm_movemask_epi8 (in))
+            break;
+
+        const __m128i lo = _mm_unpacklo_epi8 (in, zero);
+        const __m128i hi = _mm_unpackhi_epi8 (in, zero);
+
+        if constexpr (sizeof (OutputT) == 2) {
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst + 0), lo);
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst + 8), hi);
+        } else {
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst +  0), _mm_unpacklo_epi16 (lo, zero));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst +  4), _mm_unpackhi_epi16 (lo, zero));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst +  8), _mm_unpacklo_epi16 (hi, zero));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst + 12), _mm_unpackhi_epi16 (hi, zero));
+        }
+    }
+
+    return done;
+}
+#else
+template <typename OutputT>
+static size_t
+widen_ascii (const std::byte*, size_t, OutputT*)
+{
+    return 0;
+}
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////////
 template <
     typename InputT,
@@ -91,6 +173,16 @@ decode (util::view<InputT> src, OutputT dst)
     };
 
     for (auto cursor = src.cbegin (); cursor != src.cend (); ) {
+        // skip through runs of ASCII when we can write the output directly
+        if constexpr (std::is_pointer_v<OutputT>) {
+            auto done = widen_ascii (cursor, src.cend () - cursor, dst);
+            cursor += done;
+            dst    += done;
+
+            if (cursor == src.cend ())
+                break;
+        }
+
         codepoint_t c = std::to_integer<codepoint_t> (*cursor++);
 
         int len = PREFIX[0].valid (c) ? 0 :
@@ -101,7 +193,7 @@ decode (util::view<InputT> src, OutputT dst)
 
         // get the simple ANSI case out of the way
         if (!len) {
-            *dst++ = c;
+            emit (dst, c);
             continue;
         }
 
@@ -145,7 +237,7 @@ decode (util::view<InputT> src, OutputT dst)
         if (accum == 0xfffe || accum == 0xffff)
             throw illegal_codepoint {};
 
-        *dst++ = accum;
+        emit (dst, accum);
     }
 
 
@@ -153,13 +245,336 @@ decode (util::view<InputT> src, OutputT dst)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Validation after Keiser and Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte".
+//
+// Each byte is classified by three table lookups: the high and low nibbles
+// of the previous byte, and the high nibble of the current byte. The AND of
+// the results has a bit set for each error class the byte pair belongs to.
+// Continuations required by 3 and 4 byte sequences are checked separately
+// against the bytes two and three back.
+//
+// The tables are adjusted to accept exactly what the scalar decoder does:
+// codepoints up to 0x1FFFFF are permitted (ie, leads up to 0xF7), and the
+// noncharacters U+FFFE and U+FFFF are rejected with an additional test.
+namespace {
+    namespace bits {
+        constexpr uint8_t TOO_SHORT  = 1 << 0; // 11______ 0_______ / 11______ 11______
+        constexpr uint8_t TOO_LONG   = 1 << 1; // 0_______ 10______
+        constexpr uint8_t OVERLONG_3 = 1 << 2; // 11100000 100_____
+        constexpr uint8_t TOO_LARGE  = 1 << 3; // 11111___ 10______
+        constexpr uint8_t SURROGATE  = 1 << 4; // 11101101 101_____
+        constexpr uint8_t OVERLONG_2 = 1 << 5; // 1100000_ 10______
+        constexpr uint8_t OVERLONG_4 = 1 << 6; // 11110000 1000____
+        constexpr uint8_t TWO_CONTS  = 1 << 7; // 10______ 10______
+
+        constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+    }
+
+
+#if defined(__x86_64__) || defined(__i386__)
+    //-------------------------------------------------------------------------
+    struct validator_ssse3 {
+        __m128i error = _mm_setzero_si128 ();
+        __m128i prev_input = _mm_setzero_si128 ();
+        __m128i prev_incomplete = _mm_setzero_si128 ();
+
+
+        //---------------------------------------------------------------------
+        [[gnu::target("ssse3")]]
+        static __m128i
+        high_nibbles (__m128i val)
+        {
+            return _mm_and_si128 (_mm_srli_epi16 (val, 4), _mm_set1_epi8 (0x0F));
+        }
+
+
+        //---------------------------------------------------------------------
+        [[gnu::target("ssse3")]]
+        static __m128i
+        special_cases (__m128i input, __m128i prev1)
+        {
+            using namespace bits;
+
+            const __m128i byte_1_high = _mm_shuffle_epi8 (_mm_setr_epi8 (
+                // 0_______ ________ <ASCII in byte 1>
+                TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                // 10______ ________ <continuation in byte 1>
+                TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                // 1100____ ________ <two byte lead in byte 1>
+                TOO_SHORT | OVERLONG_2,
+                // 1101____ ________ <two byte lead in byte 1>
+                TOO_SHORT,
+                // 1110____ ________ <three byte lead in byte 1>
+                TOO_SHORT | OVERLONG_3 | SURROGATE,
+                // 1111____ ________ <four+ byte lead in byte 1>
+                int8_t (TOO_SHORT | TOO_LARGE | OVERLONG_4)
+            ), high_nibbles (prev1));
+
+            const __m128i byte_1_low = _mm_shuffle_epi8 (_mm_setr_epi8 (
+                // ____0000 ________
+                int8_t (CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+                // ____0001 ________
+                int8_t (CARRY | OVERLONG_2),
+                // ____001_ ________
+                int8_t (CARRY),
+                int8_t (CARRY),
+                // ____01__ ________
+                int8_t (CARRY),
+                int8_t (CARRY),
+                int8_t (CARRY),
+                int8_t (CARRY),
+                // ____1___ ________
+                int8_t (CARRY | TOO_LARGE),
+                int8_t (CARRY | TOO_LARGE),
+                int8_t (CARRY | TOO_LARGE),
+                int8_t (CARRY | TOO_LARGE),
+                int8_t (CARRY | TOO_LARGE),
+                // ____1101 ________
+                int8_t (CARRY | TOO_LARGE | SURROGATE),
+                int8_t (CARRY | TOO_LARGE),
+                int8_t (CARRY | TOO_LARGE)
+            ), _mm_and_si128 (prev1, _mm_set1_epi8 (0x0F)));
+
+            const __m128i byte_2_high = _mm_shuffle_epi8 (_mm_setr_epi8 (
+                // ________ 0_______ <ASCII in byte 2>
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                // ________ 1000____
+                int8_t (TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE | OVERLONG_4),
+                // ________ 1001____
+                int8_t (TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+                // ________ 101_____
+                int8_t (TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE),
+                int8_t (TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE),
+                // ________ 11______
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+            ), high_nibbles (input));
+
+            return _mm_and_si128 (_mm_and_si128 (byte_1_high, byte_1_low), byte_2_high);
+        }
+
+
+        //---------------------------------------------------------------------
+        [[gnu::target("ssse3")]]
+        void
+        check_block (__m128i input)
+        {
+            // a block of pure ASCII can only be in error if the previous
+            // block ended part way through a sequence.
+            if (!_mm_movemask_epi8 (input)) {
+                error = _mm_or_si128 (error, prev_incomplete);
+                prev_input = input;
+                prev_incomplete = _mm_setzero_si128 ();
+                return;
+            }
+
+            const __m128i prev1 = _mm_alignr_epi8 (input, prev_input, 15);
+            const __m128i prev2 = _mm_alignr_epi8 (input, prev_input, 14);
+            const __m128i prev3 = _mm_alignr_epi8 (input, prev_input, 13);
+
+            const __m128i sc = special_cases (input, prev1);
+
+            // third and fourth bytes of multibyte sequences must be
+            // continuations, which is signalled by the TWO_CONTS bit.
+            const __m128i is_third  = _mm_subs_epu8 (prev2, _mm_set1_epi8 (char (0xE0 - 0x80)));
+            const __m128i is_fourth = _mm_subs_epu8 (prev3, _mm_set1_epi8 (char (0xF0 - 0x80)));
+            const __m128i must_23 = _mm_and_si128 (
+                _mm_or_si128 (is_third, is_fourth),
+                _mm_set1_epi8 (char (0x80))
+            );
+
+            error = _mm_or_si128 (error, _mm_xor_si128 (must_23, sc));
+
+            // the noncharacters U+FFFE and U+FFFF, ie EF BF BE and EF BF BF
+            const __m128i nonchar = _mm_and_si128 (
+                _mm_and_si128 (
+                    _mm_cmpeq_epi8 (prev2, _mm_set1_epi8 (char (0xEF))),
+                    _mm_cmpeq_epi8 (prev1, _mm_set1_epi8 (char (0xBF)))
+                ),
+                _mm_cmpeq_epi8 (
+                    _mm_or_si128 (input, _mm_set1_epi8 (0x01)),
+                    _mm_set1_epi8 (char (0xBF))
+                )
+            );
+
+            error = _mm_or_si128 (error, nonchar);
+
+            // flag any multibyte leads that run past the end of the block
+            prev_incomplete = _mm_subs_epu8 (input, _mm_setr_epi8 (
+                -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, char (0xF0 - 1), char (0xE0 - 1), char (0xC0 - 1)
+            ));
+
+            prev_input = input;
+        }
+
+
+        //---------------------------------------------------------------------
+        [[gnu::target("ssse3")]]
+        bool
+        clean (void) const
+        {
+            return _mm_movemask_epi8 (_mm_cmpeq_epi8 (error, _mm_setzero_si128 ())) == 0xFFFF;
+        }
+
+
+        //---------------------------------------------------------------------
+        [[gnu::target("ssse3")]]
+        bool
+        finish (void)
+        {
+            error = _mm_or_si128 (error, prev_incomplete);
+            return clean ();
+        }
+    };
+
+
+    //-------------------------------------------------------------------------
+    [[gnu::target("ssse3")]]
+    bool
+    validate_ssse3 (const std::byte *src, size_t len)
+    {
+        validator_ssse3 v;
+        size_t done = 0;
+
+        for (; len - done >= 16; done += 16) {
+            v.check_block (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done)));
+
+            // bail early on errors in large inputs
+            if (done % 4096 == 0 && !v.clean ())
+                return false;
+        }
+
+        // pad the tail with ASCII so any truncated sequence is an error
+        if (done != len) {
+            alignas (16) std::byte tail[16] {};
+            std::copy (src + done, src + len, tail);
+            v.check_block (_mm_load_si128 (reinterpret_cast<const __m128i*> (tail)));
+        }
+
+        return v.finish ();
+    }
+#endif
+
+
+    //-------------------------------------------------------------------------
+    bool
+    validate_scalar (const std::byte *src, size_t len)
+    {
+        try {
+            ::decode (util::view { src, src + len }, util::discard_iterator {});
+            return true;
+        } catch (const util::utf8::error&) {
+            return false;
+        }
+    }
+
+
+    //-------------------------------------------------------------------------
+    // counts the bytes that aren't continuations, ie the codepoints of
+    // valid input, and the leads of four byte sequences which require a
+    // surrogate pair in UTF-16.
+    struct counts {
+        size_t leads = 0;
+        size_t quads = 0;
+    };
+
+
+    counts
+    count_leads (const std::byte *src, size_t len)
+    {
+        counts res;
+        size_t done = 0;
+
+#if defined(__SSE2__)
+        for (; len - done >= 16; done += 16) {
+            const __m128i in = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + done));
+
+            // continuations are the only bytes in [0x80, 0xC0) which, as
+            // signed values, are those less than or equal to 0xBF.
+            const auto leads = _mm_movemask_epi8 (_mm_cmpgt_epi8 (in, _mm_set1_epi8 (char (0xBF))));
+            const auto quads = _mm_movemask_epi8 (_mm_cmpeq_epi8 (
+                _mm_and_si128 (in, _mm_set1_epi8 (char (0xF0))),
+                _mm_set1_epi8 (char (0xF0))
+            ));
+
+            res.leads += __builtin_popcount (leads);
+            res.quads += __builtin_popcount (quads);
+        }
+#endif
+
+        for (; done != len; ++done) {
+            const auto c = std::to_integer<uint8_t> (src[done]);
+            res.leads += (c & 0xC0) != 0x80;
+            res.quads += (c & 0xF0) == 0xF0;
+        }
+
+        return res;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+bool
+util::utf8::validate (view<const std::byte*> src) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool s_ssse3 = __builtin_cpu_supports ("ssse3");
+    if (s_ssse3)
+        return validate_ssse3 (src.data (), src.size ());
+#endif
+
+    return validate_scalar (src.data (), src.size ());
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+util::utf8::count (view<const std::byte*> src)
+{
+    if (!validate (src))
+        throw malformed_error {};
+
+    return count_leads (src.data (), src.size ()).leads;
+}
+
+
+//-----------------------------------------------------------------------------
+size_t
+util::utf8::count_utf16 (view<const std::byte*> src)
+{
+    if (!validate (src))
+        throw malformed_error {};
+
+    const auto res = count_leads (src.data (), src.size ());
+    return res.leads + res.quads;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 std::vector<util::utf8::codepoint_t>
 util::utf8::decode (view<const std::byte*> src)
 {
-    std::vector<codepoint_t> dst;
-    dst.reserve (src.size ());
-
-    ::decode (src, std::back_inserter (dst));
+    std::vector<codepoint_t> dst (src.size ());
+    dst.resize (decode (src, dst.data ()) - dst.data ());
     return dst;
+}
+
+
+//-----------------------------------------------------------------------------
+util::utf8::codepoint_t*
+util::utf8::decode (view<const std::byte*> src, codepoint_t *dst)
+{
+    return ::decode (src, dst);
+}
+
+
+//-----------------------------------------------------------------------------
+char16_t*
+util::utf8::decode (view<const std::byte*> src, char16_t *dst)
+{
+    return ::decode (src, dst);
 }
\ No newline at end of file
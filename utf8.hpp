@@ -55,6 +55,71 @@ namespace util::utf8 {
     }
 
 
+    ///////////////////////////////////////////////////////////////////////////
+    /// decodes into a caller supplied buffer rather than allocating. the
+    /// buffer must have room for `count (src)` codepoints, or `src.size ()`
+    /// if the input hasn't been counted. returns the end of the written
+    /// codepoints.
+    ///
+    /// throws the same errors as the vector returning decode.
+    codepoint_t*
+    decode (util::view<const std::byte*> src, codepoint_t *dst);
+
+
+    //-------------------------------------------------------------------------
+    /// transcodes into UTF-16 in a caller supplied buffer. the buffer must
+    /// have room for `count_utf16 (src)` code units, or `src.size ()` if the
+    /// input hasn't been counted. returns the end of the written code units.
+    ///
+    /// throws illegal_codepoint for codepoints that can't be represented
+    /// in UTF-16, in addition to the errors of decode.
+    char16_t*
+    decode (util::view<const std::byte*> src, char16_t *dst);
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// checks whether the data would decode successfully without
+    /// producing any output. uses vectorised validation where the host
+    /// supports it.
+    bool validate (util::view<const std::byte*>) noexcept;
+
+
+    //-------------------------------------------------------------------------
+    inline bool
+    validate (util::view<const char*> data) noexcept
+    {
+        return validate ({
+            reinterpret_cast<const std::byte*> (data.cbegin ()),
+            reinterpret_cast<const std::byte*> (data.cend   ())
+        });
+    }
+
+
+    //-------------------------------------------------------------------------
+    inline bool
+    validate (util::view<const uint8_t*> data) noexcept
+    {
+        return validate ({
+            reinterpret_cast<const std::byte*> (data.cbegin ()),
+            reinterpret_cast<const std::byte*> (data.cend   ())
+        });
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// returns the number of codepoints the data decodes to.
+    ///
+    /// throws malformed_error if the data does not validate.
+    size_t count (util::view<const std::byte*>);
+
+
+    //-------------------------------------------------------------------------
+    /// returns the number of UTF-16 code units the data transcodes to.
+    ///
+    /// throws malformed_error if the data does not validate.
+    size_t count_utf16 (util::view<const std::byte*>);
+
+
     ///////////////////////////////////////////////////////////////////////////
     std::vector<std::byte>
     encode (util::view<const char*>);
@@ -212,7 +212,7 @@ namespace util {
 
 
         //---------------------------------------------------------------------
-        view&
+        constexpr view&
         operator= (const view &rhs) noexcept
         {
             m_begin = rhs.m_begin;
@@ -222,7 +222,7 @@ namespace util {
 
 
         //---------------------------------------------------------------------
-        view&
+        constexpr view&
         operator= (view &&rhs) noexcept
         {
             m_begin = rhs.m_begin;